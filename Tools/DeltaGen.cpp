@@ -0,0 +1,510 @@
+/**
+ * @file DeltaGen.cpp
+ * @brief Command-line tool that builds delta patches for the updater
+ *
+ * @author myexistences
+ * @copyright Copyright (c) 2025 myexistences. All rights reserved.
+ * @license MIT License
+ *
+ * @description
+ * Diffs an old and a new executable into an AUPATCH1 patch (see
+ * Updater/Patch.h) and prints the matching "Patches" manifest entry. The
+ * matcher is bsdiff's: a suffix array of the old file finds long approximate
+ * matches, which become copy-and-add records. The suffix array is built by
+ * prefix doubling where every refinement round sorts independent groups on
+ * worker threads, and very large groups are themselves sorted in parallel.
+ * The patch is applied back to the old file and verified before it is kept.
+ *
+ * @usage
+ * ```
+ * DeltaGen <old.exe> <new.exe> <out.patch> [--from 1.0] [--to 1.1] [--link URL] [--threads N]
+ * ```
+ *
+ * @build
+ * ```
+ * cl /O2 /EHsc /std:c++14 Tools\DeltaGen.cpp
+ * g++ -O2 -std=c++11 -pthread Tools/DeltaGen.cpp -o DeltaGen
+ * ```
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../Updater/json.hpp"
+#include "../Updater/Blake3.h"
+#include "../Updater/Patch.h"
+
+namespace {
+
+/**
+ * @class SuffixArray
+ * @brief Parallel prefix-doubling suffix array construction
+ *
+ * Suffixes start in groups of equal first byte. Each round sorts every
+ * unfinished group by the rank of the suffix h bytes further on, which
+ * orders the group by its first 2h bytes. Rounds read ranks in one pass and
+ * write refined ranks in a second, so groups never observe each other's
+ * updates and can be processed by any thread.
+ */
+class SuffixArray {
+private:
+    // Groups at least this large are sorted by all threads together
+    static constexpr size_t PARALLEL_GROUP = 1 << 16;
+
+    struct Group {
+        uint32_t start;
+        uint32_t length;
+    };
+
+    const uint8_t* m_data;
+    uint32_t m_size;
+    unsigned m_threads;
+    std::vector<int32_t> m_sa;
+    std::vector<uint32_t> m_rank;
+    std::vector<uint64_t> m_keys; // (key << 32) | suffix, aligned with m_sa
+
+    template <typename Fn>
+    void parallelFor(size_t count, Fn fn) const {
+        std::atomic<size_t> next(0);
+        auto worker = [&]() {
+            for (size_t i = next++; i < count; i = next++) {
+                fn(i);
+            }
+        };
+        std::vector<std::thread> pool;
+        for (unsigned t = 1; t < m_threads && t < count; ++t) {
+            pool.emplace_back(worker);
+        }
+        worker();
+        for (auto& thread : pool) {
+            thread.join();
+        }
+    }
+
+    /**
+     * @brief Sorts a large range by splitting it across threads and merging
+     */
+    void parallelSort(uint64_t* first, uint64_t* last) const {
+        const size_t count = static_cast<size_t>(last - first);
+        const size_t parts = std::max<size_t>(1, std::min<size_t>(m_threads, count / 4096));
+        std::vector<size_t> bounds;
+        for (size_t p = 0; p <= parts; ++p) {
+            bounds.push_back(count * p / parts);
+        }
+
+        parallelFor(parts, [&](size_t p) {
+            std::sort(first + bounds[p], first + bounds[p + 1]);
+        });
+
+        // Merge neighbouring runs pairwise until one run remains
+        for (size_t width = 1; width < parts; width *= 2) {
+            const size_t merges = (parts + 2 * width - 1) / (2 * width);
+            parallelFor(merges, [&](size_t m) {
+                const size_t lo = m * 2 * width;
+                const size_t mid = std::min(lo + width, parts);
+                const size_t hi = std::min(lo + 2 * width, parts);
+                if (mid < hi) {
+                    std::inplace_merge(first + bounds[lo], first + bounds[mid], first + bounds[hi]);
+                }
+            });
+        }
+    }
+
+    uint64_t keyOf(uint32_t suffix, uint32_t h) const {
+        const uint64_t key = suffix + h < m_size ? static_cast<uint64_t>(m_rank[suffix + h]) + 1 : 0;
+        return (key << 32) | suffix;
+    }
+
+    void sortGroup(const Group& group, uint32_t h, bool parallel) {
+        uint64_t* keys = m_keys.data() + group.start;
+        for (uint32_t i = 0; i < group.length; ++i) {
+            keys[i] = keyOf(static_cast<uint32_t>(m_sa[group.start + i]), h);
+        }
+        if (parallel) {
+            parallelSort(keys, keys + group.length);
+        } else {
+            std::sort(keys, keys + group.length);
+        }
+        for (uint32_t i = 0; i < group.length; ++i) {
+            m_sa[group.start + i] = static_cast<int32_t>(keys[i] & 0xFFFFFFFFu);
+        }
+    }
+
+    /**
+     * @brief Splits a sorted group into subgroups of equal key and re-ranks them
+     */
+    void refineGroup(const Group& group, std::vector<Group>& unsorted) {
+        const uint64_t* keys = m_keys.data() + group.start;
+        uint32_t runStart = 0;
+        for (uint32_t i = 1; i <= group.length; ++i) {
+            if (i < group.length && (keys[i] >> 32) == (keys[runStart] >> 32)) {
+                continue;
+            }
+            const uint32_t rank = group.start + runStart;
+            for (uint32_t j = runStart; j < i; ++j) {
+                m_rank[static_cast<uint32_t>(m_sa[group.start + j])] = rank;
+            }
+            if (i - runStart > 1) {
+                unsorted.push_back(Group{rank, i - runStart});
+            }
+            runStart = i;
+        }
+    }
+
+public:
+    SuffixArray(const uint8_t* data, uint32_t size, unsigned threads)
+        : m_data(data), m_size(size), m_threads(threads ? threads : 1) {}
+
+    /**
+     * @brief Builds the suffix array
+     * @return Suffix start offsets in lexicographic order
+     */
+    const std::vector<int32_t>& build() {
+        m_sa.resize(m_size);
+        m_rank.resize(m_size);
+        m_keys.resize(m_size);
+
+        // Round zero: counting sort on the first byte
+        size_t bucketStart[257] = {0};
+        for (uint32_t i = 0; i < m_size; ++i) {
+            ++bucketStart[m_data[i] + 1];
+        }
+        for (size_t b = 1; b < 257; ++b) {
+            bucketStart[b] += bucketStart[b - 1];
+        }
+        std::vector<size_t> fill(bucketStart, bucketStart + 256);
+        for (uint32_t i = 0; i < m_size; ++i) {
+            m_sa[fill[m_data[i]]++] = static_cast<int32_t>(i);
+            m_rank[i] = static_cast<uint32_t>(bucketStart[m_data[i]]);
+        }
+
+        std::vector<Group> unsorted;
+        for (size_t b = 0; b < 256; ++b) {
+            const size_t length = bucketStart[b + 1] - bucketStart[b];
+            if (length > 1) {
+                unsorted.push_back(Group{static_cast<uint32_t>(bucketStart[b]), static_cast<uint32_t>(length)});
+            }
+        }
+
+        for (uint32_t h = 1; !unsorted.empty(); h = h > m_size / 2 ? m_size : h * 2) {
+            // Phase one: sort each group by the rank h bytes ahead (ranks are only read)
+            std::vector<Group> small;
+            for (const auto& group : unsorted) {
+                if (group.length >= PARALLEL_GROUP && m_threads > 1) {
+                    sortGroup(group, h, true);
+                } else {
+                    small.push_back(group);
+                }
+            }
+            parallelFor(small.size(), [&](size_t i) {
+                sortGroup(small[i], h, false);
+            });
+
+            // Phase two: assign refined ranks (each group writes only its own suffixes)
+            std::vector<std::vector<Group>> refined(unsorted.size());
+            parallelFor(unsorted.size(), [&](size_t i) {
+                refineGroup(unsorted[i], refined[i]);
+            });
+
+            unsorted.clear();
+            for (const auto& groups : refined) {
+                unsorted.insert(unsorted.end(), groups.begin(), groups.end());
+            }
+        }
+
+        m_keys.clear();
+        m_keys.shrink_to_fit();
+        return m_sa;
+    }
+};
+
+/**
+ * @class DeltaGenerator
+ * @brief bsdiff-style matcher that emits AUPATCH1 records
+ */
+class DeltaGenerator {
+private:
+    const std::vector<uint8_t>& m_old;
+    const std::vector<uint8_t>& m_new;
+    const std::vector<int32_t>& m_sa;
+
+    static int64_t matchLength(const uint8_t* a, int64_t aLen, const uint8_t* b, int64_t bLen) {
+        int64_t i = 0;
+        while (i < aLen && i < bLen && a[i] == b[i]) {
+            ++i;
+        }
+        return i;
+    }
+
+    /**
+     * @brief Binary-searches the suffix array for the longest match of new[scan..]
+     */
+    int64_t search(int64_t scan, int64_t& pos) const {
+        const int64_t oldSize = static_cast<int64_t>(m_old.size());
+        const int64_t newSize = static_cast<int64_t>(m_new.size());
+        const uint8_t* target = m_new.data() + scan;
+        const int64_t targetLen = newSize - scan;
+
+        int64_t lo = 0;
+        int64_t hi = oldSize - 1;
+        while (hi - lo >= 2) {
+            const int64_t mid = lo + (hi - lo) / 2;
+            const int64_t suffix = m_sa[static_cast<size_t>(mid)];
+            const size_t cmpLen = static_cast<size_t>(std::min(oldSize - suffix, targetLen));
+            if (std::memcmp(m_old.data() + suffix, target, cmpLen) < 0) {
+                lo = mid;
+            } else {
+                hi = mid;
+            }
+        }
+
+        const int64_t loSuffix = m_sa[static_cast<size_t>(lo)];
+        const int64_t hiSuffix = m_sa[static_cast<size_t>(hi)];
+        const int64_t loLen = matchLength(m_old.data() + loSuffix, oldSize - loSuffix, target, targetLen);
+        const int64_t hiLen = matchLength(m_old.data() + hiSuffix, oldSize - hiSuffix, target, targetLen);
+        if (loLen > hiLen) {
+            pos = loSuffix;
+            return loLen;
+        }
+        pos = hiSuffix;
+        return hiLen;
+    }
+
+public:
+    DeltaGenerator(const std::vector<uint8_t>& oldData, const std::vector<uint8_t>& newData,
+                   const std::vector<int32_t>& suffixArray)
+        : m_old(oldData), m_new(newData), m_sa(suffixArray) {}
+
+    /**
+     * @brief Writes the complete patch
+     * @param writer Destination patch writer
+     */
+    void generate(AutoUpdaterLib::PatchWriter& writer) const {
+        const int64_t oldSize = static_cast<int64_t>(m_old.size());
+        const int64_t newSize = static_cast<int64_t>(m_new.size());
+        const uint8_t* oldData = m_old.data();
+        const uint8_t* newData = m_new.data();
+
+        writer.begin(static_cast<uint64_t>(oldSize), static_cast<uint64_t>(newSize));
+        if (oldSize == 0) {
+            writer.addRecord(nullptr, 0, newData, static_cast<size_t>(newSize), 0);
+            return;
+        }
+
+        std::vector<uint8_t> diff;
+        int64_t scan = 0, len = 0, pos = 0;
+        int64_t lastScan = 0, lastPos = 0, lastOffset = 0;
+
+        while (scan < newSize) {
+            int64_t oldScore = 0;
+            int64_t scsc = scan += len;
+
+            // Advance until a match clearly better than continuing the previous alignment
+            for (; scan < newSize; ++scan) {
+                len = search(scan, pos);
+                for (; scsc < scan + len; ++scsc) {
+                    if (scsc + lastOffset < oldSize && oldData[scsc + lastOffset] == newData[scsc]) {
+                        ++oldScore;
+                    }
+                }
+                if ((len == oldScore && len != 0) || len > oldScore + 8) {
+                    break;
+                }
+                if (scan + lastOffset < oldSize && oldData[scan + lastOffset] == newData[scan]) {
+                    --oldScore;
+                }
+            }
+
+            if (len == oldScore && scan != newSize) {
+                continue;
+            }
+
+            // Extend the previous match forwards and the new match backwards
+            int64_t score = 0, bestForward = 0, lenForward = 0;
+            for (int64_t i = 0; lastScan + i < scan && lastPos + i < oldSize;) {
+                if (oldData[lastPos + i] == newData[lastScan + i]) ++score;
+                ++i;
+                if (score * 2 - i > bestForward * 2 - lenForward) {
+                    bestForward = score;
+                    lenForward = i;
+                }
+            }
+
+            int64_t lenBack = 0;
+            if (scan < newSize) {
+                int64_t bestBack = 0;
+                score = 0;
+                for (int64_t i = 1; scan >= lastScan + i && pos >= i; ++i) {
+                    if (oldData[pos - i] == newData[scan - i]) ++score;
+                    if (score * 2 - i > bestBack * 2 - lenBack) {
+                        bestBack = score;
+                        lenBack = i;
+                    }
+                }
+            }
+
+            // Resolve overlap between the two extensions
+            if (lastScan + lenForward > scan - lenBack) {
+                const int64_t overlap = (lastScan + lenForward) - (scan - lenBack);
+                int64_t bestSplit = 0, lenSplit = 0;
+                score = 0;
+                for (int64_t i = 0; i < overlap; ++i) {
+                    if (newData[lastScan + lenForward - overlap + i] == oldData[lastPos + lenForward - overlap + i]) ++score;
+                    if (newData[scan - lenBack + i] == oldData[pos - lenBack + i]) --score;
+                    if (score > bestSplit) {
+                        bestSplit = score;
+                        lenSplit = i + 1;
+                    }
+                }
+                lenForward += lenSplit - overlap;
+                lenBack -= lenSplit;
+            }
+
+            diff.resize(static_cast<size_t>(lenForward));
+            for (int64_t i = 0; i < lenForward; ++i) {
+                diff[static_cast<size_t>(i)] = static_cast<uint8_t>(newData[lastScan + i] - oldData[lastPos + i]);
+            }
+            const int64_t extraLen = (scan - lenBack) - (lastScan + lenForward);
+            writer.addRecord(diff.data(), diff.size(), newData + lastScan + lenForward,
+                             static_cast<size_t>(extraLen), (pos - lenBack) - (lastPos + lenForward));
+
+            lastScan = scan - lenBack;
+            lastPos = pos - lenBack;
+            lastOffset = pos - scan;
+        }
+    }
+};
+
+bool readWholeFile(const std::string& path, std::vector<uint8_t>& data) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        return false;
+    }
+    data.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    return static_cast<size_t>(file.gcount()) == data.size();
+}
+
+void logError(const std::string& message) {
+    std::cerr << "[DeltaGen Error] " << message << std::endl;
+}
+
+void logInfo(const std::string& message) {
+    std::cerr << "[DeltaGen] " << message << std::endl;
+}
+
+void printUsage() {
+    std::cerr << "Usage: DeltaGen <old> <new> <out.patch> [--from VERSION] [--to VERSION] [--link URL] [--threads N]\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 4) {
+        printUsage();
+        return 2;
+    }
+
+    const std::string oldPath = argv[1];
+    const std::string newPath = argv[2];
+    const std::string patchPath = argv[3];
+    std::string fromVersion;
+    std::string toVersion;
+    std::string link;
+    unsigned threads = std::thread::hardware_concurrency();
+
+    for (int i = 4; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            printUsage();
+            return 2;
+        }
+        if (arg == "--from") {
+            fromVersion = argv[++i];
+        } else if (arg == "--to") {
+            toVersion = argv[++i];
+        } else if (arg == "--link") {
+            link = argv[++i];
+        } else if (arg == "--threads") {
+            threads = static_cast<unsigned>(std::stoul(argv[++i]));
+        } else {
+            printUsage();
+            return 2;
+        }
+    }
+
+    std::vector<uint8_t> oldData;
+    std::vector<uint8_t> newData;
+    if (!readWholeFile(oldPath, oldData)) {
+        logError("Failed to read " + oldPath);
+        return 1;
+    }
+    if (!readWholeFile(newPath, newData)) {
+        logError("Failed to read " + newPath);
+        return 1;
+    }
+    if (oldData.size() >= 0x7FFFFFFFu) {
+        logError("Base files of 2 GiB or more are not supported");
+        return 1;
+    }
+
+    logInfo("Building suffix array for " + std::to_string(oldData.size()) + " bytes on " +
+            std::to_string(threads ? threads : 1) + " thread(s)...");
+    SuffixArray suffixArray(oldData.data(), static_cast<uint32_t>(oldData.size()), threads);
+    const std::vector<int32_t>& sa = suffixArray.build();
+
+    logInfo("Diffing...");
+    {
+        std::ofstream patch(patchPath, std::ios::binary | std::ios::trunc);
+        if (!patch.is_open()) {
+            logError("Failed to create " + patchPath);
+            return 1;
+        }
+        AutoUpdaterLib::PatchWriter writer(patch);
+        DeltaGenerator(oldData, newData, sa).generate(writer);
+        patch.close();
+        if (patch.fail()) {
+            logError("Failed to write " + patchPath);
+            return 1;
+        }
+    }
+
+    // Round-trip the patch so a broken patch is never published
+    const std::string verifyPath = patchPath + ".verify";
+    AutoUpdaterLib::PatchApplier applier;
+    const bool applied = applier.apply(oldPath, patchPath, verifyPath);
+    const std::string expected = AutoUpdaterLib::Blake3::hashBuffer(newData.data(), newData.size());
+    const bool verified = applied && AutoUpdaterLib::Blake3::hashFile(verifyPath) == expected;
+    std::remove(verifyPath.c_str());
+    if (!verified) {
+        logError("Patch verification failed" + (applied ? std::string() : ": " + applier.lastError()));
+        std::remove(patchPath.c_str());
+        return 1;
+    }
+
+    std::ifstream patchFile(patchPath, std::ios::binary | std::ios::ate);
+    const uint64_t patchSize = static_cast<uint64_t>(patchFile.tellg());
+    patchFile.close();
+
+    logInfo("Patch is " + std::to_string(patchSize) + " bytes (" +
+            std::to_string(newData.empty() ? 0 : patchSize * 100 / newData.size()) + "% of the new file)");
+
+    nlohmann::ordered_json fragment;
+    fragment["From"] = fromVersion;
+    fragment["To"] = toVersion;
+    fragment["Link"] = link;
+    fragment["Size"] = patchSize;
+    fragment["Digest"] = "blake3:" + AutoUpdaterLib::Blake3::hashFile(patchPath);
+    fragment["TargetSize"] = static_cast<uint64_t>(newData.size());
+    fragment["TargetDigest"] = "blake3:" + expected;
+    std::cout << fragment.dump(4) << std::endl;
+    return 0;
+}
@@ -0,0 +1,274 @@
+/**
+ * @file DurabilityBench.cpp
+ * @brief Measures the cost of each staging durability level on a local disk
+ *
+ * @author myexistences
+ * @copyright Copyright (c) 2025 myexistences. All rights reserved.
+ * @license MIT License
+ *
+ * @description
+ * Writes the same staged files with Durability::None, FlushAtEnd and
+ * Ordered and reports the wall time of each level. Each file is written
+ * along one of two paths:
+ *
+ * - stream: through StagingFile, in 8 KiB pieces as AutoUpdater::downloadFile()
+ *   receives them;
+ * - ranged: through RangedFile, in 1 MiB segments from four interleaved
+ *   streams as SegmentedDownloader writes them, with a checkpoint batch
+ *   (flush plus a small flushed sidecar) every 64 segments.
+ *
+ * Three workloads cover the shapes of a release:
+ *
+ * - small: 256 files of 64 KiB, like the assets of a multi-file release;
+ * - medium: 8 files of 16 MiB, like libraries and patches;
+ * - large: 1 file of 256 MiB, like a full image.
+ *
+ * Only files of at least one segment take the ranged path, as in the updater.
+ * Each level's files are deleted before the next level starts. The
+ * difference between None and the other levels is the price of crash
+ * safety; None's figure is mostly page-cache speed, not disk speed. Run it
+ * on the disk that holds the temp directory, since that is where staging
+ * happens.
+ *
+ * @usage
+ * ```
+ * DurabilityBench [--max-bytes B] [--dir PATH]
+ * ```
+ * Workloads whose files are larger than --max-bytes (default 256 MiB) are skipped.
+ *
+ * @build
+ * ```
+ * cl /O2 /EHsc /std:c++14 /I Updater Tools\DurabilityBench.cpp
+ * g++ -O2 -std=c++11 -I Updater Tools/DurabilityBench.cpp -o DurabilityBench
+ * ```
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "../Updater/Durability.h"
+
+namespace {
+
+using AutoUpdaterLib::Durability;
+using AutoUpdaterLib::RangedFile;
+using AutoUpdaterLib::StagingFile;
+
+const uint64_t MIB = 1024 * 1024;
+const size_t FEED_SIZE = 8192;          // Matches AutoUpdater's download buffer
+const uint64_t SEGMENT_SIZE = MIB;      // Matches SegmentedDownloader::SEGMENT_SIZE
+const uint64_t CHECKPOINT_SEGMENTS = 64; // Matches SegmentedDownloader::CHECKPOINT_SEGMENTS
+const uint64_t STREAMS = 4;             // Matches SegmentedDownloader::INITIAL_CONNECTIONS
+
+struct Workload {
+    const char* name;
+    size_t files;
+    uint64_t fileSize;
+};
+
+struct Level {
+    const char* name;
+    Durability durability;
+};
+
+bool makeDirectory(const std::string& path) {
+#ifdef _WIN32
+    return _mkdir(path.c_str()) == 0 || errno == EEXIST;
+#else
+    return mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+#endif
+}
+
+void removeDirectory(const std::string& path) {
+#ifdef _WIN32
+    _rmdir(path.c_str());
+#else
+    rmdir(path.c_str());
+#endif
+}
+
+std::string formatSize(uint64_t bytes) {
+    char text[32];
+    if (bytes >= MIB) {
+        std::snprintf(text, sizeof(text), "%.0f MiB", static_cast<double>(bytes) / MIB);
+    } else {
+        std::snprintf(text, sizeof(text), "%.0f KiB", static_cast<double>(bytes) / 1024);
+    }
+    return text;
+}
+
+/**
+ * @brief Writes one file front to back, as a single-request download does
+ */
+bool writeStream(const std::string& path, uint64_t size, Durability durability, const std::vector<char>& block) {
+    StagingFile file(durability);
+    if (!file.open(path)) {
+        return false;
+    }
+    for (uint64_t written = 0; written < size; written += FEED_SIZE) {
+        const size_t count = static_cast<size_t>(std::min<uint64_t>(FEED_SIZE, size - written));
+        if (!file.write(block.data(), count)) {
+            return false;
+        }
+    }
+    return file.commit();
+}
+
+/**
+ * @brief Writes one file in interleaved segments with checkpoint batches, as a ranged download does
+ *
+ * The checkpoint is saved like DownloadCheckpoint::save(): a flushed
+ * temporary file renamed over the sidecar, whatever the level.
+ */
+bool writeRanged(const std::string& path, uint64_t size, Durability durability, const std::vector<char>& block) {
+    const uint64_t segments = (size + SEGMENT_SIZE - 1) / SEGMENT_SIZE;
+    const std::string sidecar = RangedFile::writePath(path, durability) + ".ckpt";
+    std::vector<char> bitmap(static_cast<size_t>((segments + 7) / 8), 0);
+    std::vector<char> segment(static_cast<size_t>(SEGMENT_SIZE));
+    for (size_t offset = 0; offset < segment.size(); offset += block.size()) {
+        std::copy(block.begin(), block.end(), segment.begin() + static_cast<std::ptrdiff_t>(offset));
+    }
+
+    RangedFile file(durability);
+    if (!file.open(path, size, false)) {
+        return false;
+    }
+    const uint64_t perStream = (segments + STREAMS - 1) / STREAMS;
+    uint64_t unsaved = 0;
+    for (uint64_t step = 0; step < perStream * STREAMS; ++step) {
+        const uint64_t index = step % STREAMS * perStream + step / STREAMS;
+        if (index >= segments) {
+            continue;
+        }
+        const uint64_t offset = index * SEGMENT_SIZE;
+        const size_t count = static_cast<size_t>(std::min<uint64_t>(SEGMENT_SIZE, size - offset));
+        if (!file.writeAt(offset, segment.data(), count)) {
+            return false;
+        }
+        bitmap[static_cast<size_t>(index / 8)] = static_cast<char>(bitmap[static_cast<size_t>(index / 8)] | (1 << (index % 8)));
+        if (++unsaved >= CHECKPOINT_SEGMENTS) {
+            StagingFile checkpoint(Durability::Ordered);
+            if (!file.flush() || !checkpoint.open(sidecar) || !checkpoint.write(bitmap.data(), bitmap.size()) ||
+                !checkpoint.commit()) {
+                return false;
+            }
+            unsaved = 0;
+        }
+    }
+    const bool ok = file.commit();
+    std::remove(sidecar.c_str());
+    return ok;
+}
+
+/**
+ * @brief Writes a workload's files with one durability level
+ * @return Elapsed seconds, or a negative value if a write failed
+ */
+double run(const std::string& directory, const Workload& workload, bool ranged, Durability durability,
+           const std::vector<char>& block) {
+    std::vector<std::string> paths;
+    const auto started = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < workload.files; ++i) {
+        paths.push_back(directory + "/staged" + std::to_string(i) + ".bin");
+        const bool ok = ranged ? writeRanged(paths.back(), workload.fileSize, durability, block)
+                               : writeStream(paths.back(), workload.fileSize, durability, block);
+        if (!ok) {
+            for (const auto& path : paths) {
+                std::remove(path.c_str());
+                std::remove((path + ".part").c_str());
+            }
+            return -1;
+        }
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    for (const auto& path : paths) {
+        std::remove(path.c_str());
+    }
+    return seconds;
+}
+
+void printUsage() {
+    std::cerr << "Usage: DurabilityBench [--max-bytes B] [--dir PATH]\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    uint64_t maxBytes = 256 * MIB;
+    std::string directory = "durabilitybench.tmp";
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            printUsage();
+            return 2;
+        }
+        if (arg == "--max-bytes") {
+            maxBytes = std::stoull(argv[++i]);
+        } else if (arg == "--dir") {
+            directory = argv[++i];
+        } else {
+            printUsage();
+            return 2;
+        }
+    }
+    if (!makeDirectory(directory)) {
+        std::cerr << "Cannot create " << directory << "\n";
+        return 2;
+    }
+
+    // Incompressible bytes, so compressing file systems do not flatter any level
+    std::vector<char> block(FEED_SIZE);
+    uint64_t state = 0x9E3779B97F4A7C15ULL;
+    for (auto& byte : block) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        byte = static_cast<char>(state);
+    }
+
+    const Workload workloads[] = {{"small", 256, 64 * 1024}, {"medium", 8, 16 * MIB}, {"large", 1, 256 * MIB}};
+    const Level levels[] = {{"none", Durability::None}, {"flush-at-end", Durability::FlushAtEnd}, {"ordered", Durability::Ordered}};
+
+    std::printf("%-8s %-7s %-14s %12s %11s %10s %12s\n", "workload", "path", "level", "files", "time", "MiB/s",
+                "ms per file");
+    bool allPassed = true;
+    for (const auto& workload : workloads) {
+        if (workload.fileSize > maxBytes) {
+            continue;
+        }
+        const uint64_t total = workload.files * workload.fileSize;
+        for (int ranged = 0; ranged < 2; ++ranged) {
+            if (ranged && workload.fileSize < SEGMENT_SIZE) {
+                continue;
+            }
+            const char* path = ranged ? "ranged" : "stream";
+            for (const auto& level : levels) {
+                const double seconds = run(directory, workload, ranged != 0, level.durability, block);
+                if (seconds < 0) {
+                    std::printf("%-8s %-7s %-14s FAILED\n", workload.name, path, level.name);
+                    allPassed = false;
+                    continue;
+                }
+                const std::string files = std::to_string(workload.files) + " x " + formatSize(workload.fileSize);
+                std::printf("%-8s %-7s %-14s %12s %8.0f ms %10.0f %12.2f\n", workload.name, path, level.name,
+                            files.c_str(), seconds * 1000, static_cast<double>(total) / MIB / seconds,
+                            seconds * 1000 / workload.files);
+                std::fflush(stdout);
+            }
+        }
+    }
+
+    removeDirectory(directory);
+    return allPassed ? 0 : 1;
+}
@@ -0,0 +1,356 @@
+/**
+ * @file FleetSim.cpp
+ * @brief Simulates the load a fleet of polling updaters puts on the update server
+ *
+ * @author myexistences
+ * @copyright Copyright (c) 2025 myexistences. All rights reserved.
+ * @license MIT License
+ *
+ * @description
+ * Runs thousands of simulated clients against a virtual clock. Each client
+ * uses the same CheckSchedule and ConditionalRequest as
+ * AutoUpdater::pollForUpdates() (see Updater/Schedule.h), so interval
+ * jitter, failure backoff, Retry-After and If-None-Match behave exactly as
+ * in the field. A server stand-in answers every request:
+ *
+ * - 200 with the manifest, or 304 when the client's ETag is current;
+ * - 503 with Retry-After once more requests arrive in one second than the
+ *   configured capacity;
+ * - a dropped connection for a configurable share of requests.
+ *
+ * A client that sees a new version downloads the update and restarts,
+ * which, like a real restart, forgets its validators. The report lists
+ * request rate, peak rate, response mix and egress for each time bucket.
+ *
+ * @usage
+ * ```
+ * FleetSim [--clients N] [--hours H] [--interval-minutes M] [--jitter PERCENT]
+ *          [--launch-minutes M] [--start-spread-minutes M]
+ *          [--min-backoff-seconds S] [--max-backoff-minutes M]
+ *          [--release-at-hours H]... [--manifest-bytes B] [--update-bytes B]
+ *          [--capacity RPS] [--retry-after SECONDS] [--failure-percent P]
+ *          [--bucket-minutes M] [--no-conditional] [--seed N] [--csv]
+ * ```
+ *
+ * @build
+ * ```
+ * cl /O2 /EHsc /std:c++14 Tools\FleetSim.cpp
+ * g++ -O2 -std=c++11 Tools/FleetSim.cpp -o FleetSim
+ * ```
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../Updater/Schedule.h"
+
+namespace {
+
+using AutoUpdaterLib::CheckPolicy;
+using AutoUpdaterLib::CheckSchedule;
+using AutoUpdaterLib::ConditionalRequest;
+
+const uint64_t SECOND_MS = 1000;
+const uint64_t MINUTE_MS = 60 * SECOND_MS;
+const uint64_t HOUR_MS = 60 * MINUTE_MS;
+const uint64_t RESPONSE_HEADER_BYTES = 300; // Status line and headers of any response
+
+/**
+ * @brief SplitMix64 step used for the simulation's own randomness
+ */
+uint64_t nextRandom(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * @struct Response
+ * @brief What the server stand-in sent back
+ */
+struct Response {
+    unsigned status;       ///< 0 for a dropped connection
+    uint64_t bytes;        ///< Bytes on the wire, headers included
+    std::string etag;
+    std::string retryAfter;
+};
+
+/**
+ * @class ServerStandIn
+ * @brief Serves the manifest with ETags, a per-second capacity and random drops
+ */
+class ServerStandIn {
+public:
+    ServerStandIn(uint64_t manifestBytes, uint64_t capacity, uint64_t retryAfterSeconds,
+                  unsigned failurePercent, uint64_t seed)
+        : m_manifestBytes(manifestBytes), m_capacity(capacity), m_retryAfter(std::to_string(retryAfterSeconds)),
+          m_failurePercent(failurePercent), m_random(seed) {}
+
+    void publish(unsigned version) {
+        m_version = version;
+        m_etag = "\"v" + std::to_string(version) + "\"";
+    }
+
+    unsigned version() const { return m_version; }
+
+    /**
+     * @brief Answers one manifest request
+     * @param now Virtual time of the request
+     * @param headers Request headers as produced by ConditionalRequest::headers()
+     */
+    Response handle(uint64_t now, const std::string& headers) {
+        const uint64_t second = now / SECOND_MS;
+        if (second != m_second) {
+            m_second = second;
+            m_inSecond = 0;
+        }
+        ++m_inSecond;
+
+        if (m_failurePercent > 0 && nextRandom(m_random) % 100 < m_failurePercent) {
+            return Response{0, 0, std::string(), std::string()};
+        }
+        if (m_capacity > 0 && m_inSecond > m_capacity) {
+            return Response{503, RESPONSE_HEADER_BYTES, std::string(), m_retryAfter};
+        }
+        if (headers.find("If-None-Match: " + m_etag + "\r\n") != std::string::npos) {
+            return Response{304, RESPONSE_HEADER_BYTES, m_etag, std::string()};
+        }
+        return Response{200, RESPONSE_HEADER_BYTES + m_manifestBytes, m_etag, std::string()};
+    }
+
+private:
+    uint64_t m_manifestBytes;
+    uint64_t m_capacity;
+    std::string m_retryAfter;
+    unsigned m_failurePercent;
+    uint64_t m_random;
+    unsigned m_version = 1;
+    std::string m_etag = "\"v1\"";
+    uint64_t m_second = UINT64_MAX;
+    uint64_t m_inSecond = 0;
+};
+
+/**
+ * @struct Client
+ * @brief One simulated updater process
+ */
+struct Client {
+    CheckSchedule schedule;
+    ConditionalRequest conditional;
+    unsigned version = 1;
+};
+
+/**
+ * @struct Bucket
+ * @brief Traffic observed in one reporting interval
+ */
+struct Bucket {
+    uint64_t requests = 0;
+    uint64_t peakPerSecond = 0;
+    uint64_t ok = 0;
+    uint64_t notModified = 0;
+    uint64_t rejected = 0;
+    uint64_t dropped = 0;
+    uint64_t updates = 0;
+    uint64_t manifestBytes = 0;
+    uint64_t updateBytes = 0;
+};
+
+void printUsage() {
+    std::cerr << "Usage: FleetSim [--clients N] [--hours H] [--interval-minutes M] [--jitter PERCENT]\n"
+              << "                [--launch-minutes M] [--start-spread-minutes M]\n"
+              << "                [--min-backoff-seconds S] [--max-backoff-minutes M]\n"
+              << "                [--release-at-hours H]... [--manifest-bytes B] [--update-bytes B]\n"
+              << "                [--capacity RPS] [--retry-after SECONDS] [--failure-percent P]\n"
+              << "                [--bucket-minutes M] [--no-conditional] [--seed N] [--csv]\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    uint64_t clientCount = 10000;
+    uint64_t hours = 48;
+    uint64_t launchMinutes = 0;
+    uint64_t manifestBytes = 2048;
+    uint64_t updateBytes = 50ULL * 1024 * 1024;
+    uint64_t capacity = 0;
+    uint64_t retryAfterSeconds = 120;
+    unsigned failurePercent = 0;
+    uint64_t bucketMinutes = 60;
+    uint64_t seed = 1;
+    bool conditional = true;
+    bool csv = false;
+    std::vector<uint64_t> releases;
+    CheckPolicy policy;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--no-conditional") {
+            conditional = false;
+            continue;
+        }
+        if (arg == "--csv") {
+            csv = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            printUsage();
+            return 2;
+        }
+        const uint64_t value = std::stoull(argv[++i]);
+        if (arg == "--clients") {
+            clientCount = value;
+        } else if (arg == "--hours") {
+            hours = value;
+        } else if (arg == "--interval-minutes") {
+            policy.intervalMs = value * MINUTE_MS;
+        } else if (arg == "--jitter") {
+            policy.jitterPercent = static_cast<uint32_t>(value);
+        } else if (arg == "--launch-minutes") {
+            launchMinutes = value;
+        } else if (arg == "--start-spread-minutes") {
+            policy.startSpreadMs = value * MINUTE_MS;
+        } else if (arg == "--min-backoff-seconds") {
+            policy.minBackoffMs = value * SECOND_MS;
+        } else if (arg == "--max-backoff-minutes") {
+            policy.maxBackoffMs = value * MINUTE_MS;
+        } else if (arg == "--release-at-hours") {
+            releases.push_back(value * HOUR_MS);
+        } else if (arg == "--manifest-bytes") {
+            manifestBytes = value;
+        } else if (arg == "--update-bytes") {
+            updateBytes = value;
+        } else if (arg == "--capacity") {
+            capacity = value;
+        } else if (arg == "--retry-after") {
+            retryAfterSeconds = value;
+        } else if (arg == "--failure-percent") {
+            failurePercent = static_cast<unsigned>(std::min<uint64_t>(value, 100));
+        } else if (arg == "--bucket-minutes") {
+            bucketMinutes = std::max<uint64_t>(value, 1);
+        } else if (arg == "--seed") {
+            seed = value;
+        } else {
+            printUsage();
+            return 2;
+        }
+    }
+    if (releases.empty()) {
+        releases.push_back(hours / 2 * HOUR_MS);
+    }
+    std::sort(releases.begin(), releases.end());
+
+    const uint64_t endMs = hours * HOUR_MS;
+    const uint64_t bucketMs = bucketMinutes * MINUTE_MS;
+    std::vector<Bucket> buckets(static_cast<size_t>((endMs + bucketMs - 1) / bucketMs));
+    ServerStandIn server(manifestBytes, capacity, retryAfterSeconds, failurePercent, seed ^ 0x5EEDULL);
+
+    // Event queue of (virtual time, client index)
+    typedef std::pair<uint64_t, size_t> Event;
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events;
+    std::vector<Client> clients(static_cast<size_t>(clientCount));
+    uint64_t random = seed;
+    for (size_t i = 0; i < clients.size(); ++i) {
+        clients[i].schedule = CheckSchedule(policy, nextRandom(random));
+        const uint64_t launch = launchMinutes > 0 ? nextRandom(random) % (launchMinutes * MINUTE_MS) : 0;
+        events.push(Event(clients[i].schedule.start(launch), i));
+    }
+
+    size_t nextRelease = 0;
+    uint64_t currentSecond = UINT64_MAX;
+    uint64_t inSecond = 0;
+    while (!events.empty() && events.top().first < endMs) {
+        const uint64_t now = events.top().first;
+        const size_t index = events.top().second;
+        Client& client = clients[index];
+        events.pop();
+
+        while (nextRelease < releases.size() && releases[nextRelease] <= now) {
+            server.publish(server.version() + 1);
+            ++nextRelease;
+        }
+
+        Bucket& bucket = buckets[static_cast<size_t>(now / bucketMs)];
+        if (now / SECOND_MS != currentSecond) {
+            currentSecond = now / SECOND_MS;
+            inSecond = 0;
+        }
+        bucket.peakPerSecond = std::max(bucket.peakPerSecond, ++inSecond);
+        ++bucket.requests;
+
+        const Response response = server.handle(now, conditional ? client.conditional.headers() : std::string());
+        client.conditional.received(response.status, response.etag, std::string(), response.retryAfter);
+        bucket.manifestBytes += response.bytes;
+
+        uint64_t next;
+        if (response.status == 200 || response.status == 304) {
+            ++(response.status == 200 ? bucket.ok : bucket.notModified);
+            if (response.status == 200 && server.version() != client.version) {
+                // Download, install and restart; a new process starts without validators
+                ++bucket.updates;
+                bucket.updateBytes += updateBytes;
+                client.version = server.version();
+                client.conditional.reset();
+                next = client.schedule.start(now);
+            } else {
+                next = client.schedule.succeeded(now);
+            }
+        } else {
+            ++(response.status == 0 ? bucket.dropped : bucket.rejected);
+            next = client.schedule.failed(now, client.conditional.retryAfterMs());
+        }
+        events.push(Event(next, index));
+    }
+
+    const double bucketSeconds = static_cast<double>(bucketMs) / SECOND_MS;
+    Bucket total;
+    if (csv) {
+        std::printf("minute,requests,requests_per_second,peak_per_second,ok,not_modified,rejected,dropped,"
+                    "updates,manifest_bytes,update_bytes\n");
+    } else {
+        std::printf("%8s %10s %9s %9s %9s %9s %9s %9s %8s %12s %14s\n", "time", "requests", "req/s", "peak/s",
+                    "200", "304", "503", "dropped", "updates", "manifest MB", "update MB");
+    }
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        const Bucket& b = buckets[i];
+        const uint64_t minute = i * bucketMinutes;
+        if (csv) {
+            std::printf("%llu,%llu,%.3f,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu\n",
+                        static_cast<unsigned long long>(minute), static_cast<unsigned long long>(b.requests),
+                        b.requests / bucketSeconds, static_cast<unsigned long long>(b.peakPerSecond),
+                        static_cast<unsigned long long>(b.ok), static_cast<unsigned long long>(b.notModified),
+                        static_cast<unsigned long long>(b.rejected), static_cast<unsigned long long>(b.dropped),
+                        static_cast<unsigned long long>(b.updates), static_cast<unsigned long long>(b.manifestBytes),
+                        static_cast<unsigned long long>(b.updateBytes));
+        } else {
+            std::printf("%5llu:%02llu %10llu %9.2f %9llu %9llu %9llu %9llu %9llu %8llu %12.2f %14.1f\n",
+                        static_cast<unsigned long long>(minute / 60), static_cast<unsigned long long>(minute % 60),
+                        static_cast<unsigned long long>(b.requests), b.requests / bucketSeconds,
+                        static_cast<unsigned long long>(b.peakPerSecond), static_cast<unsigned long long>(b.ok),
+                        static_cast<unsigned long long>(b.notModified), static_cast<unsigned long long>(b.rejected),
+                        static_cast<unsigned long long>(b.dropped), static_cast<unsigned long long>(b.updates),
+                        b.manifestBytes / 1048576.0, b.updateBytes / 1048576.0);
+        }
+        total.requests += b.requests;
+        total.peakPerSecond = std::max(total.peakPerSecond, b.peakPerSecond);
+        total.updates += b.updates;
+        total.manifestBytes += b.manifestBytes;
+        total.updateBytes += b.updateBytes;
+    }
+
+    if (!csv) {
+        std::printf("\n%llu clients, %llu requests, peak %llu/s, %llu updates, %.2f MB manifest egress, "
+                    "%.1f MB update egress\n",
+                    static_cast<unsigned long long>(clientCount), static_cast<unsigned long long>(total.requests),
+                    static_cast<unsigned long long>(total.peakPerSecond), static_cast<unsigned long long>(total.updates),
+                    total.manifestBytes / 1048576.0, total.updateBytes / 1048576.0);
+    }
+    return 0;
+}
@@ -0,0 +1,452 @@
+/**
+ * @file MemoryBench.cpp
+ * @brief Measures the updater's peak memory while it processes large payloads
+ *
+ * @author myexistences
+ * @copyright Copyright (c) 2025 myexistences. All rights reserved.
+ * @license MIT License
+ *
+ * @description
+ * Runs the memory-heavy parts of an update against synthetic payloads of
+ * 1 MiB, 16 MiB, 256 MiB and 4 GiB and reports the peak heap of each
+ * phase, measured by replacing the global operator new and delete:
+ *
+ * - extract: a zip holding the payload as one deflated entry is fed to
+ *   ZipStreamExtractor in download-sized pieces and hashed on the way,
+ *   exactly as AutoUpdater::downloadArchive() does;
+ * - verify: the extracted file is hashed with Blake3::hashFile();
+ * - manifest: a generated manifest listing one file per 64 KiB of payload
+ *   is parsed with UpdateManifest::fromJsonStream() within
+ *   MemoryProfile::MANIFEST_BUDGET, and every file is visited with
+ *   forEachFile(). The bounded build spools the file list to disk, as
+ *   AutoUpdater does.
+ *
+ * The process's resident-set high-water mark is printed after each size.
+ * The tool exits with status 1 if any phase fails or is rejected. Built
+ * with AUTO_UPDATER_BOUNDED_MEMORY, it also exits with status 1 if any
+ * phase's peak heap exceeds AUTO_UPDATER_MEMORY_CEILING, so it can gate
+ * changes to the bounded-memory build. Extraction needs about twice the
+ * payload size in free disk space.
+ *
+ * @usage
+ * ```
+ * MemoryBench [--max-bytes B] [--dir PATH]
+ * ```
+ * Payloads above --max-bytes (default 256 MiB) are skipped; pass
+ * --max-bytes 4294967296 for the full sweep.
+ *
+ * @build
+ * ```
+ * cl /O2 /EHsc /std:c++14 /DAUTO_UPDATER_BOUNDED_MEMORY /I Updater Tools\MemoryBench.cpp
+ * g++ -O2 -std=c++11 -pthread -DAUTO_UPDATER_BOUNDED_MEMORY -I Updater Tools/MemoryBench.cpp -o MemoryBench
+ * ```
+ * Omit AUTO_UPDATER_BOUNDED_MEMORY to measure the default build.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <streambuf>
+#include <string>
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "../Updater/Archive.h"
+#include "../Updater/Blake3.h"
+#include "../Updater/Manifest.h"
+#include "../Updater/MemoryProfile.h"
+#include "../Updater/WorkerPool.h"
+
+namespace {
+
+// Every allocation carries its size in a header so frees can be accounted
+const size_t HEADER_SIZE = 16;
+std::atomic<size_t> g_heapInUse(0);
+std::atomic<size_t> g_heapPeak(0);
+
+void* allocate(size_t size) {
+    void* block = std::malloc(size + HEADER_SIZE);
+    if (!block) {
+        throw std::bad_alloc();
+    }
+    *static_cast<size_t*>(block) = size;
+    const size_t inUse = g_heapInUse += size;
+    size_t peak = g_heapPeak.load();
+    while (inUse > peak && !g_heapPeak.compare_exchange_weak(peak, inUse)) {
+    }
+    return static_cast<char*>(block) + HEADER_SIZE;
+}
+
+void release(void* pointer) {
+    if (!pointer) {
+        return;
+    }
+    void* block = static_cast<char*>(pointer) - HEADER_SIZE;
+    g_heapInUse -= *static_cast<size_t*>(block);
+    std::free(block);
+}
+
+} // namespace
+
+void* operator new(size_t size) { return allocate(size); }
+void* operator new[](size_t size) { return allocate(size); }
+void operator delete(void* pointer) noexcept { release(pointer); }
+void operator delete[](void* pointer) noexcept { release(pointer); }
+void operator delete(void* pointer, size_t) noexcept { release(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { release(pointer); }
+
+namespace {
+
+using AutoUpdaterLib::Blake3;
+using AutoUpdaterLib::Crc32;
+using AutoUpdaterLib::FileEntry;
+using AutoUpdaterLib::MemoryProfile;
+using AutoUpdaterLib::UpdateManifest;
+using AutoUpdaterLib::WorkerPool;
+using AutoUpdaterLib::ZipStreamExtractor;
+
+const uint64_t MIB = 1024 * 1024;
+const size_t FEED_SIZE = 8192;           // Matches AutoUpdater's download buffer
+const size_t STORED_BLOCK_SIZE = 65535;  // Largest stored DEFLATE block
+const uint64_t BYTES_PER_MANIFEST_FILE = 64 * 1024;
+const size_t ARCHIVE_MEMORY_BUDGET = 64 * 1024 * 1024; // As in AutoUpdater
+
+/**
+ * @brief Deterministic payload, produced block by block without allocating
+ */
+class Payload {
+public:
+    explicit Payload(uint64_t size) : m_size(size) {}
+
+    uint64_t size() const { return m_size; }
+
+    /**
+     * @brief Fills a buffer with the bytes at an offset
+     * @return Number of bytes written, 0 past the end
+     */
+    size_t read(uint64_t offset, uint8_t* buffer, size_t capacity) const {
+        const size_t count = static_cast<size_t>(std::min<uint64_t>(capacity, m_size - std::min(offset, m_size)));
+        uint64_t word = 0;
+        for (size_t i = 0; i < count; ++i) {
+            const uint64_t position = offset + i;
+            if (i == 0 || position % 8 == 0) {
+                // Each 8-byte word is a hash of its index, so any range can be produced on its own
+                word = (position / 8 + 1) * 0x9E3779B97F4A7C15ULL;
+                word = (word ^ (word >> 30)) * 0xBF58476D1CE4E5B9ULL;
+                word ^= word >> 31;
+            }
+            buffer[i] = static_cast<uint8_t>(word >> (8 * (position % 8)));
+        }
+        return count;
+    }
+
+private:
+    uint64_t m_size;
+};
+
+/**
+ * @brief Writes a zip with one deflated entry, built from stored blocks, to a callback
+ * @param payload Entry contents
+ * @param sink Receives the archive in FEED_SIZE pieces; returning false stops
+ */
+template <typename Sink>
+bool writeZip(const Payload& payload, Sink sink) {
+    static uint8_t block[STORED_BLOCK_SIZE];
+
+    Crc32 crc;
+    for (uint64_t offset = 0; offset < payload.size();) {
+        const size_t count = payload.read(offset, block, sizeof(block));
+        crc.update(block, count);
+        offset += count;
+    }
+
+    const uint64_t blocks = payload.size() == 0 ? 1 : (payload.size() + STORED_BLOCK_SIZE - 1) / STORED_BLOCK_SIZE;
+    const uint64_t compressedSize = payload.size() + 5 * blocks;
+    const char name[] = "payload.bin";
+
+    uint8_t header[30 + sizeof(name) - 1 + 20];
+    size_t at = 0;
+    auto put16 = [&](uint32_t v) { header[at++] = static_cast<uint8_t>(v); header[at++] = static_cast<uint8_t>(v >> 8); };
+    auto put32 = [&](uint32_t v) { put16(v & 0xFFFF); put16(v >> 16); };
+    auto put64 = [&](uint64_t v) { put32(static_cast<uint32_t>(v)); put32(static_cast<uint32_t>(v >> 32)); };
+    put32(0x04034B50u);
+    put16(45);          // Version needed: zip64
+    put16(0);           // Flags
+    put16(8);           // Deflate
+    put32(0);           // Time and date
+    put32(crc.value());
+    put32(0xFFFFFFFFu); // Sizes are in the zip64 extra field
+    put32(0xFFFFFFFFu);
+    put16(sizeof(name) - 1);
+    put16(20);
+    for (size_t i = 0; i + 1 < sizeof(name); ++i) {
+        header[at++] = static_cast<uint8_t>(name[i]);
+    }
+    put16(0x0001);
+    put16(16);
+    put64(payload.size());
+    put64(compressedSize);
+    if (!sink(header, at)) {
+        return false;
+    }
+
+    // Stored blocks: a header byte, LEN and NLEN, then the bytes as they are
+    uint64_t offset = 0;
+    for (uint64_t i = 0; i < blocks; ++i) {
+        const size_t length = payload.read(offset, block, sizeof(block));
+        const uint8_t blockHeader[5] = {
+            static_cast<uint8_t>(i + 1 == blocks ? 1 : 0),
+            static_cast<uint8_t>(length), static_cast<uint8_t>(length >> 8),
+            static_cast<uint8_t>(~length), static_cast<uint8_t>(~length >> 8)};
+        if (!sink(blockHeader, sizeof(blockHeader))) {
+            return false;
+        }
+        for (size_t done = 0; done < length; done += FEED_SIZE) {
+            if (!sink(block + done, std::min(length - done, FEED_SIZE))) {
+                return false;
+            }
+        }
+        offset += length;
+    }
+
+    uint8_t end[22] = {0x50, 0x4B, 0x05, 0x06};
+    return sink(end, sizeof(end));
+}
+
+/**
+ * @brief Stream of a manifest listing one file per 64 KiB of payload
+ */
+class ManifestSource : public std::streambuf {
+public:
+    explicit ManifestSource(uint64_t fileCount) : m_fileCount(fileCount) {}
+
+protected:
+    int_type underflow() override {
+        int length = 0;
+        if (m_next == 0) {
+            length = std::snprintf(m_buffer, sizeof(m_buffer),
+                                   "{\"AppVersion\":\"2.0\",\"UpdateLink\":\"https://updates.example.com/app.zip\","
+                                   "\"Package\":\"zip\",\"Files\":[");
+        } else if (m_next <= m_fileCount) {
+            length = std::snprintf(m_buffer, sizeof(m_buffer),
+                                   "%s{\"Path\":\"data/file%06llu.bin\",\"Link\":\"https://updates.example.com/2.0/file%06llu.bin\","
+                                   "\"Size\":65536,\"Digest\":\"blake3:%064llu\","
+                                   "\"Chunks\":[{\"Size\":65536,\"Digest\":\"blake3:%064llu\"}]}",
+                                   m_next > 1 ? "," : "", static_cast<unsigned long long>(m_next),
+                                   static_cast<unsigned long long>(m_next), static_cast<unsigned long long>(m_next),
+                                   static_cast<unsigned long long>(m_next));
+        } else if (m_next == m_fileCount + 1) {
+            length = std::snprintf(m_buffer, sizeof(m_buffer), "]}");
+        } else {
+            return traits_type::eof();
+        }
+        ++m_next;
+        setg(m_buffer, m_buffer, m_buffer + length);
+        return traits_type::to_int_type(m_buffer[0]);
+    }
+
+private:
+    uint64_t m_fileCount;
+    uint64_t m_next = 0;
+    char m_buffer[512];
+};
+
+/**
+ * @brief Starts measuring a phase
+ * @return Heap in use at the start, subtracted from the peak afterwards
+ */
+size_t beginPhase() {
+    const size_t inUse = g_heapInUse.load();
+    g_heapPeak = inUse;
+    return inUse;
+}
+
+/**
+ * @brief Reads the process's resident-set high-water mark in bytes, or 0 if unavailable
+ */
+uint64_t peakResidentBytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    return GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)) ? counters.PeakWorkingSetSize : 0;
+#else
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) {
+            return std::strtoull(line.c_str() + 6, nullptr, 10) * 1024;
+        }
+    }
+    return 0;
+#endif
+}
+
+bool makeDirectory(const std::string& path) {
+#ifdef _WIN32
+    return _mkdir(path.c_str()) == 0 || errno == EEXIST;
+#else
+    return mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+#endif
+}
+
+void removeDirectory(const std::string& path) {
+#ifdef _WIN32
+    _rmdir(path.c_str());
+#else
+    rmdir(path.c_str());
+#endif
+}
+
+std::string formatSize(uint64_t bytes) {
+    char text[32];
+    if (bytes >= MIB) {
+        std::snprintf(text, sizeof(text), "%.1f MiB", static_cast<double>(bytes) / MIB);
+    } else {
+        std::snprintf(text, sizeof(text), "%.1f KiB", static_cast<double>(bytes) / 1024);
+    }
+    return text;
+}
+
+void report(uint64_t payloadSize, const char* phase, size_t baseline, const std::string& result, bool& withinCeiling) {
+    const size_t peak = g_heapPeak.load() - baseline;
+    if (MemoryProfile::BOUNDED && peak > static_cast<size_t>(AUTO_UPDATER_MEMORY_CEILING)) {
+        withinCeiling = false;
+    }
+    std::printf("%-12s %-10s %14s   %s\n", formatSize(payloadSize).c_str(), phase, formatSize(peak).c_str(), result.c_str());
+    std::fflush(stdout);
+}
+
+void printUsage() {
+    std::cerr << "Usage: MemoryBench [--max-bytes B] [--dir PATH]\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    uint64_t maxBytes = 256 * MIB;
+    std::string directory = "memorybench.tmp";
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            printUsage();
+            return 2;
+        }
+        if (arg == "--max-bytes") {
+            maxBytes = std::stoull(argv[++i]);
+        } else if (arg == "--dir") {
+            directory = argv[++i];
+        } else {
+            printUsage();
+            return 2;
+        }
+    }
+    if (!makeDirectory(directory)) {
+        std::cerr << "Cannot create " << directory << "\n";
+        return 2;
+    }
+
+    if (MemoryProfile::BOUNDED) {
+        std::printf("Profile: bounded, ceiling %s\n", formatSize(AUTO_UPDATER_MEMORY_CEILING).c_str());
+    } else {
+        std::printf("Profile: default (no ceiling)\n");
+    }
+    std::printf("%-12s %-10s %14s   %s\n", "payload", "phase", "peak heap", "result");
+
+    const uint64_t sizes[] = {MIB, 16 * MIB, 256 * MIB, 4096 * MIB};
+    const std::string extracted = directory + "/payload.bin";
+    bool withinCeiling = true;
+    bool allPassed = true;
+    for (uint64_t size : sizes) {
+        if (size > maxBytes) {
+            continue;
+        }
+        const Payload payload(size);
+
+        // The payload's own digest, computed outside any measured phase
+        static uint8_t block[STORED_BLOCK_SIZE];
+        Blake3 payloadHasher;
+        for (uint64_t offset = 0; offset < size;) {
+            const size_t count = payload.read(offset, block, sizeof(block));
+            payloadHasher.update(block, count);
+            offset += count;
+        }
+        const std::string payloadDigest = payloadHasher.hexDigest();
+
+        size_t baseline = beginPhase();
+        bool ok;
+        std::string error;
+        {
+            WorkerPool pool(MemoryProfile::BOUNDED ? 1 : 0, ARCHIVE_MEMORY_BUDGET);
+            ZipStreamExtractor extractor(directory, pool);
+            Blake3 archiveHasher;
+            ok = writeZip(payload, [&](const uint8_t* data, size_t length) {
+                archiveHasher.update(data, length);
+                return extractor.feed(data, length);
+            });
+            ok = extractor.finish() && ok;
+            if (!ok) {
+                error = extractor.lastError();
+            }
+        }
+        report(size, "extract", baseline, ok ? "ok" : "FAILED: " + error, withinCeiling);
+        allPassed = allPassed && ok;
+
+        baseline = beginPhase();
+        const bool verified = ok && Blake3::hashFile(extracted) == payloadDigest;
+        report(size, "verify", baseline, verified ? "ok" : "FAILED: digest mismatch", withinCeiling);
+        allPassed = allPassed && verified;
+        std::remove(extracted.c_str());
+
+        baseline = beginPhase();
+        const uint64_t fileCount = size / BYTES_PER_MANIFEST_FILE;
+        const std::string spoolPath = MemoryProfile::BOUNDED ? directory + "/manifest.files" : std::string();
+        std::string result;
+        bool listed = false;
+        {
+            ManifestSource source(fileCount);
+            std::istream in(&source);
+            UpdateManifest manifest;
+            uint64_t visited = 0;
+            if (!UpdateManifest::fromJsonStream(in, manifest, error, MemoryProfile::MANIFEST_BUDGET, spoolPath)) {
+                result = "rejected (" + std::to_string(fileCount) + " files): " + error;
+            } else if (!manifest.forEachFile([&visited](const FileEntry&) {
+                           ++visited;
+                           return true;
+                       }) ||
+                       visited != fileCount) {
+                result = "FAILED: listed " + std::to_string(visited) + " of " + std::to_string(fileCount) + " files";
+            } else {
+                listed = true;
+                result = "ok, " + std::to_string(visited) + " files";
+            }
+        }
+        if (!spoolPath.empty()) {
+            std::remove(spoolPath.c_str());
+        }
+        report(size, "manifest", baseline, result, withinCeiling);
+        allPassed = allPassed && listed;
+
+        std::printf("%-12s RSS high-water %s\n", formatSize(size).c_str(), formatSize(peakResidentBytes()).c_str());
+    }
+    removeDirectory(directory);
+
+    if (!allPassed) {
+        std::printf("Some phases failed\n");
+        return 1;
+    }
+    if (!withinCeiling) {
+        std::printf("Peak heap exceeded the %s ceiling\n", formatSize(AUTO_UPDATER_MEMORY_CEILING).c_str());
+        return 1;
+    }
+    return 0;
+}
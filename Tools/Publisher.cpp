@@ -0,0 +1,448 @@
+/**
+ * @file Publisher.cpp
+ * @brief Command-line tool that generates update manifests for a release
+ *
+ * @author myexistences
+ * @copyright Copyright (c) 2025 myexistences. All rights reserved.
+ * @license MIT License
+ *
+ * @description
+ * Walks a release directory, hashes every file with BLAKE3 and splits it
+ * into content-defined chunks, then writes the manifest as JSON and in the
+ * binary "AUMANIF1" form (see Updater/Manifest.h). With `--bundle` it also
+ * writes an offline bundle holding the manifest and every file (see
+ * Updater/Bundle.h) for hosts that cannot reach the update server. Files are processed on
+ * worker threads, largest first. The output depends only on the file
+ * contents, relative paths and command-line options: files are sorted by
+ * path, keys are emitted in a fixed order and no timestamps are recorded,
+ * so publishing the same release twice is bit-for-bit identical.
+ *
+ * @usage
+ * ```
+ * Publisher <release-dir> --version 1.2 --base-url https://example.com/releases/1.2
+ *           [--exe YourApp.exe] [--json manifest.json] [--binary manifest.bin] [--threads N]
+ *           [--defer assets/] [--lazy extras/] ... [--bundle release.aub]
+ *           [--variant x86-64-v3=v3/YourApp.exe] ...
+ * ```
+ * Files under a `--defer` prefix are marked `"Priority": "deferred"`, so
+ * clients fetch them after restarting into the new version. Files under a
+ * `--lazy` prefix are marked `"Priority": "lazy"` and only fetched when the
+ * application asks for them.
+ *
+ * Each `--variant REQUIRES=PATH` publishes a file of the release directory
+ * as a build of the executable for CPUs with the listed features (see
+ * Updater/CpuFeatures.h). Variant files are listed under `Variants` rather
+ * than `Files`, so only hosts that choose them download them. A bundle
+ * carries every variant, and the host applying it picks its build.
+ *
+ * @build
+ * ```
+ * cl /O2 /EHsc /std:c++14 Tools\Publisher.cpp
+ * g++ -O2 -std=c++11 -pthread Tools/Publisher.cpp -o Publisher
+ * ```
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+#include "../Updater/json.hpp"
+#include "../Updater/Blake3.h"
+#include "../Updater/Bundle.h"
+#include "../Updater/Chunker.h"
+#include "../Updater/Manifest.h"
+
+namespace {
+
+using AutoUpdaterLib::Blake3;
+using AutoUpdaterLib::UpdateBundle;
+using AutoUpdaterLib::ChunkEntry;
+using AutoUpdaterLib::ContentChunker;
+using AutoUpdaterLib::CpuFeatures;
+using AutoUpdaterLib::FileEntry;
+using AutoUpdaterLib::UpdateArtifact;
+using AutoUpdaterLib::UpdateManifest;
+
+void logError(const std::string& message) {
+    std::cerr << "[Publisher Error] " << message << std::endl;
+}
+
+void logInfo(const std::string& message) {
+    std::cerr << "[Publisher] " << message << std::endl;
+}
+
+/**
+ * @brief Recursively lists regular files below a directory
+ * @param root Release directory
+ * @param relative Current subdirectory relative to root ('/'-separated)
+ * @param files Receives relative paths
+ * @return false if a directory could not be read
+ */
+bool listFiles(const std::string& root, const std::string& relative, std::vector<std::string>& files) {
+    const std::string directory = relative.empty() ? root : root + "/" + relative;
+#ifdef _WIN32
+    WIN32_FIND_DATAA findData;
+    HANDLE find = FindFirstFileA((directory + "\\*").c_str(), &findData);
+    if (find == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    bool ok = true;
+    do {
+        const std::string name = findData.cFileName;
+        if (name == "." || name == "..") {
+            continue;
+        }
+        const std::string path = relative.empty() ? name : relative + "/" + name;
+        if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+            ok = listFiles(root, path, files) && ok;
+        } else {
+            files.push_back(path);
+        }
+    } while (FindNextFileA(find, &findData));
+    FindClose(find);
+    return ok;
+#else
+    DIR* dir = opendir(directory.c_str());
+    if (!dir) {
+        return false;
+    }
+    bool ok = true;
+    while (dirent* entry = readdir(dir)) {
+        const std::string name = entry->d_name;
+        if (name == "." || name == "..") {
+            continue;
+        }
+        const std::string path = relative.empty() ? name : relative + "/" + name;
+        struct stat info;
+        if (stat((root + "/" + path).c_str(), &info) != 0) {
+            ok = false;
+        } else if (S_ISDIR(info.st_mode)) {
+            ok = listFiles(root, path, files) && ok;
+        } else if (S_ISREG(info.st_mode)) {
+            files.push_back(path);
+        }
+    }
+    closedir(dir);
+    return ok;
+#endif
+}
+
+/**
+ * @brief Percent-encodes a relative path for use in a URL
+ */
+std::string encodePath(const std::string& path) {
+    static const char DIGITS[] = "0123456789ABCDEF";
+    std::string encoded;
+    for (unsigned char c : path) {
+        if (isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~' || c == '/') {
+            encoded.push_back(static_cast<char>(c));
+        } else {
+            encoded.push_back('%');
+            encoded.push_back(DIGITS[c >> 4]);
+            encoded.push_back(DIGITS[c & 0x0F]);
+        }
+    }
+    return encoded;
+}
+
+/**
+ * @brief Hashes and chunks one file in a single streaming pass
+ * @param fullPath File on disk
+ * @param entry Receives size, digest and chunk list
+ * @return false if the file could not be read
+ */
+bool indexFile(const std::string& fullPath, FileEntry& entry) {
+    std::ifstream file(fullPath, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    // Keep at least one maximum-size chunk buffered so every cut sees its full window
+    std::vector<uint8_t> buffer(2 * ContentChunker::MAX_SIZE);
+    size_t buffered = 0;
+    bool eof = false;
+    Blake3 whole;
+    uint64_t total = 0;
+
+    while (!eof || buffered > 0) {
+        if (!eof && buffered < ContentChunker::MAX_SIZE) {
+            file.read(reinterpret_cast<char*>(buffer.data() + buffered),
+                      static_cast<std::streamsize>(buffer.size() - buffered));
+            const size_t got = static_cast<size_t>(file.gcount());
+            if (got == 0 && !file.eof()) {
+                return false;
+            }
+            whole.update(buffer.data() + buffered, got);
+            buffered += got;
+            total += got;
+            eof = file.eof();
+            continue;
+        }
+
+        const size_t length = ContentChunker::nextBoundary(buffer.data(), buffered);
+        Blake3 chunkHash;
+        chunkHash.update(buffer.data(), length);
+
+        ChunkEntry chunk;
+        chunk.size = length;
+        chunk.digest = "blake3:" + chunkHash.hexDigest();
+        entry.chunks.push_back(chunk);
+
+        std::copy(buffer.begin() + static_cast<std::ptrdiff_t>(length),
+                  buffer.begin() + static_cast<std::ptrdiff_t>(buffered), buffer.begin());
+        buffered -= length;
+    }
+
+    entry.size = total;
+    entry.digest = "blake3:" + whole.hexDigest();
+    return true;
+}
+
+uint64_t fileSize(const std::string& path) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    return file.is_open() ? static_cast<uint64_t>(file.tellg()) : 0;
+}
+
+void printUsage() {
+    std::cerr << "Usage: Publisher <release-dir> --version VERSION --base-url URL\n"
+              << "                 [--exe PATH] [--json FILE] [--binary FILE] [--threads N]\n"
+              << "                 [--defer PREFIX]... [--lazy PREFIX]... [--bundle FILE]\n"
+              << "                 [--variant REQUIRES=PATH]...\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printUsage();
+        return 2;
+    }
+
+    std::string root = argv[1];
+    while (root.size() > 1 && (root.back() == '/' || root.back() == '\\')) {
+        root.pop_back();
+    }
+
+    std::string version;
+    std::string baseUrl;
+    std::string exePath;
+    std::string jsonPath = "manifest.json";
+    std::string binaryPath = "manifest.bin";
+    std::string bundlePath;
+    unsigned threads = std::thread::hardware_concurrency();
+    std::vector<std::string> deferredPrefixes;
+    std::vector<std::string> lazyPrefixes;
+    std::vector<std::pair<std::string, std::string>> variantPaths; // Requirements and release path
+
+    for (int i = 2; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            printUsage();
+            return 2;
+        }
+        if (arg == "--version") {
+            version = argv[++i];
+        } else if (arg == "--base-url") {
+            baseUrl = argv[++i];
+        } else if (arg == "--exe") {
+            exePath = argv[++i];
+        } else if (arg == "--json") {
+            jsonPath = argv[++i];
+        } else if (arg == "--binary") {
+            binaryPath = argv[++i];
+        } else if (arg == "--bundle") {
+            bundlePath = argv[++i];
+        } else if (arg == "--variant") {
+            const std::string spec = argv[++i];
+            const size_t equals = spec.find('=');
+            uint64_t mask = 0;
+            if (equals == std::string::npos || !CpuFeatures::parse(spec.substr(0, equals), mask) || mask == 0) {
+                logError("Invalid --variant (expected REQUIRES=PATH with known CPU features): " + spec);
+                return 2;
+            }
+            std::string path = spec.substr(equals + 1);
+            std::replace(path.begin(), path.end(), '\\', '/');
+            variantPaths.emplace_back(spec.substr(0, equals), path);
+        } else if (arg == "--threads") {
+            threads = static_cast<unsigned>(std::stoul(argv[++i]));
+        } else if (arg == "--defer" || arg == "--lazy") {
+            std::string prefix = argv[++i];
+            std::replace(prefix.begin(), prefix.end(), '\\', '/');
+            (arg == "--defer" ? deferredPrefixes : lazyPrefixes).push_back(prefix);
+        } else {
+            printUsage();
+            return 2;
+        }
+    }
+
+    if (version.empty() || baseUrl.empty()) {
+        printUsage();
+        return 2;
+    }
+    while (!baseUrl.empty() && baseUrl.back() == '/') {
+        baseUrl.pop_back();
+    }
+    std::replace(exePath.begin(), exePath.end(), '\\', '/');
+
+    std::vector<std::string> paths;
+    if (!listFiles(root, "", paths)) {
+        logError("Failed to read release directory: " + root);
+        return 1;
+    }
+    std::sort(paths.begin(), paths.end());
+
+    // Variant builds are published apart from the files every host installs
+    std::vector<UpdateArtifact> variants;
+    for (const auto& variantPath : variantPaths) {
+        auto it = std::find(paths.begin(), paths.end(), variantPath.second);
+        FileEntry indexed;
+        if (it == paths.end() || !indexFile(root + "/" + variantPath.second, indexed)) {
+            logError("Variant not found in release: " + variantPath.second);
+            return 2;
+        }
+        paths.erase(it);
+        UpdateArtifact variant;
+        variant.toVersion = version;
+        variant.cpuRequirements = variantPath.first;
+        variant.link = baseUrl + "/" + encodePath(variantPath.second);
+        variant.size = indexed.size;
+        variant.digest = indexed.digest;
+        variants.push_back(variant);
+    }
+    if (paths.empty()) {
+        logError("Release directory is empty: " + root);
+        return 1;
+    }
+
+    if (exePath.empty()) {
+        for (const auto& path : paths) {
+            if (path.find('/') == std::string::npos && path.size() > 4 &&
+                path.compare(path.size() - 4, 4, ".exe") == 0) {
+                if (!exePath.empty()) {
+                    logError("Several executables in the release root; choose one with --exe");
+                    return 2;
+                }
+                exePath = path;
+            }
+        }
+    }
+    if (std::find(paths.begin(), paths.end(), exePath) == paths.end()) {
+        logError(exePath.empty() ? "No executable in the release root; choose one with --exe"
+                                 : "Executable not found in release: " + exePath);
+        return 2;
+    }
+
+    // Largest files first so one big file does not finish last on a single core
+    std::vector<size_t> order(paths.size());
+    std::vector<uint64_t> sizes(paths.size());
+    for (size_t i = 0; i < paths.size(); ++i) {
+        order[i] = i;
+        sizes[i] = fileSize(root + "/" + paths[i]);
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return sizes[a] > sizes[b]; });
+
+    logInfo("Indexing " + std::to_string(paths.size()) + " file(s) on " +
+            std::to_string(threads ? threads : 1) + " thread(s)...");
+
+    std::vector<FileEntry> entries(paths.size());
+    std::atomic<size_t> next(0);
+    std::atomic<bool> failed(false);
+    auto worker = [&]() {
+        for (size_t i = next++; i < order.size() && !failed; i = next++) {
+            const size_t index = order[i];
+            FileEntry& entry = entries[index];
+            entry.path = paths[index];
+            entry.link = baseUrl + "/" + encodePath(paths[index]);
+            if (!indexFile(root + "/" + paths[index], entry)) {
+                logError("Failed to read " + paths[index]);
+                failed = true;
+            }
+        }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads && t < paths.size(); ++t) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : pool) {
+        thread.join();
+    }
+    if (failed) {
+        return 1;
+    }
+
+    for (auto& entry : entries) {
+        if (entry.path == exePath) {
+            continue;
+        }
+        for (const auto& prefix : deferredPrefixes) {
+            if (entry.path.compare(0, prefix.size(), prefix) == 0) {
+                entry.flags = FileEntry::FLAG_DEFERRED;
+            }
+        }
+        // A lazy prefix wins over a deferred one
+        for (const auto& prefix : lazyPrefixes) {
+            if (entry.path.compare(0, prefix.size(), prefix) == 0) {
+                entry.flags = FileEntry::FLAG_LAZY;
+            }
+        }
+    }
+
+    UpdateManifest manifest;
+    manifest.version = version;
+    manifest.files = entries;
+    manifest.variants = variants;
+    for (const auto& entry : entries) {
+        if (entry.path == exePath) {
+            UpdateArtifact image;
+            image.toVersion = version;
+            image.link = entry.link;
+            image.size = entry.size;
+            image.digest = entry.digest;
+            manifest.artifacts.push_back(image);
+            manifest.digest = image.digest;
+        }
+    }
+
+    std::ofstream json(jsonPath, std::ios::binary | std::ios::trunc);
+    json << manifest.toJson().dump(4) << "\n";
+    json.close();
+
+    std::ofstream binary(binaryPath, std::ios::binary | std::ios::trunc);
+    manifest.toBinary(binary);
+    binary.close();
+
+    if (json.fail() || binary.fail()) {
+        logError("Failed to write manifest output");
+        return 1;
+    }
+
+    logInfo("Wrote " + jsonPath + " and " + binaryPath);
+
+    if (!bundlePath.empty()) {
+        std::string error;
+        std::vector<std::string> variantFiles;
+        for (const auto& variantPath : variantPaths) {
+            variantFiles.push_back(variantPath.second);
+        }
+        if (!UpdateBundle::write(bundlePath, manifest, root, variantFiles, error)) {
+            logError(error);
+            return 1;
+        }
+        logInfo("Wrote " + bundlePath);
+    }
+    return 0;
+}
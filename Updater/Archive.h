@@ -0,0 +1,500 @@
+/**
+ * @file Archive.h
+ * @brief Streaming zip extraction with parallel decompression
+ *
+ * @author myexistences
+ * @copyright Copyright (c) 2025 myexistences. All rights reserved.
+ * @license MIT License
+ *
+ * @description
+ * Extracts a zip archive while it is still being downloaded. The download
+ * loop feeds raw bytes in; local file headers are parsed as they arrive,
+ * stored entries are written straight to the staging directory and deflated
+ * entries are handed to a worker pool as soon as their compressed bytes are
+ * complete, so independent entries decompress in parallel with each other
+ * and with the rest of the download. Large compressed entries are spooled to
+ * disk rather than held in memory.
+ *
+ * Entries must carry their sizes in the local header (the default for zip
+ * tools writing to a file); streamed archives that defer sizes to a data
+ * descriptor are rejected, as are encrypted entries and paths that escape
+ * the staging directory.
+ */
+
+#ifndef AUTO_UPDATER_ARCHIVE_H
+#define AUTO_UPDATER_ARCHIVE_H
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+#include "Inflate.h"
+#include "MemoryProfile.h"
+#include "WorkerPool.h"
+
+namespace AutoUpdaterLib {
+
+/**
+ * @class Crc32
+ * @brief Incremental CRC-32 (IEEE 802.3) as used by zip
+ */
+class Crc32 {
+private:
+    uint32_t m_crc = 0xFFFFFFFFu;
+
+    static const uint32_t* table() {
+        struct Table {
+            uint32_t values[256];
+            Table() {
+                for (uint32_t i = 0; i < 256; ++i) {
+                    uint32_t c = i;
+                    for (int k = 0; k < 8; ++k) {
+                        c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                    }
+                    values[i] = c;
+                }
+            }
+        };
+        static const Table crcTable;
+        return crcTable.values;
+    }
+
+public:
+    void update(const uint8_t* data, size_t length) {
+        const uint32_t* t = table();
+        uint32_t crc = m_crc;
+        for (size_t i = 0; i < length; ++i) {
+            crc = t[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        }
+        m_crc = crc;
+    }
+
+    uint32_t value() const {
+        return m_crc ^ 0xFFFFFFFFu;
+    }
+};
+
+/**
+ * @class ZipStreamExtractor
+ * @brief Incremental zip parser that extracts entries into a directory
+ */
+class ZipStreamExtractor {
+private:
+    static constexpr uint32_t LOCAL_HEADER_SIG = 0x04034B50u;
+    static constexpr uint32_t CENTRAL_HEADER_SIG = 0x02014B50u;
+    static constexpr uint32_t END_OF_CENTRAL_SIG = 0x06054B50u;
+    static constexpr size_t LOCAL_HEADER_SIZE = 30;
+    // Deflated entries larger than this are spooled to disk instead of memory
+    static constexpr uint64_t SPOOL_THRESHOLD = MemoryProfile::BOUNDED ? 0 : 16 * 1024 * 1024;
+
+    enum class State { Header, Data, Done };
+
+    struct Entry {
+        std::string path;
+        bool isDirectory = false;
+        uint16_t method = 0;
+        uint32_t crc = 0;
+        uint64_t compressedSize = 0;
+        uint64_t size = 0;
+        std::vector<uint8_t> compressed;   // In-memory compressed bytes
+        std::string spoolPath;             // Or a spool file for large entries
+        std::unique_ptr<std::ofstream> out; // Stored entries and spools stream here
+        Crc32 storedCrc;
+    };
+
+    std::string m_directory;
+    WorkerPool& m_pool;
+    State m_state = State::Header;
+    std::vector<uint8_t> m_header;
+    std::shared_ptr<Entry> m_entry;
+    uint64_t m_remaining = 0;
+    size_t m_spoolCount = 0;
+    std::vector<std::string> m_files;
+
+    std::mutex m_errorMutex;
+    std::string m_error;
+
+    static uint16_t le16(const uint8_t* p) {
+        return static_cast<uint16_t>(p[0] | (p[1] << 8));
+    }
+
+    static uint32_t le32(const uint8_t* p) {
+        return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+               (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+    }
+
+    static uint64_t le64(const uint8_t* p) {
+        return static_cast<uint64_t>(le32(p)) | (static_cast<uint64_t>(le32(p + 4)) << 32);
+    }
+
+    bool fail(const std::string& message) {
+        std::lock_guard<std::mutex> lock(m_errorMutex);
+        if (m_error.empty()) {
+            m_error = message;
+        }
+        return false;
+    }
+
+    bool failed() {
+        std::lock_guard<std::mutex> lock(m_errorMutex);
+        return !m_error.empty();
+    }
+
+    static char separator() {
+#ifdef _WIN32
+        return '\\';
+#else
+        return '/';
+#endif
+    }
+
+    static bool makeDirectory(const std::string& path) {
+#ifdef _WIN32
+        return CreateDirectoryA(path.c_str(), nullptr) || GetLastError() == ERROR_ALREADY_EXISTS;
+#else
+        return mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+#endif
+    }
+
+    /**
+     * @brief Validates an entry name and maps it below the extraction directory
+     * @return Local path, or empty string if the name is unsafe
+     */
+    std::string localPath(const std::string& name) const {
+        if (name.empty() || name[0] == '/' || name[0] == '\\' || name.find(':') != std::string::npos) {
+            return std::string();
+        }
+
+        std::string path = m_directory;
+        size_t start = 0;
+        while (start <= name.size()) {
+            size_t end = name.find_first_of("/\\", start);
+            if (end == std::string::npos) end = name.size();
+            const std::string component = name.substr(start, end - start);
+            if (component == "..") {
+                return std::string();
+            }
+            if (!component.empty() && component != ".") {
+                path += separator() + component;
+            }
+            start = end + 1;
+        }
+        return path;
+    }
+
+    /**
+     * @brief Creates every missing directory on the way to a file
+     */
+    bool makeParents(const std::string& filePath) const {
+        for (size_t pos = m_directory.size() + 1; pos < filePath.size(); ++pos) {
+            if (filePath[pos] == separator() && !makeDirectory(filePath.substr(0, pos))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool beginEntry() {
+        const uint8_t* h = m_header.data();
+        const uint16_t flags = le16(h + 6);
+        const uint16_t nameLen = le16(h + 26);
+        const uint16_t extraLen = le16(h + 28);
+
+        auto entry = std::make_shared<Entry>();
+        entry->method = le16(h + 8);
+        entry->crc = le32(h + 14);
+        entry->compressedSize = le32(h + 18);
+        entry->size = le32(h + 22);
+        const std::string name(reinterpret_cast<const char*>(h + LOCAL_HEADER_SIZE), nameLen);
+
+        // Zip64 sizes live in extra field 0x0001 when the header fields are saturated
+        const uint8_t* extra = h + LOCAL_HEADER_SIZE + nameLen;
+        for (size_t pos = 0; pos + 4 <= extraLen;) {
+            const uint16_t id = le16(extra + pos);
+            const uint16_t size = le16(extra + pos + 2);
+            if (id == 0x0001) {
+                const size_t end = std::min<size_t>(pos + 4 + size, extraLen);
+                size_t field = pos + 4;
+                if (entry->size == 0xFFFFFFFFu && field + 8 <= end) {
+                    entry->size = le64(extra + field);
+                    field += 8;
+                }
+                if (entry->compressedSize == 0xFFFFFFFFu && field + 8 <= end) {
+                    entry->compressedSize = le64(extra + field);
+                }
+            }
+            pos += 4 + size;
+        }
+
+        if (flags & 0x0001) {
+            return fail("Encrypted archive entries are not supported: " + name);
+        }
+        if (flags & 0x0008) {
+            return fail("Archive entries without sizes in the local header are not supported: " + name);
+        }
+        if (entry->method != 0 && entry->method != 8) {
+            return fail("Unsupported compression method " + std::to_string(entry->method) + " for " + name);
+        }
+
+        entry->path = localPath(name);
+        if (entry->path.empty()) {
+            return fail("Unsafe path in archive: " + name);
+        }
+
+        entry->isDirectory = name.back() == '/' || name.back() == '\\';
+        if (entry->isDirectory) {
+            if (!makeParents(entry->path + separator()) || !makeDirectory(entry->path)) {
+                return fail("Failed to create directory: " + entry->path);
+            }
+        } else {
+            if (!makeParents(entry->path)) {
+                return fail("Failed to create directory for: " + entry->path);
+            }
+            m_files.push_back(entry->path);
+
+            if (entry->method == 0) {
+                entry->out.reset(new std::ofstream(entry->path, std::ios::binary | std::ios::trunc));
+            } else if (entry->compressedSize > SPOOL_THRESHOLD) {
+                entry->spoolPath = m_directory + separator() + ".spool_" + std::to_string(m_spoolCount++);
+                entry->out.reset(new std::ofstream(entry->spoolPath, std::ios::binary | std::ios::trunc));
+            } else {
+                entry->compressed.reserve(static_cast<size_t>(entry->compressedSize));
+            }
+            if (entry->out && !entry->out->is_open()) {
+                return fail("Failed to create file: " + (entry->spoolPath.empty() ? entry->path : entry->spoolPath));
+            }
+        }
+
+        m_entry = entry;
+        m_remaining = entry->compressedSize;
+        m_state = State::Data;
+        return m_remaining > 0 || finishEntry();
+    }
+
+    bool entryData(const uint8_t* data, size_t length) {
+        Entry& entry = *m_entry;
+        if (entry.method == 0) {
+            entry.storedCrc.update(data, length);
+        }
+        if (entry.out) {
+            entry.out->write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(length));
+            if (entry.out->fail()) {
+                return fail("Failed to write to file: " + entry.path);
+            }
+        } else {
+            entry.compressed.insert(entry.compressed.end(), data, data + length);
+        }
+        return true;
+    }
+
+    bool finishEntry() {
+        std::shared_ptr<Entry> entry = m_entry;
+        m_entry.reset();
+        m_state = State::Header;
+        m_header.clear();
+
+        if (entry->isDirectory) {
+            return true;
+        }
+
+        if (entry->out) {
+            entry->out->close();
+            if (entry->out->fail()) {
+                return fail("Failed to write to file: " + entry->path);
+            }
+            entry->out.reset();
+        }
+
+        if (entry->method == 0) {
+            if (entry->storedCrc.value() != entry->crc) {
+                return fail("CRC mismatch in archive entry: " + entry->path);
+            }
+            return true;
+        }
+
+        // Deflated: decompress on the pool while the download continues
+        m_pool.submit([this, entry]() { inflateEntry(*entry); },
+                      static_cast<size_t>(entry->compressed.size()));
+        return true;
+    }
+
+    void inflateEntry(Entry& entry) {
+        if (failed()) {
+            return;
+        }
+
+        std::ifstream spool;
+        size_t memoryPos = 0;
+        if (!entry.spoolPath.empty()) {
+            spool.open(entry.spoolPath, std::ios::binary);
+            if (!spool.is_open()) {
+                fail("Failed to reopen spool file for " + entry.path);
+                return;
+            }
+        }
+
+        std::ofstream out(entry.path, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            fail("Failed to create file: " + entry.path);
+            return;
+        }
+
+        Crc32 crc;
+        uint64_t written = 0;
+        Inflater inflater;
+        const bool ok = inflater.inflate(
+            [&](uint8_t* buffer, size_t capacity) -> size_t {
+                if (spool.is_open()) {
+                    spool.read(reinterpret_cast<char*>(buffer), static_cast<std::streamsize>(capacity));
+                    return static_cast<size_t>(spool.gcount());
+                }
+                const size_t count = std::min(capacity, entry.compressed.size() - memoryPos);
+                std::memcpy(buffer, entry.compressed.data() + memoryPos, count);
+                memoryPos += count;
+                return count;
+            },
+            [&](const uint8_t* data, size_t length) {
+                crc.update(data, length);
+                written += length;
+                out.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(length));
+                return !out.fail();
+            });
+        out.close();
+
+        if (spool.is_open()) {
+            spool.close();
+            std::remove(entry.spoolPath.c_str());
+        }
+        std::vector<uint8_t>().swap(entry.compressed);
+
+        if (!ok) {
+            fail("Failed to decompress " + entry.path + ": " + inflater.lastError());
+        } else if (out.fail()) {
+            fail("Failed to write to file: " + entry.path);
+        } else if (written != entry.size || crc.value() != entry.crc) {
+            fail("CRC mismatch in archive entry: " + entry.path);
+        }
+    }
+
+public:
+    /**
+     * @brief Prepares extraction into an existing directory
+     * @param directory Destination (staging) directory
+     * @param pool Pool that decompresses deflated entries
+     */
+    ZipStreamExtractor(const std::string& directory, WorkerPool& pool)
+        : m_directory(directory), m_pool(pool) {}
+
+    ~ZipStreamExtractor() {
+        // Pool jobs reference this extractor
+        m_pool.wait();
+    }
+
+    /**
+     * @brief Consumes the next piece of the archive
+     * @param data Bytes exactly as downloaded
+     * @param length Number of bytes
+     * @return false once the archive is known to be invalid
+     */
+    bool feed(const uint8_t* data, size_t length) {
+        while (length > 0) {
+            if (failed()) {
+                return false;
+            }
+
+            if (m_state == State::Done) {
+                return true; // Central directory: nothing left to extract
+            }
+
+            if (m_state == State::Data) {
+                const size_t take = static_cast<size_t>(std::min<uint64_t>(m_remaining, length));
+                if (!entryData(data, take)) {
+                    return false;
+                }
+                data += take;
+                length -= take;
+                m_remaining -= take;
+                if (m_remaining == 0 && !finishEntry()) {
+                    return false;
+                }
+                continue;
+            }
+
+            // Header: collect the fixed part, then the name and extra field
+            size_t wanted = LOCAL_HEADER_SIZE;
+            if (m_header.size() >= 4) {
+                const uint32_t signature = le32(m_header.data());
+                if (signature == CENTRAL_HEADER_SIG || signature == END_OF_CENTRAL_SIG) {
+                    m_state = State::Done;
+                    continue;
+                }
+                if (signature != LOCAL_HEADER_SIG) {
+                    return fail("Not a zip archive or corrupt local header");
+                }
+            }
+            if (m_header.size() >= LOCAL_HEADER_SIZE) {
+                wanted += le16(m_header.data() + 26) + le16(m_header.data() + 28);
+            }
+
+            const size_t missing = wanted - m_header.size();
+            const size_t take = std::min(missing, length);
+            // Take the signature first so the central directory is recognised early
+            const size_t step = m_header.size() < 4 ? std::min(take, 4 - m_header.size()) : take;
+            m_header.insert(m_header.end(), data, data + step);
+            data += step;
+            length -= step;
+
+            if (m_header.size() >= LOCAL_HEADER_SIZE &&
+                m_header.size() == LOCAL_HEADER_SIZE + le16(m_header.data() + 26) + le16(m_header.data() + 28) &&
+                !beginEntry()) {
+                return false;
+            }
+        }
+        return !failed();
+    }
+
+    /**
+     * @brief Waits for outstanding decompression and checks the archive was complete
+     * @return true if every entry was extracted and verified
+     */
+    bool finish() {
+        m_pool.wait();
+        if (failed()) {
+            return false;
+        }
+        if (m_state != State::Done) {
+            return fail("Archive ended before its central directory");
+        }
+        return true;
+    }
+
+    /**
+     * @brief Describes the first error encountered
+     */
+    std::string lastError() {
+        std::lock_guard<std::mutex> lock(m_errorMutex);
+        return m_error;
+    }
+
+    /**
+     * @brief Local paths of the files extracted so far
+     */
+    const std::vector<std::string>& files() const {
+        return m_files;
+    }
+};
+
+} // namespace AutoUpdaterLib
+
+#endif // AUTO_UPDATER_ARCHIVE_H
@@ -0,0 +1,651 @@
+/**
+ * @file Blake3.h
+ * @brief Portable BLAKE3 hasher with SIMD chunk hashing and multi-threaded tree hashing
+ *
+ * @author myexistences
+ * @copyright Copyright (c) 2025 myexistences. All rights reserved.
+ * @license MIT License
+ *
+ * @description
+ * Header-only implementation of the BLAKE3 hash function (default hashing
+ * mode, 256-bit output). BLAKE3 hashes its input as a binary tree of 1 KiB
+ * chunks, so unlike SHA-256 a single large file can be hashed on every core:
+ * the file is split into aligned power-of-two subtrees that are hashed by
+ * worker threads and then merged. Within a thread, four chunks are
+ * compressed side by side with SSE2 when the compiler targets it.
+ *
+ * @usage
+ * ```cpp
+ * std::string digest = AutoUpdaterLib::Blake3::hashFile("payload.bin");
+ * ```
+ */
+
+#ifndef AUTO_UPDATER_BLAKE3_H
+#define AUTO_UPDATER_BLAKE3_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "MemoryProfile.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AUTO_UPDATER_BLAKE3_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace AutoUpdaterLib {
+
+namespace blake3_detail {
+
+static constexpr size_t OUT_LEN = 32;
+static constexpr size_t BLOCK_LEN = 64;
+static constexpr size_t CHUNK_LEN = 1024;
+
+static constexpr uint32_t CHUNK_START = 1u << 0;
+static constexpr uint32_t CHUNK_END = 1u << 1;
+static constexpr uint32_t PARENT = 1u << 2;
+static constexpr uint32_t ROOT = 1u << 3;
+
+inline const uint32_t* iv() {
+    static const uint32_t IV[8] = {
+        0x6A09E667u, 0xBB67AE85u, 0x3C6EF372u, 0xA54FF53Au,
+        0x510E527Fu, 0x9B05688Cu, 0x1F83D9ABu, 0x5BE0CD19u
+    };
+    return IV;
+}
+
+inline const uint8_t* messageSchedule(size_t round) {
+    static const uint8_t SCHEDULE[7][16] = {
+        {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+        {2, 6, 3, 10, 7, 0, 4, 13, 1, 11, 12, 5, 9, 14, 15, 8},
+        {3, 4, 10, 12, 13, 2, 7, 14, 6, 5, 9, 0, 11, 15, 8, 1},
+        {10, 7, 12, 9, 14, 3, 13, 15, 4, 0, 11, 2, 5, 8, 1, 6},
+        {12, 13, 9, 11, 15, 10, 14, 8, 7, 2, 5, 3, 0, 1, 6, 4},
+        {9, 14, 11, 5, 8, 12, 15, 1, 13, 3, 0, 10, 2, 6, 4, 7},
+        {11, 15, 5, 0, 1, 9, 8, 6, 14, 10, 2, 12, 3, 4, 7, 13}
+    };
+    return SCHEDULE[round];
+}
+
+inline uint32_t load32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+inline void store32(uint8_t* p, uint32_t w) {
+    p[0] = static_cast<uint8_t>(w);
+    p[1] = static_cast<uint8_t>(w >> 8);
+    p[2] = static_cast<uint8_t>(w >> 16);
+    p[3] = static_cast<uint8_t>(w >> 24);
+}
+
+inline uint32_t rotr32(uint32_t w, unsigned c) {
+    return (w >> c) | (w << (32 - c));
+}
+
+inline void g(uint32_t* s, size_t a, size_t b, size_t c, size_t d, uint32_t x, uint32_t y) {
+    s[a] = s[a] + s[b] + x;
+    s[d] = rotr32(s[d] ^ s[a], 16);
+    s[c] = s[c] + s[d];
+    s[b] = rotr32(s[b] ^ s[c], 12);
+    s[a] = s[a] + s[b] + y;
+    s[d] = rotr32(s[d] ^ s[a], 8);
+    s[c] = s[c] + s[d];
+    s[b] = rotr32(s[b] ^ s[c], 7);
+}
+
+/**
+ * @brief BLAKE3 compression function
+ * @param cv Input chaining value (8 words)
+ * @param block Message block (16 words)
+ * @param counter Chunk counter or zero for parent nodes
+ * @param blockLen Number of meaningful bytes in the block
+ * @param flags Domain separation flags
+ * @param out Receives the full 16-word output state
+ */
+inline void compress(const uint32_t cv[8], const uint32_t block[16], uint64_t counter,
+                     uint32_t blockLen, uint32_t flags, uint32_t out[16]) {
+    const uint32_t* IV = iv();
+    uint32_t s[16] = {
+        cv[0], cv[1], cv[2], cv[3], cv[4], cv[5], cv[6], cv[7],
+        IV[0], IV[1], IV[2], IV[3],
+        static_cast<uint32_t>(counter), static_cast<uint32_t>(counter >> 32), blockLen, flags
+    };
+
+    for (size_t r = 0; r < 7; ++r) {
+        const uint8_t* m = messageSchedule(r);
+        g(s, 0, 4, 8, 12, block[m[0]], block[m[1]]);
+        g(s, 1, 5, 9, 13, block[m[2]], block[m[3]]);
+        g(s, 2, 6, 10, 14, block[m[4]], block[m[5]]);
+        g(s, 3, 7, 11, 15, block[m[6]], block[m[7]]);
+        g(s, 0, 5, 10, 15, block[m[8]], block[m[9]]);
+        g(s, 1, 6, 11, 12, block[m[10]], block[m[11]]);
+        g(s, 2, 7, 8, 13, block[m[12]], block[m[13]]);
+        g(s, 3, 4, 9, 14, block[m[14]], block[m[15]]);
+    }
+
+    for (size_t i = 0; i < 8; ++i) {
+        out[i] = s[i] ^ s[i + 8];
+        out[i + 8] = s[i + 8] ^ cv[i];
+    }
+}
+
+inline void loadBlockWords(const uint8_t* bytes, uint32_t words[16]) {
+    for (size_t i = 0; i < 16; ++i) {
+        words[i] = load32(bytes + 4 * i);
+    }
+}
+
+#ifdef AUTO_UPDATER_BLAKE3_SSE2
+
+inline __m128i rotr16(__m128i x) { return _mm_or_si128(_mm_srli_epi32(x, 16), _mm_slli_epi32(x, 16)); }
+inline __m128i rotr12(__m128i x) { return _mm_or_si128(_mm_srli_epi32(x, 12), _mm_slli_epi32(x, 20)); }
+inline __m128i rotr8(__m128i x) { return _mm_or_si128(_mm_srli_epi32(x, 8), _mm_slli_epi32(x, 24)); }
+inline __m128i rotr7(__m128i x) { return _mm_or_si128(_mm_srli_epi32(x, 7), _mm_slli_epi32(x, 25)); }
+
+inline void g4(__m128i* v, size_t a, size_t b, size_t c, size_t d, __m128i x, __m128i y) {
+    v[a] = _mm_add_epi32(_mm_add_epi32(v[a], v[b]), x);
+    v[d] = rotr16(_mm_xor_si128(v[d], v[a]));
+    v[c] = _mm_add_epi32(v[c], v[d]);
+    v[b] = rotr12(_mm_xor_si128(v[b], v[c]));
+    v[a] = _mm_add_epi32(_mm_add_epi32(v[a], v[b]), y);
+    v[d] = rotr8(_mm_xor_si128(v[d], v[a]));
+    v[c] = _mm_add_epi32(v[c], v[d]);
+    v[b] = rotr7(_mm_xor_si128(v[b], v[c]));
+}
+
+/**
+ * @brief Hashes four consecutive full chunks in parallel SSE2 lanes
+ * @param input Pointer to 4 * CHUNK_LEN bytes
+ * @param key Key words (IV in the default hashing mode)
+ * @param counter Chunk counter of the first chunk
+ * @param cvs Receives the four chunk chaining values
+ */
+inline void hashFourChunks(const uint8_t* input, const uint32_t key[8], uint64_t counter,
+                           uint32_t cvs[4][8]) {
+    const uint32_t* IV = iv();
+    __m128i h[8];
+    for (size_t i = 0; i < 8; ++i) {
+        h[i] = _mm_set1_epi32(static_cast<int>(key[i]));
+    }
+
+    const __m128i counterLow = _mm_set_epi32(
+        static_cast<int>(static_cast<uint32_t>(counter + 3)), static_cast<int>(static_cast<uint32_t>(counter + 2)),
+        static_cast<int>(static_cast<uint32_t>(counter + 1)), static_cast<int>(static_cast<uint32_t>(counter)));
+    const __m128i counterHigh = _mm_set_epi32(
+        static_cast<int>(static_cast<uint32_t>((counter + 3) >> 32)), static_cast<int>(static_cast<uint32_t>((counter + 2) >> 32)),
+        static_cast<int>(static_cast<uint32_t>((counter + 1) >> 32)), static_cast<int>(static_cast<uint32_t>(counter >> 32)));
+
+    for (size_t blockIndex = 0; blockIndex < CHUNK_LEN / BLOCK_LEN; ++blockIndex) {
+        uint32_t flags = 0;
+        if (blockIndex == 0) flags |= CHUNK_START;
+        if (blockIndex == CHUNK_LEN / BLOCK_LEN - 1) flags |= CHUNK_END;
+
+        __m128i m[16];
+        for (size_t w = 0; w < 16; ++w) {
+            const size_t offset = blockIndex * BLOCK_LEN + 4 * w;
+            m[w] = _mm_set_epi32(
+                static_cast<int>(load32(input + 3 * CHUNK_LEN + offset)),
+                static_cast<int>(load32(input + 2 * CHUNK_LEN + offset)),
+                static_cast<int>(load32(input + 1 * CHUNK_LEN + offset)),
+                static_cast<int>(load32(input + offset)));
+        }
+
+        __m128i v[16] = {
+            h[0], h[1], h[2], h[3], h[4], h[5], h[6], h[7],
+            _mm_set1_epi32(static_cast<int>(IV[0])), _mm_set1_epi32(static_cast<int>(IV[1])),
+            _mm_set1_epi32(static_cast<int>(IV[2])), _mm_set1_epi32(static_cast<int>(IV[3])),
+            counterLow, counterHigh,
+            _mm_set1_epi32(static_cast<int>(BLOCK_LEN)), _mm_set1_epi32(static_cast<int>(flags))
+        };
+
+        for (size_t r = 0; r < 7; ++r) {
+            const uint8_t* s = messageSchedule(r);
+            g4(v, 0, 4, 8, 12, m[s[0]], m[s[1]]);
+            g4(v, 1, 5, 9, 13, m[s[2]], m[s[3]]);
+            g4(v, 2, 6, 10, 14, m[s[4]], m[s[5]]);
+            g4(v, 3, 7, 11, 15, m[s[6]], m[s[7]]);
+            g4(v, 0, 5, 10, 15, m[s[8]], m[s[9]]);
+            g4(v, 1, 6, 11, 12, m[s[10]], m[s[11]]);
+            g4(v, 2, 7, 8, 13, m[s[12]], m[s[13]]);
+            g4(v, 3, 4, 9, 14, m[s[14]], m[s[15]]);
+        }
+
+        for (size_t i = 0; i < 8; ++i) {
+            h[i] = _mm_xor_si128(v[i], v[i + 8]);
+        }
+    }
+
+    for (size_t i = 0; i < 8; ++i) {
+        alignas(16) uint32_t lanes[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), h[i]);
+        for (size_t lane = 0; lane < 4; ++lane) {
+            cvs[lane][i] = lanes[lane];
+        }
+    }
+}
+
+#endif // AUTO_UPDATER_BLAKE3_SSE2
+
+/**
+ * @brief Pending compression of a chunk or parent node
+ *
+ * The final node of a (sub)tree is kept in this form so the caller can
+ * decide whether it is the root of the whole input or merely a subtree.
+ */
+struct Output {
+    uint32_t inputCv[8];
+    uint32_t block[16];
+    uint64_t counter;
+    uint32_t blockLen;
+    uint32_t flags;
+
+    void chainingValue(uint32_t cv[8]) const {
+        uint32_t out[16];
+        compress(inputCv, block, counter, blockLen, flags, out);
+        std::memcpy(cv, out, 8 * sizeof(uint32_t));
+    }
+
+    void rootBytes(uint8_t digest[OUT_LEN]) const {
+        uint32_t out[16];
+        compress(inputCv, block, 0, blockLen, flags | ROOT, out);
+        for (size_t i = 0; i < OUT_LEN / 4; ++i) {
+            store32(digest + 4 * i, out[i]);
+        }
+    }
+};
+
+inline Output parentOutput(const uint32_t left[8], const uint32_t right[8], const uint32_t key[8]) {
+    Output output;
+    std::memcpy(output.inputCv, key, sizeof(output.inputCv));
+    std::memcpy(output.block, left, 8 * sizeof(uint32_t));
+    std::memcpy(output.block + 8, right, 8 * sizeof(uint32_t));
+    output.counter = 0;
+    output.blockLen = BLOCK_LEN;
+    output.flags = PARENT;
+    return output;
+}
+
+/**
+ * @class ChunkState
+ * @brief Incremental state for a single 1 KiB chunk
+ */
+class ChunkState {
+private:
+    uint32_t m_cv[8];
+    uint64_t m_chunkCounter;
+    uint8_t m_block[BLOCK_LEN];
+    uint32_t m_blockLen;
+    uint32_t m_blocksCompressed;
+
+    uint32_t startFlag() const {
+        return m_blocksCompressed == 0 ? CHUNK_START : 0;
+    }
+
+public:
+    ChunkState(const uint32_t key[8], uint64_t chunkCounter) {
+        reset(key, chunkCounter);
+    }
+
+    void reset(const uint32_t key[8], uint64_t chunkCounter) {
+        std::memcpy(m_cv, key, sizeof(m_cv));
+        m_chunkCounter = chunkCounter;
+        std::memset(m_block, 0, sizeof(m_block));
+        m_blockLen = 0;
+        m_blocksCompressed = 0;
+    }
+
+    size_t length() const {
+        return BLOCK_LEN * m_blocksCompressed + m_blockLen;
+    }
+
+    uint64_t counter() const {
+        return m_chunkCounter;
+    }
+
+    void update(const uint8_t* input, size_t inputLen) {
+        while (inputLen > 0) {
+            // Only compress a full block once more input proves it is not the chunk's last
+            if (m_blockLen == BLOCK_LEN) {
+                uint32_t words[16];
+                uint32_t out[16];
+                loadBlockWords(m_block, words);
+                compress(m_cv, words, m_chunkCounter, BLOCK_LEN, startFlag(), out);
+                std::memcpy(m_cv, out, sizeof(m_cv));
+                ++m_blocksCompressed;
+                std::memset(m_block, 0, sizeof(m_block));
+                m_blockLen = 0;
+            }
+
+            const size_t want = BLOCK_LEN - m_blockLen;
+            const size_t take = inputLen < want ? inputLen : want;
+            std::memcpy(m_block + m_blockLen, input, take);
+            m_blockLen += static_cast<uint32_t>(take);
+            input += take;
+            inputLen -= take;
+        }
+    }
+
+    Output output() const {
+        Output output;
+        std::memcpy(output.inputCv, m_cv, sizeof(m_cv));
+        loadBlockWords(m_block, output.block);
+        output.counter = m_chunkCounter;
+        output.blockLen = m_blockLen;
+        output.flags = startFlag() | CHUNK_END;
+        return output;
+    }
+};
+
+} // namespace blake3_detail
+
+/**
+ * @class Blake3
+ * @brief Incremental BLAKE3 hasher with a parallel whole-file entry point
+ */
+class Blake3 {
+public:
+    static constexpr size_t DIGEST_SIZE = blake3_detail::OUT_LEN;
+
+    /**
+     * @brief Constructs a hasher for a complete input
+     */
+    Blake3() : Blake3(0) {}
+
+    /**
+     * @brief Feeds more input into the hasher
+     * @param data Pointer to the input bytes
+     * @param length Number of bytes to hash
+     */
+    void update(const void* data, size_t length) {
+        using namespace blake3_detail;
+        const uint8_t* input = static_cast<const uint8_t*>(data);
+
+        while (length > 0) {
+            if (m_chunkState.length() == CHUNK_LEN) {
+                uint32_t cv[8];
+                m_chunkState.output().chainingValue(cv);
+                const uint64_t nextCounter = m_chunkState.counter() + 1;
+                addChunkChainingValue(cv);
+                m_chunkState.reset(m_key, nextCounter);
+            }
+
+#ifdef AUTO_UPDATER_BLAKE3_SSE2
+            // Whole chunks that are provably not the last one bypass the chunk state
+            while (m_chunkState.length() == 0 && length > 4 * CHUNK_LEN) {
+                uint32_t cvs[4][8];
+                hashFourChunks(input, m_key, m_chunkState.counter(), cvs);
+                for (size_t i = 0; i < 4; ++i) {
+                    addChunkChainingValue(cvs[i]);
+                }
+                m_chunkState.reset(m_key, m_chunkState.counter() + 4);
+                input += 4 * CHUNK_LEN;
+                length -= 4 * CHUNK_LEN;
+            }
+#endif
+
+            const size_t want = CHUNK_LEN - m_chunkState.length();
+            const size_t take = length < want ? length : want;
+            m_chunkState.update(input, take);
+            input += take;
+            length -= take;
+        }
+    }
+
+    /**
+     * @brief Produces the 32-byte digest of everything hashed so far
+     * @param digest Output buffer of DIGEST_SIZE bytes
+     */
+    void finalize(uint8_t digest[DIGEST_SIZE]) const {
+        finalOutput().rootBytes(digest);
+    }
+
+    /**
+     * @brief Produces the digest as a lowercase hex string
+     * @return 64-character hex digest
+     */
+    std::string hexDigest() const {
+        uint8_t digest[DIGEST_SIZE];
+        finalize(digest);
+        return toHex(digest, DIGEST_SIZE);
+    }
+
+    /**
+     * @brief Hashes an in-memory buffer, splitting the tree across threads
+     * @param data Pointer to the input bytes
+     * @param length Number of bytes to hash
+     * @param threads Worker count, or 0 to use every hardware thread
+     * @return 64-character hex digest
+     */
+    static std::string hashBuffer(const void* data, size_t length, unsigned threads = 0) {
+        return hashSubtrees(static_cast<uint64_t>(length), threads,
+                            MemoryReader(static_cast<const uint8_t*>(data)));
+    }
+
+    /**
+     * @brief Hashes a file on disk, splitting the tree across threads
+     * @param path File to hash
+     * @param threads Worker count, or 0 to use every hardware thread
+     * @return 64-character hex digest, or empty string if the file cannot be read
+     *
+     * The bounded-memory build hashes on the calling thread through one
+     * small buffer instead, ignoring threads.
+     */
+    static std::string hashFile(const std::string& path, unsigned threads = 0) {
+        if (MemoryProfile::BOUNDED) {
+            return hashSequential(path);
+        }
+        std::ifstream probe(path, std::ios::binary | std::ios::ate);
+        if (!probe.is_open()) {
+            return std::string();
+        }
+        const uint64_t fileSize = static_cast<uint64_t>(probe.tellg());
+        probe.close();
+
+        return hashSubtrees(fileSize, threads, FileReader(path));
+    }
+
+    /**
+     * @brief Converts raw bytes to a lowercase hex string
+     */
+    static std::string toHex(const uint8_t* bytes, size_t length) {
+        static const char DIGITS[] = "0123456789abcdef";
+        std::string hex;
+        hex.reserve(length * 2);
+        for (size_t i = 0; i < length; ++i) {
+            hex.push_back(DIGITS[bytes[i] >> 4]);
+            hex.push_back(DIGITS[bytes[i] & 0x0F]);
+        }
+        return hex;
+    }
+
+private:
+    // Subtree handed to one worker at a time: 1 MiB, a power of two of chunks
+    static constexpr size_t SUBTREE_LEN = 1024 * blake3_detail::CHUNK_LEN;
+    static constexpr size_t MAX_DEPTH = 54;
+
+    uint32_t m_key[8];
+    blake3_detail::ChunkState m_chunkState;
+    uint32_t m_cvStack[MAX_DEPTH][8];
+    size_t m_cvStackLen;
+    uint64_t m_chunksAdded;
+
+    struct ChainingValue {
+        uint32_t words[8];
+    };
+
+    /**
+     * @brief Input source that hands out views into caller-owned memory
+     */
+    struct MemoryReader {
+        const uint8_t* bytes;
+
+        explicit MemoryReader(const uint8_t* data) : bytes(data) {}
+
+        const uint8_t* view(uint64_t offset, size_t, uint8_t*) {
+            return bytes + offset;
+        }
+    };
+
+    /**
+     * @brief Input source that reads a file; each worker copy opens its own stream
+     */
+    struct FileReader {
+        std::string path;
+        std::ifstream stream;
+
+        explicit FileReader(const std::string& filePath) : path(filePath) {}
+        FileReader(const FileReader& other) : path(other.path) {}
+
+        const uint8_t* view(uint64_t offset, size_t size, uint8_t* buffer) {
+            if (!stream.is_open()) {
+                stream.open(path, std::ios::binary);
+            }
+            stream.clear();
+            stream.seekg(static_cast<std::streamoff>(offset));
+            stream.read(reinterpret_cast<char*>(buffer), static_cast<std::streamsize>(size));
+            return static_cast<size_t>(stream.gcount()) == size ? buffer : nullptr;
+        }
+    };
+
+    static std::string hashSequential(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) {
+            return std::string();
+        }
+        Blake3 hasher;
+        std::vector<char> buffer(MemoryProfile::IO_BUFFER_SIZE);
+        while (file) {
+            file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            hasher.update(buffer.data(), static_cast<size_t>(file.gcount()));
+        }
+        return file.bad() ? std::string() : hasher.hexDigest();
+    }
+
+    /**
+     * @brief Constructs a hasher for a subtree starting at the given chunk
+     * @param firstChunk Absolute counter of the subtree's first chunk
+     */
+    explicit Blake3(uint64_t firstChunk)
+        : m_chunkState(blake3_detail::iv(), firstChunk), m_cvStackLen(0), m_chunksAdded(0) {
+        std::memcpy(m_key, blake3_detail::iv(), sizeof(m_key));
+    }
+
+    /**
+     * @brief Pushes a completed chunk and merges completed subtrees
+     *
+     * Merging is driven by the number of chunks added to this hasher, not the
+     * absolute counter, so a hasher started mid-input yields that subtree.
+     */
+    void addChunkChainingValue(const uint32_t cv[8]) {
+        uint32_t merged[8];
+        std::memcpy(merged, cv, sizeof(merged));
+        uint64_t totalChunks = ++m_chunksAdded;
+        while ((totalChunks & 1) == 0) {
+            --m_cvStackLen;
+            blake3_detail::parentOutput(m_cvStack[m_cvStackLen], merged, m_key).chainingValue(merged);
+            totalChunks >>= 1;
+        }
+        std::memcpy(m_cvStack[m_cvStackLen++], merged, sizeof(merged));
+    }
+
+    blake3_detail::Output finalOutput() const {
+        uint32_t cv[8];
+        blake3_detail::Output output = m_chunkState.output();
+        for (size_t i = m_cvStackLen; i > 0; --i) {
+            output.chainingValue(cv);
+            output = blake3_detail::parentOutput(m_cvStack[i - 1], cv, m_key);
+        }
+        return output;
+    }
+
+    /**
+     * @brief Hashes fixed-size subtrees on worker threads and merges them
+     * @param length Total input length
+     * @param threads Requested worker count (0 = hardware concurrency)
+     * @param source Input source, copied once per worker
+     * @return Hex digest, or empty string if any read failed
+     */
+    template <typename Reader>
+    static std::string hashSubtrees(uint64_t length, unsigned threads, const Reader& source) {
+        const uint64_t subtreeLen = SUBTREE_LEN;
+        const uint64_t subtreeCount = length == 0 ? 1 : (length + subtreeLen - 1) / subtreeLen;
+
+        if (threads == 0) {
+            threads = std::thread::hardware_concurrency();
+        }
+        if (threads == 0) {
+            threads = 1;
+        }
+        if (static_cast<uint64_t>(threads) > subtreeCount) {
+            threads = static_cast<unsigned>(subtreeCount);
+        }
+
+        // Every subtree but the last is complete, so only its chaining value is kept
+        std::vector<ChainingValue> cvs(static_cast<size_t>(subtreeCount - 1));
+        blake3_detail::Output lastOutput;
+        std::atomic<uint64_t> next(0);
+        std::atomic<bool> failed(false);
+
+        auto worker = [&]() {
+            Reader reader(source);
+            std::vector<uint8_t> buffer(SUBTREE_LEN);
+            for (uint64_t index = next++; index < subtreeCount && !failed; index = next++) {
+                const uint64_t offset = index * subtreeLen;
+                const size_t size = static_cast<size_t>(
+                    length - offset < subtreeLen ? length - offset : subtreeLen);
+                const uint8_t* bytes = size > 0 ? reader.view(offset, size, buffer.data()) : buffer.data();
+                if (!bytes) {
+                    failed = true;
+                    break;
+                }
+
+                Blake3 subtree(offset / blake3_detail::CHUNK_LEN);
+                subtree.update(bytes, size);
+                if (index + 1 == subtreeCount) {
+                    lastOutput = subtree.finalOutput();
+                } else {
+                    subtree.finalOutput().chainingValue(cvs[static_cast<size_t>(index)].words);
+                }
+            }
+        };
+
+        std::vector<std::thread> pool;
+        for (unsigned i = 1; i < threads; ++i) {
+            pool.emplace_back(worker);
+        }
+        worker();
+        for (auto& thread : pool) {
+            thread.join();
+        }
+
+        if (failed) {
+            return std::string();
+        }
+
+        // Subtrees are equal powers of two, so they merge exactly like chunks do
+        Blake3 root(0);
+        for (const auto& cv : cvs) {
+            root.addChunkChainingValue(cv.words);
+        }
+
+        uint32_t cv[8];
+        blake3_detail::Output output = lastOutput;
+        for (size_t i = root.m_cvStackLen; i > 0; --i) {
+            output.chainingValue(cv);
+            output = blake3_detail::parentOutput(root.m_cvStack[i - 1], cv, root.m_key);
+        }
+
+        uint8_t digest[DIGEST_SIZE];
+        output.rootBytes(digest);
+        return toHex(digest, DIGEST_SIZE);
+    }
+};
+
+} // namespace AutoUpdaterLib
+
+#endif // AUTO_UPDATER_BLAKE3_H
@@ -0,0 +1,522 @@
+/**
+ * @file Bundle.h
+ * @brief Self-describing offline update bundles, read through a memory mapping
+ *
+ * @author myexistences
+ * @copyright Copyright (c) 2025 myexistences. All rights reserved.
+ * @license MIT License
+ *
+ * @description
+ * A bundle carries a whole release in one file for hosts without access to
+ * the update server: the binary manifest (with the chunk index of every
+ * file) and the payload of every file. It is written by
+ * `Publisher --bundle` and applied with AutoUpdater::applyBundle().
+ *
+ * The reader maps the file instead of reading it. The header and the index
+ * sit at fixed offsets, so opening a bundle touches only their pages;
+ * payloads are hashed on worker threads straight from the mapping and
+ * written from it to their destination, without temporary copies.
+ *
+ * @bundle_format
+ * Integers are little-endian. The index starts right after the header.
+ * ```
+ * offset 0   "AUBUNDL1" u64 entryCount u64 manifestOffset u64 manifestSize
+ *            u8[32] headerDigest
+ * offset 64  entryCount { u64 dataOffset u64 dataSize u64 pathOffset u64 pathSize u8[32] digest }
+ *            path bytes
+ *            manifest ("AUMANIF1", see Manifest.h)
+ *            payloads, each starting at a multiple of 4096
+ * ```
+ * headerDigest is the BLAKE3 hash of everything from offset 64 to the end
+ * of the manifest, so a damaged index is rejected before any payload is
+ * trusted. Each entry's digest is the BLAKE3 hash of its payload. Its path
+ * matches a `Files` entry of the manifest, or is the release path of a
+ * `Variants` build, which findContent() locates by the variant's digest.
+ */
+
+#ifndef AUTO_UPDATER_BUNDLE_H
+#define AUTO_UPDATER_BUNDLE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "Blake3.h"
+#include "Manifest.h"
+#include "MemoryProfile.h"
+#include "WorkerPool.h"
+
+namespace AutoUpdaterLib {
+
+/**
+ * @class UpdateBundle
+ * @brief Read-only view of an offline update bundle
+ */
+class UpdateBundle {
+public:
+    static constexpr const char* MAGIC = "AUBUNDL1";
+    static constexpr size_t MAGIC_SIZE = 8;
+    static constexpr uint64_t HEADER_SIZE = 64;
+    static constexpr uint64_t ENTRY_SIZE = 64;
+    static constexpr uint64_t ALIGNMENT = 4096;
+    static constexpr uint64_t PARALLEL_ENTRY_SIZE = 16 * 1024 * 1024; // Larger payloads are hashed on every thread
+
+    /**
+     * @struct Entry
+     * @brief One payload stored in the bundle
+     */
+    struct Entry {
+        std::string path;       ///< '/'-separated path, as in the manifest
+        uint64_t offset = 0;    ///< Start of the payload in the bundle
+        uint64_t size = 0;
+        std::string digest;     ///< "blake3:<hex>" digest of the payload
+    };
+
+    UpdateBundle() = default;
+
+    ~UpdateBundle() {
+        close();
+    }
+
+    UpdateBundle(const UpdateBundle&) = delete;
+    UpdateBundle& operator=(const UpdateBundle&) = delete;
+
+    /**
+     * @brief Maps a bundle and reads its index and manifest
+     * @param path Bundle file
+     * @param error Receives a description when the bundle cannot be used
+     * @param spoolPath File to spool the manifest's file list to, or empty
+     *                  to hold it in memory; see UpdateManifest's @memory_budget
+     * @return true if the header, index and manifest are intact
+     *
+     * Payloads are not read; call verify() before trusting them.
+     */
+    bool open(const std::string& path, std::string& error, const std::string& spoolPath = std::string()) {
+        close();
+        if (!map(path)) {
+            close(); // A partial mapping would keep the bundle locked
+            error = "Failed to map bundle: " + path;
+            return false;
+        }
+        if (!readIndex(error, spoolPath)) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (m_data) {
+            UnmapViewOfFile(m_data);
+        }
+        if (m_mapping) {
+            CloseHandle(m_mapping);
+        }
+        if (m_file != INVALID_HANDLE_VALUE) {
+            CloseHandle(m_file);
+        }
+        m_mapping = nullptr;
+        m_file = INVALID_HANDLE_VALUE;
+#else
+        if (m_data) {
+            munmap(const_cast<uint8_t*>(m_data), static_cast<size_t>(m_size));
+        }
+#endif
+        m_data = nullptr;
+        m_size = 0;
+        m_entries.clear();
+        m_manifest = UpdateManifest();
+    }
+
+    const UpdateManifest& manifest() const { return m_manifest; }
+    const std::vector<Entry>& entries() const { return m_entries; }
+
+    /**
+     * @brief Finds the payload of a manifest file
+     * @return Entry, or nullptr if the bundle does not carry the file
+     */
+    const Entry* find(const std::string& path) const {
+        auto it = std::lower_bound(m_entries.begin(), m_entries.end(), path,
+                                   [](const Entry& entry, const std::string& value) { return entry.path < value; });
+        return it != m_entries.end() && it->path == path ? &*it : nullptr;
+    }
+
+    /**
+     * @brief Finds a payload by its content, e.g. the build of a manifest variant
+     * @param digest "blake3:<hex>" digest of the payload
+     * @return Entry, or nullptr if the bundle does not carry such a payload
+     */
+    const Entry* findContent(const std::string& digest) const {
+        for (const auto& entry : m_entries) {
+            if (entry.digest == digest) {
+                return &entry;
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief Gets the payload bytes inside the mapping
+     */
+    const uint8_t* data(const Entry& entry) const {
+        return m_data + entry.offset;
+    }
+
+    /**
+     * @brief Hashes every payload and compares it with the index
+     * @param threads Worker count, or 0 to use every hardware thread
+     * @param error Receives the first mismatch
+     * @return true if every payload is intact
+     *
+     * Large payloads are hashed one after another with the tree split
+     * across all threads; the rest are spread over a worker pool. The
+     * bounded-memory build hashes on the calling thread.
+     */
+    bool verify(unsigned threads, std::string& error) const {
+        std::atomic<bool> failed(false);
+        std::mutex errorMutex;
+        auto check = [&](const Entry& entry, unsigned hashThreads) {
+            if (failed) {
+                return;
+            }
+            std::string digest;
+            if (MemoryProfile::BOUNDED) {
+                Blake3 hasher;
+                hasher.update(data(entry), static_cast<size_t>(entry.size));
+                digest = hasher.hexDigest();
+            } else {
+                digest = Blake3::hashBuffer(data(entry), static_cast<size_t>(entry.size), hashThreads);
+            }
+            if (BLAKE3_PREFIX + digest != entry.digest) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!failed) {
+                    error = "Bundle payload is damaged: " + entry.path;
+                    failed = true;
+                }
+            }
+        };
+
+        if (MemoryProfile::BOUNDED) {
+            for (const auto& entry : m_entries) {
+                check(entry, 1);
+            }
+            return !failed;
+        }
+
+        std::vector<const Entry*> small;
+        for (const auto& entry : m_entries) {
+            if (entry.size >= PARALLEL_ENTRY_SIZE) {
+                check(entry, threads);
+            } else {
+                small.push_back(&entry);
+            }
+        }
+        if (!small.empty() && !failed) {
+            WorkerPool pool(threads);
+            for (const Entry* entry : small) {
+                pool.submit([&check, entry] { check(*entry, 1); });
+            }
+            pool.wait();
+        }
+        return !failed;
+    }
+
+    /**
+     * @brief Writes a payload to a file straight from the mapping
+     * @param entry Payload to write
+     * @param target File to create or replace
+     * @return true if every byte was written and flushed
+     */
+    bool extract(const Entry& entry, const std::string& target) const {
+        const uint8_t* source = data(entry);
+        uint64_t remaining = entry.size;
+#ifdef _WIN32
+        HANDLE file = CreateFileA(target.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        bool ok = true;
+        while (ok && remaining > 0) {
+            const DWORD slice = static_cast<DWORD>(std::min<uint64_t>(remaining, static_cast<uint64_t>(WRITE_SLICE)));
+            DWORD written = 0;
+            ok = WriteFile(file, source, slice, &written, nullptr) && written == slice;
+            source += slice;
+            remaining -= slice;
+        }
+        ok = ok && FlushFileBuffers(file);
+        CloseHandle(file);
+        return ok;
+#else
+        std::ofstream out(target, std::ios::binary | std::ios::trunc);
+        while (out && remaining > 0) {
+            const size_t slice = static_cast<size_t>(std::min<uint64_t>(remaining, static_cast<uint64_t>(WRITE_SLICE)));
+            out.write(reinterpret_cast<const char*>(source), static_cast<std::streamsize>(slice));
+            source += slice;
+            remaining -= slice;
+        }
+        out.flush();
+        return static_cast<bool>(out);
+#endif
+    }
+
+    /**
+     * @brief Writes a bundle for a release directory
+     * @param path Bundle file to create
+     * @param manifest Manifest of the release; every file and variant needs a BLAKE3 digest
+     * @param root Release directory holding the files of the manifest
+     * @param variantPaths Release path of each of manifest.variants, in the same order
+     * @param error Receives a description on failure
+     * @return true if the bundle was written completely
+     */
+    static bool write(const std::string& path, const UpdateManifest& manifest, const std::string& root,
+                      const std::vector<std::string>& variantPaths, std::string& error) {
+        if (variantPaths.size() != manifest.variants.size()) {
+            error = "Every variant needs a release path";
+            return false;
+        }
+        std::vector<FileEntry> variantFiles;
+        for (size_t i = 0; i < variantPaths.size(); ++i) {
+            FileEntry file;
+            file.path = variantPaths[i];
+            file.size = manifest.variants[i].size;
+            file.digest = manifest.variants[i].digest;
+            variantFiles.push_back(file);
+        }
+        std::vector<const FileEntry*> files;
+        for (const auto& file : manifest.files) {
+            files.push_back(&file);
+        }
+        for (const auto& file : variantFiles) {
+            files.push_back(&file);
+        }
+        std::sort(files.begin(), files.end(), [](const FileEntry* a, const FileEntry* b) { return a->path < b->path; });
+        for (size_t i = 1; i < files.size(); ++i) {
+            if (files[i - 1]->path == files[i]->path) {
+                error = "File is listed twice: " + files[i]->path;
+                return false;
+            }
+        }
+
+        std::ostringstream manifestBytes;
+        manifest.toBinary(manifestBytes);
+        const std::string manifestData = manifestBytes.str();
+
+        // Index, paths and manifest first; payload offsets follow from their sizes
+        std::string index(files.size() * ENTRY_SIZE, '\0');
+        std::string paths;
+        uint64_t pathStart = HEADER_SIZE + index.size();
+        for (const FileEntry* file : files) {
+            paths += file->path;
+        }
+        const uint64_t manifestOffset = pathStart + paths.size();
+        uint64_t offset = alignUp(manifestOffset + manifestData.size());
+        for (size_t i = 0; i < files.size(); ++i) {
+            const FileEntry& file = *files[i];
+            uint8_t digest[Blake3::DIGEST_SIZE];
+            if (file.size == UpdateArtifact::UNKNOWN_SIZE || !parseDigest(file.digest, digest)) {
+                error = "File has no size or BLAKE3 digest: " + file.path;
+                return false;
+            }
+            char* record = &index[i * ENTRY_SIZE];
+            putU64(record, offset);
+            putU64(record + 8, file.size);
+            putU64(record + 16, pathStart);
+            putU64(record + 24, file.path.size());
+            std::memcpy(record + 32, digest, sizeof(digest));
+            pathStart += file.path.size();
+            offset = alignUp(offset + file.size);
+        }
+
+        const std::string described = index + paths + manifestData;
+        Blake3 headerHash;
+        headerHash.update(described.data(), described.size());
+        std::string header(HEADER_SIZE, '\0');
+        std::memcpy(&header[0], MAGIC, MAGIC_SIZE);
+        putU64(&header[8], files.size());
+        putU64(&header[16], manifestOffset);
+        putU64(&header[24], manifestData.size());
+        headerHash.finalize(reinterpret_cast<uint8_t*>(&header[32]));
+
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out << header << described;
+        uint64_t position = HEADER_SIZE + described.size();
+        std::vector<char> buffer(static_cast<size_t>(MemoryProfile::IO_BUFFER_SIZE));
+        for (const FileEntry* file : files) {
+            const uint64_t start = alignUp(position);
+            out << std::string(static_cast<size_t>(start - position), '\0');
+            std::ifstream in(root + "/" + file->path, std::ios::binary);
+            uint64_t copied = 0;
+            while (in && out) {
+                in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+                out.write(buffer.data(), in.gcount());
+                copied += static_cast<uint64_t>(in.gcount());
+            }
+            if (copied != file->size) {
+                error = "Failed to read " + file->path;
+                return false;
+            }
+            position = start + copied;
+        }
+        out.close();
+        if (out.fail()) {
+            error = "Failed to write bundle: " + path;
+            return false;
+        }
+        return true;
+    }
+
+private:
+    static constexpr const char* BLAKE3_PREFIX = "blake3:";
+    static constexpr uint64_t WRITE_SLICE = 1 << 20;
+
+    const uint8_t* m_data = nullptr;
+    uint64_t m_size = 0;
+#ifdef _WIN32
+    HANDLE m_file = INVALID_HANDLE_VALUE;
+    HANDLE m_mapping = nullptr;
+#endif
+    std::vector<Entry> m_entries;   // Sorted by path
+    UpdateManifest m_manifest;
+
+    static uint64_t alignUp(uint64_t value) {
+        return (value + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    }
+
+    static void putU64(char* out, uint64_t value) {
+        for (int i = 0; i < 8; ++i) {
+            out[i] = static_cast<char>(value >> (8 * i));
+        }
+    }
+
+    static uint64_t getU64(const uint8_t* in) {
+        uint64_t value = 0;
+        for (int i = 7; i >= 0; --i) {
+            value = (value << 8) | in[i];
+        }
+        return value;
+    }
+
+    static bool parseDigest(const std::string& digest, uint8_t raw[Blake3::DIGEST_SIZE]) {
+        const size_t prefixLen = std::strlen(BLAKE3_PREFIX);
+        if (digest.size() != prefixLen + 2 * Blake3::DIGEST_SIZE || digest.compare(0, prefixLen, BLAKE3_PREFIX) != 0 ||
+            digest.find_first_not_of("0123456789abcdef", prefixLen) != std::string::npos) {
+            return false;
+        }
+        for (size_t i = 0; i < Blake3::DIGEST_SIZE; ++i) {
+            raw[i] = static_cast<uint8_t>(std::stoi(digest.substr(prefixLen + 2 * i, 2), nullptr, 16));
+        }
+        return true;
+    }
+
+    bool map(const std::string& path) {
+#ifdef _WIN32
+        m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                             FILE_ATTRIBUTE_NORMAL, nullptr);
+        LARGE_INTEGER size;
+        if (m_file == INVALID_HANDLE_VALUE || !GetFileSizeEx(m_file, &size) || size.QuadPart <= 0 ||
+            static_cast<uint64_t>(size.QuadPart) > SIZE_MAX) {
+            return false;
+        }
+        m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!m_mapping) {
+            return false;
+        }
+        m_data = static_cast<const uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+        m_size = static_cast<uint64_t>(size.QuadPart);
+#else
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size <= 0 || static_cast<uint64_t>(info.st_size) > SIZE_MAX) {
+            ::close(fd);
+            return false;
+        }
+        void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (view != MAP_FAILED) {
+            m_data = static_cast<const uint8_t*>(view);
+            m_size = static_cast<uint64_t>(info.st_size);
+        }
+#endif
+        return m_data != nullptr;
+    }
+
+    /**
+     * @brief Validates the header and loads the index and manifest
+     */
+    bool readIndex(std::string& error, const std::string& spoolPath) {
+        if (m_size < HEADER_SIZE || std::memcmp(m_data, MAGIC, MAGIC_SIZE) != 0) {
+            error = "Not an update bundle";
+            return false;
+        }
+        const uint64_t count = getU64(m_data + 8);
+        const uint64_t manifestOffset = getU64(m_data + 16);
+        const uint64_t manifestSize = getU64(m_data + 24);
+        if (count > (m_size - HEADER_SIZE) / ENTRY_SIZE || manifestOffset < HEADER_SIZE + count * ENTRY_SIZE ||
+            manifestOffset > m_size || manifestSize > m_size - manifestOffset) {
+            error = "Bundle index is out of range";
+            return false;
+        }
+
+        uint8_t digest[Blake3::DIGEST_SIZE];
+        Blake3 headerHash;
+        headerHash.update(m_data + HEADER_SIZE, static_cast<size_t>(manifestOffset + manifestSize - HEADER_SIZE));
+        headerHash.finalize(digest);
+        if (std::memcmp(digest, m_data + 32, sizeof(digest)) != 0) {
+            error = "Bundle index is damaged";
+            return false;
+        }
+
+        const uint64_t payloadStart = manifestOffset + manifestSize;
+        m_entries.resize(static_cast<size_t>(count));
+        for (uint64_t i = 0; i < count; ++i) {
+            const uint8_t* record = m_data + HEADER_SIZE + i * ENTRY_SIZE;
+            Entry& entry = m_entries[static_cast<size_t>(i)];
+            entry.offset = getU64(record);
+            entry.size = getU64(record + 8);
+            const uint64_t pathOffset = getU64(record + 16);
+            const uint64_t pathSize = getU64(record + 24);
+            if (entry.offset < payloadStart || entry.offset > m_size || entry.size > m_size - entry.offset ||
+                pathOffset < HEADER_SIZE + count * ENTRY_SIZE || pathOffset > manifestOffset ||
+                pathSize > manifestOffset - pathOffset) {
+                error = "Bundle entry is out of range";
+                return false;
+            }
+            entry.path.assign(reinterpret_cast<const char*>(m_data + pathOffset), static_cast<size_t>(pathSize));
+            entry.digest = std::string(BLAKE3_PREFIX) + Blake3::toHex(record + 32, Blake3::DIGEST_SIZE);
+            if (i > 0 && !(m_entries[static_cast<size_t>(i - 1)].path < entry.path)) {
+                error = "Bundle index is not sorted";
+                return false;
+            }
+        }
+
+        std::istringstream in(std::string(reinterpret_cast<const char*>(m_data + manifestOffset),
+                                          static_cast<size_t>(manifestSize)));
+        std::string manifestError;
+        if (!UpdateManifest::fromBinary(in, m_manifest, manifestError, MemoryProfile::MANIFEST_BUDGET, spoolPath)) {
+            error = "Bundle manifest is invalid: " + manifestError;
+            return false;
+        }
+        return true;
+    }
+};
+
+} // namespace AutoUpdaterLib
+
+#endif // AUTO_UPDATER_BUNDLE_H
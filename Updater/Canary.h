@@ -0,0 +1,363 @@
+/**
+ * @file Canary.h
+ * @brief Post-update performance canary and per-version performance history
+ *
+ * @author myexistences
+ * @copyright Copyright (c) 2025 myexistences. All rights reserved.
+ * @license MIT License
+ *
+ * @description
+ * The application supplies a measurement, such as a micro-benchmark
+ * duration, its start-up time or a throughput figure. Every version
+ * records its own value. Before restarting into an update, the updater
+ * notes which version it is leaving. The first measurement taken by the
+ * new version is compared with the value recorded for that version. A
+ * slowdown beyond the tolerance rolls the install back, through the
+ * snapshot taken before the update (see Snapshot.h), and marks the version
+ * as rejected so it is not installed again.
+ *
+ * The history also keeps the vitals of every version that ran: the mean
+ * time from process start to ready and the mean steady-state resident set.
+ * metricsText() renders all of it in the Prometheus text format.
+ *
+ * @history_format
+ * ```
+ * "AUPERF02" varint versionCount { string version, varint valueBits }
+ *            string pendingFrom, string pendingTo
+ *            varint rejectedCount { string version }
+ *            string lastReport
+ *            varint vitalsCount { string version, varint starts, varint startupMsBits,
+ *                                 varint residentSamples, varint residentBytesBits }
+ * ```
+ * ...Bits fields are the IEEE 754 bit patterns of doubles. "AUPERF01" files
+ * end after lastReport and are still read.
+ */
+
+#ifndef AUTO_UPDATER_CANARY_H
+#define AUTO_UPDATER_CANARY_H
+
+#include <windows.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Varint.h"
+
+namespace AutoUpdaterLib {
+
+/**
+ * @struct CanaryPolicy
+ * @brief How a new version's performance is measured and judged
+ */
+struct CanaryPolicy {
+    /// Runs the benchmark or reads the metric; empty disables the canary
+    std::function<double()> measure;
+    bool higherIsBetter = false;   ///< false for durations, true for throughput
+    double tolerancePercent = 10;  ///< Largest accepted slowdown against the previous version
+    unsigned samples = 3;          ///< The median of this many measurements is used
+};
+
+/**
+ * @struct VersionVitals
+ * @brief Running means of the start-up time and memory of one version
+ */
+struct VersionVitals {
+    uint64_t starts = 0;            ///< Runs that reported ready
+    double startupMs = 0;           ///< Mean time from process start to ready
+    uint64_t residentSamples = 0;   ///< Runs that reached the steady state
+    double residentBytes = 0;       ///< Mean steady-state working set
+};
+
+/**
+ * @class PerformanceHistory
+ * @brief Persistent measurements per version and the state of the canary
+ */
+class PerformanceHistory {
+public:
+    static constexpr const char* MAGIC = "AUPERF02";
+    static constexpr const char* MAGIC_V1 = "AUPERF01";
+    static constexpr size_t MAGIC_SIZE = 8;
+
+    /**
+     * @brief Opens a history file; a missing or damaged file is treated as empty
+     */
+    explicit PerformanceHistory(const std::string& path) : m_path(path) {
+        std::ifstream in(path, std::ios::binary);
+        char magic[MAGIC_SIZE];
+        uint64_t count = 0;
+        if (!in.read(magic, sizeof(magic)) || !Varint::read(in, count)) {
+            return;
+        }
+        const bool v1 = std::memcmp(magic, MAGIC_V1, sizeof(magic)) == 0;
+        if (!v1 && std::memcmp(magic, MAGIC, sizeof(magic)) != 0) {
+            return;
+        }
+        bool ok = true;
+        for (uint64_t i = 0; ok && i < count; ++i) {
+            std::string version;
+            uint64_t bits = 0;
+            ok = Varint::readString(in, version) && Varint::read(in, bits);
+            m_values[version] = fromBits(bits);
+        }
+        ok = ok && Varint::readString(in, m_pendingFrom) && Varint::readString(in, m_pendingTo) && Varint::read(in, count);
+        for (uint64_t i = 0; ok && i < count; ++i) {
+            std::string version;
+            ok = Varint::readString(in, version);
+            m_rejected.insert(version);
+        }
+        ok = ok && Varint::readString(in, m_lastReport) && (v1 || Varint::read(in, count));
+        for (uint64_t i = 0; ok && !v1 && i < count; ++i) {
+            std::string version;
+            uint64_t startupBits = 0;
+            uint64_t residentBits = 0;
+            VersionVitals vitals;
+            ok = Varint::readString(in, version) && Varint::read(in, vitals.starts) && Varint::read(in, startupBits) &&
+                 Varint::read(in, vitals.residentSamples) && Varint::read(in, residentBits);
+            vitals.startupMs = fromBits(startupBits);
+            vitals.residentBytes = fromBits(residentBits);
+            m_vitals[version] = vitals;
+        }
+        if (!ok) {
+            m_values.clear();
+            m_vitals.clear();
+            clearPending();
+            m_rejected.clear();
+            m_lastReport.clear();
+        }
+    }
+
+    /**
+     * @brief Gets the value recorded for a version
+     * @return false if the version has no measurement
+     */
+    bool value(const std::string& version, double& result) const {
+        auto it = m_values.find(version);
+        if (it == m_values.end()) {
+            return false;
+        }
+        result = it->second;
+        return true;
+    }
+
+    void setValue(const std::string& version, double result) { m_values[version] = result; }
+
+    /**
+     * @brief Notes that the application is about to restart into a new version
+     */
+    void setPending(const std::string& from, const std::string& to) {
+        m_pendingFrom = from;
+        m_pendingTo = to;
+    }
+
+    /**
+     * @brief Gets the version an update to this version replaced
+     * @return Previous version, or empty if this version is not awaiting its canary
+     */
+    std::string pendingFrom(const std::string& version) const {
+        return version == m_pendingTo ? m_pendingFrom : std::string();
+    }
+
+    void clearPending() {
+        m_pendingFrom.clear();
+        m_pendingTo.clear();
+    }
+
+    /**
+     * @brief Marks a version as rolled back and records why
+     */
+    void reject(const std::string& version, const std::string& report) {
+        m_rejected.insert(version);
+        m_values.erase(version);
+        m_lastReport = report;
+    }
+
+    bool isRejected(const std::string& version) const { return m_rejected.count(version) != 0; }
+
+    const std::string& lastReport() const { return m_lastReport; }
+
+    /**
+     * @brief Adds one run's time from process start to ready
+     */
+    void recordStartup(const std::string& version, double milliseconds) {
+        VersionVitals& vitals = m_vitals[version];
+        ++vitals.starts;
+        vitals.startupMs += (milliseconds - vitals.startupMs) / static_cast<double>(vitals.starts);
+    }
+
+    /**
+     * @brief Adds one run's steady-state working set
+     */
+    void recordResident(const std::string& version, uint64_t bytes) {
+        VersionVitals& vitals = m_vitals[version];
+        ++vitals.residentSamples;
+        vitals.residentBytes += (static_cast<double>(bytes) - vitals.residentBytes) / static_cast<double>(vitals.residentSamples);
+    }
+
+    const std::map<std::string, VersionVitals>& vitals() const { return m_vitals; }
+
+    /**
+     * @brief Renders the history in the Prometheus text exposition format
+     * @return One gauge per version and measurement
+     */
+    std::string metricsText() const {
+        std::ostringstream out;
+        out << "# HELP auto_updater_startup_seconds Mean time from process start to ready.\n"
+            << "# TYPE auto_updater_startup_seconds gauge\n";
+        for (const auto& item : m_vitals) {
+            if (item.second.starts != 0) {
+                out << "auto_updater_startup_seconds{version=\"" << label(item.first) << "\"} "
+                    << number(item.second.startupMs / 1000) << "\n";
+            }
+        }
+        out << "# HELP auto_updater_starts Runs that reported ready.\n"
+            << "# TYPE auto_updater_starts gauge\n";
+        for (const auto& item : m_vitals) {
+            out << "auto_updater_starts{version=\"" << label(item.first) << "\"} " << item.second.starts << "\n";
+        }
+        out << "# HELP auto_updater_resident_bytes Mean steady-state working set.\n"
+            << "# TYPE auto_updater_resident_bytes gauge\n";
+        for (const auto& item : m_vitals) {
+            if (item.second.residentSamples != 0) {
+                out << "auto_updater_resident_bytes{version=\"" << label(item.first) << "\"} "
+                    << number(item.second.residentBytes) << "\n";
+            }
+        }
+        out << "# HELP auto_updater_canary_value Canary measurement recorded for the version.\n"
+            << "# TYPE auto_updater_canary_value gauge\n";
+        for (const auto& item : m_values) {
+            out << "auto_updater_canary_value{version=\"" << label(item.first) << "\"} " << number(item.second) << "\n";
+        }
+        out << "# HELP auto_updater_rejected Version rolled back after a performance regression.\n"
+            << "# TYPE auto_updater_rejected gauge\n";
+        for (const auto& version : m_rejected) {
+            out << "auto_updater_rejected{version=\"" << label(version) << "\"} 1\n";
+        }
+        return out.str();
+    }
+
+    /**
+     * @brief Judges a measurement against the previous version's
+     * @param baseline Value recorded for the previous version
+     * @param measured Value of the new version
+     * @param policy Direction and tolerance
+     * @param reason Receives a description of the comparison
+     * @return true if the new version is slower than the tolerance allows
+     */
+    static bool regressed(double baseline, double measured, const CanaryPolicy& policy, std::string& reason) {
+        const double change = baseline != 0 ? (measured - baseline) / baseline * 100 : 0;
+        const double slowdown = policy.higherIsBetter ? -change : change;
+        char text[160];
+        std::snprintf(text, sizeof(text), "measured %.6g against %.6g (%+.1f%%, tolerance %.1f%%)",
+                      measured, baseline, change, policy.tolerancePercent);
+        reason = text;
+        return slowdown > policy.tolerancePercent;
+    }
+
+    /**
+     * @brief Rewrites the file atomically
+     */
+    bool save() const {
+        std::ostringstream out;
+        out.write(MAGIC, MAGIC_SIZE);
+        Varint::write(out, m_values.size());
+        for (const auto& item : m_values) {
+            Varint::writeString(out, item.first);
+            Varint::write(out, toBits(item.second));
+        }
+        Varint::writeString(out, m_pendingFrom);
+        Varint::writeString(out, m_pendingTo);
+        Varint::write(out, m_rejected.size());
+        for (const auto& version : m_rejected) {
+            Varint::writeString(out, version);
+        }
+        Varint::writeString(out, m_lastReport);
+        Varint::write(out, m_vitals.size());
+        for (const auto& item : m_vitals) {
+            Varint::writeString(out, item.first);
+            Varint::write(out, item.second.starts);
+            Varint::write(out, toBits(item.second.startupMs));
+            Varint::write(out, item.second.residentSamples);
+            Varint::write(out, toBits(item.second.residentBytes));
+        }
+        const std::string data = out.str();
+
+        const std::string temp = m_path + ".tmp";
+        HANDLE file = CreateFileA(temp.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        DWORD written = 0;
+        const bool ok = WriteFile(file, data.data(), static_cast<DWORD>(data.size()), &written, nullptr) &&
+                        written == data.size() && FlushFileBuffers(file);
+        CloseHandle(file);
+        return ok && MoveFileExA(temp.c_str(), m_path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+    }
+
+    /**
+     * @brief Runs the policy's measurement and takes the median
+     */
+    static double measure(const CanaryPolicy& policy) {
+        std::vector<double> values(std::max(policy.samples, 1u));
+        for (auto& value : values) {
+            value = policy.measure();
+        }
+        std::sort(values.begin(), values.end());
+        return values[values.size() / 2];
+    }
+
+private:
+    std::string m_path;
+    std::map<std::string, double> m_values;
+    std::string m_pendingFrom;
+    std::string m_pendingTo;
+    std::set<std::string> m_rejected;
+    std::string m_lastReport;
+    std::map<std::string, VersionVitals> m_vitals;
+
+    static uint64_t toBits(double value) {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    static double fromBits(uint64_t bits) {
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    /**
+     * @brief Escapes a label value for the text format
+     */
+    static std::string label(const std::string& text) {
+        std::string result;
+        for (char c : text) {
+            if (c == '\\' || c == '"') {
+                result += '\\';
+                result += c;
+            } else if (c == '\n') {
+                result += "\\n";
+            } else {
+                result += c;
+            }
+        }
+        return result;
+    }
+
+    static std::string number(double value) {
+        char text[32];
+        std::snprintf(text, sizeof(text), "%.9g", value);
+        return text;
+    }
+};
+
+} // namespace AutoUpdaterLib
+
+#endif // AUTO_UPDATER_CANARY_H
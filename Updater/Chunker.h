@@ -0,0 +1,97 @@
+/**
+ * @file Chunker.h
+ * @brief Content-defined chunking for chunk indexes in update manifests
+ *
+ * @author myexistences
+ * @copyright Copyright (c) 2025 myexistences. All rights reserved.
+ * @license MIT License
+ *
+ * @description
+ * Splits files at content-defined boundaries (FastCDC-style gear hashing
+ * with normalised chunk sizes), so an insertion early in a file only changes
+ * the chunks around it. The publisher and the updater use the same
+ * parameters, which lets the updater recognise chunks it already has.
+ */
+
+#ifndef AUTO_UPDATER_CHUNKER_H
+#define AUTO_UPDATER_CHUNKER_H
+
+#include <cstdint>
+#include <cstddef>
+
+namespace AutoUpdaterLib {
+
+/**
+ * @class ContentChunker
+ * @brief Finds chunk boundaries with a rolling gear hash
+ */
+class ContentChunker {
+public:
+    static constexpr size_t MIN_SIZE = 256 * 1024;
+    static constexpr size_t AVG_SIZE = 1024 * 1024;
+    static constexpr size_t MAX_SIZE = 4 * 1024 * 1024;
+
+    /**
+     * @brief Finds the length of the next chunk
+     * @param data Bytes starting at the current chunk
+     * @param length Bytes available (at least MAX_SIZE unless at end of input)
+     * @return Length of the chunk that starts at data
+     *
+     * Below AVG_SIZE a stricter mask makes cuts rarer, above it a looser mask
+     * makes them likelier, which keeps chunk sizes close to the average.
+     */
+    static size_t nextBoundary(const uint8_t* data, size_t length) {
+        if (length <= MIN_SIZE) {
+            return length;
+        }
+
+        const size_t limit = length < MAX_SIZE ? length : static_cast<size_t>(MAX_SIZE);
+        const size_t normal = limit < AVG_SIZE ? limit : static_cast<size_t>(AVG_SIZE);
+        const uint64_t* gear = gearTable();
+        uint64_t hash = 0;
+
+        size_t i = MIN_SIZE;
+        for (; i < normal; ++i) {
+            hash = (hash << 1) + gear[data[i]];
+            if ((hash & MASK_STRICT) == 0) {
+                return i + 1;
+            }
+        }
+        for (; i < limit; ++i) {
+            hash = (hash << 1) + gear[data[i]];
+            if ((hash & MASK_LOOSE) == 0) {
+                return i + 1;
+            }
+        }
+        return limit;
+    }
+
+private:
+    // High bits of a left-shifting gear hash depend on the last 64 bytes
+    static constexpr uint64_t MASK_STRICT = ((1ULL << 22) - 1) << 42;
+    static constexpr uint64_t MASK_LOOSE = ((1ULL << 18) - 1) << 46;
+
+    /**
+     * @brief Gear table derived from a fixed SplitMix64 sequence
+     */
+    static const uint64_t* gearTable() {
+        struct Table {
+            uint64_t values[256];
+            Table() {
+                uint64_t state = 0x4155544F55504454ULL; // "AUTOUPDT"
+                for (size_t i = 0; i < 256; ++i) {
+                    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+                    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+                    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+                    values[i] = z ^ (z >> 31);
+                }
+            }
+        };
+        static const Table table;
+        return table.values;
+    }
+};
+
+} // namespace AutoUpdaterLib
+
+#endif // AUTO_UPDATER_CHUNKER_H
@@ -0,0 +1,208 @@
+/**
+ * @file Connection.h
+ * @brief Process-wide WinINet session with per-host connections and warm-up
+ *
+ * @author myexistences
+ * @copyright Copyright (c) 2025 myexistences. All rights reserved.
+ * @license MIT License
+ *
+ * @description
+ * Every request the updater makes goes through one WinINet session and
+ * one cached connection handle per scheme, host and port. Keep-alive
+ * sockets are therefore reused between the manifest request and the
+ * downloads that follow, across AutoUpdater instances and across periodic
+ * checks in long-running processes. When a socket has to be reopened,
+ * SChannel resumes the TLS session it cached for that host, so only an
+ * abbreviated handshake is needed. prepare() starts DNS resolution and the
+ * TCP/TLS handshake on a background thread, letting them overlap with the
+ * application's own start-up work.
+ *
+ * SChannel keeps its session cache in memory for the lifetime of the
+ * process (ClientCacheTime) and offers no way to export it, so resumption
+ * does not survive a restart.
+ */
+
+#ifndef AUTO_UPDATER_CONNECTION_H
+#define AUTO_UPDATER_CONNECTION_H
+
+#include <windows.h>
+#include <wininet.h>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace AutoUpdaterLib {
+
+/**
+ * @class InternetSession
+ * @brief Shared WinINet session handle
+ */
+class InternetSession {
+public:
+    static constexpr const char* USER_AGENT = "AutoUpdater/2.0";
+    static constexpr DWORD MAX_CONNECTIONS_PER_SERVER = 16;
+    static constexpr DWORD RECEIVE_TIMEOUT_MS = 30000;
+
+    /**
+     * @brief Gets the process-wide session
+     */
+    static InternetSession& instance() {
+        static InternetSession session;
+        return session;
+    }
+
+    ~InternetSession() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_warmUp.joinable()) {
+            m_warmUp.join();
+        }
+        for (auto& entry : m_connections) {
+            InternetCloseHandle(entry.second);
+        }
+        if (m_session) {
+            InternetCloseHandle(m_session);
+        }
+    }
+
+    InternetSession(const InternetSession&) = delete;
+    InternetSession& operator=(const InternetSession&) = delete;
+
+    /**
+     * @brief Gets the session handle, waiting for a warm-up in progress
+     * @return Session handle, or nullptr if WinINet could not be initialised
+     *
+     * Waiting lets the first request reuse the warmed connection instead of
+     * racing it with a second handshake.
+     */
+    HINTERNET handle() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_warmUp.joinable()) {
+            m_warmUp.join();
+        }
+        return open();
+    }
+
+    /**
+     * @brief Starts connecting to the host of a URL in the background
+     * @param url Any URL on the update host, typically the manifest URL
+     *
+     * Returns immediately. Further calls before the next request do nothing.
+     */
+    void prepare(const std::string& url) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        HINTERNET session = open();
+        if (!session || m_warmUp.joinable()) {
+            return;
+        }
+        m_warmUp = std::thread([this, session, url]() {
+            HINTERNET request = send(session, "HEAD", url, std::string(), RECEIVE_TIMEOUT_MS);
+            if (request) {
+                InternetCloseHandle(request);
+            }
+        });
+    }
+
+    /**
+     * @brief Sends a GET request over the cached connection for the URL's host
+     * @param url Absolute http or https URL
+     * @param headers Extra request headers as "Name: value\r\n" lines, may be empty
+     * @param receiveTimeoutMs Longest wait for the response or for any further
+     *                         data; a read that waits longer fails
+     * @return Request handle once the response headers arrived, or nullptr;
+     *         close it with InternetCloseHandle
+     */
+    HINTERNET openUrl(const std::string& url, const std::string& headers = std::string(),
+                      DWORD receiveTimeoutMs = RECEIVE_TIMEOUT_MS) {
+        HINTERNET session = handle();
+        return session ? send(session, "GET", url, headers, receiveTimeoutMs) : nullptr;
+    }
+
+private:
+    std::mutex m_mutex;
+    HINTERNET m_session = nullptr;
+    std::thread m_warmUp;
+    std::mutex m_connectionMutex;                 // Separate so warm-up never waits on m_mutex
+    std::map<std::string, HINTERNET> m_connections;
+
+    InternetSession() = default;
+
+    HINTERNET open() {
+        if (!m_session) {
+            // WinINet allows only a few connections per server by default; segmented downloads need more
+            DWORD perServer = MAX_CONNECTIONS_PER_SERVER;
+            InternetSetOptionA(nullptr, INTERNET_OPTION_MAX_CONNS_PER_SERVER, &perServer, sizeof(perServer));
+            InternetSetOptionA(nullptr, INTERNET_OPTION_MAX_CONNS_PER_1_0_SERVER, &perServer, sizeof(perServer));
+            m_session = InternetOpenA(USER_AGENT, INTERNET_OPEN_TYPE_DIRECT, nullptr, nullptr, 0);
+        }
+        return m_session;
+    }
+
+    /**
+     * @brief Gets the cached connection for a host, creating it on first use
+     */
+    HINTERNET connection(HINTERNET session, const std::string& host, INTERNET_PORT port, bool secure) {
+        const std::string key = (secure ? "https://" : "http://") + host + ":" + std::to_string(port);
+        std::lock_guard<std::mutex> lock(m_connectionMutex);
+        auto it = m_connections.find(key);
+        if (it != m_connections.end()) {
+            return it->second;
+        }
+        HINTERNET connection = InternetConnectA(session, host.c_str(), port, nullptr, nullptr, INTERNET_SERVICE_HTTP, 0, 0);
+        if (connection) {
+            m_connections[key] = connection;
+        }
+        return connection;
+    }
+
+    /**
+     * @brief Sends a request on a keep-alive connection and waits for the response headers
+     */
+    HINTERNET send(HINTERNET session, const char* verb, const std::string& url, const std::string& headers,
+                   DWORD receiveTimeoutMs) {
+        // Null pointers with non-zero lengths make InternetCrackUrlA point into the URL,
+        // so no component length is limited by a buffer
+        URL_COMPONENTSA parts;
+        std::memset(&parts, 0, sizeof(parts));
+        parts.dwStructSize = sizeof(parts);
+        parts.dwHostNameLength = 1;
+        parts.dwUrlPathLength = 1;
+        parts.dwExtraInfoLength = 1;
+        if (!InternetCrackUrlA(url.c_str(), static_cast<DWORD>(url.size()), 0, &parts) || !parts.lpszHostName) {
+            return nullptr;
+        }
+        const std::string host(parts.lpszHostName, parts.dwHostNameLength);
+        std::string object = parts.lpszUrlPath ? std::string(parts.lpszUrlPath, parts.dwUrlPathLength) : std::string();
+        if (parts.lpszExtraInfo) {
+            object.append(parts.lpszExtraInfo, parts.dwExtraInfoLength); // Query string
+        }
+        if (object.empty()) {
+            object = "/";
+        }
+
+        const bool secure = parts.nScheme == INTERNET_SCHEME_HTTPS;
+        HINTERNET server = connection(session, host, parts.nPort, secure);
+        if (!server) {
+            return nullptr;
+        }
+
+        const DWORD flags = INTERNET_FLAG_KEEP_CONNECTION | INTERNET_FLAG_RELOAD | INTERNET_FLAG_NO_CACHE_WRITE |
+                            (secure ? INTERNET_FLAG_SECURE : 0);
+        HINTERNET request = HttpOpenRequestA(server, verb, object.c_str(), nullptr, nullptr, nullptr, flags, 0);
+        if (!request) {
+            return nullptr;
+        }
+        InternetSetOptionA(request, INTERNET_OPTION_RECEIVE_TIMEOUT, &receiveTimeoutMs, sizeof(receiveTimeoutMs));
+        if (!HttpSendRequestA(request, headers.empty() ? nullptr : headers.c_str(),
+                              static_cast<DWORD>(headers.size()), nullptr, 0)) {
+            InternetCloseHandle(request);
+            return nullptr;
+        }
+        return request;
+    }
+};
+
+} // namespace AutoUpdaterLib
+
+#endif // AUTO_UPDATER_CONNECTION_H
@@ -0,0 +1,258 @@
+/**
+ * @file CostModel.h
+ * @brief Estimated download time of update routes, and the dry-run update plan
+ *
+ * @author myexistences
+ * @copyright Copyright (c) 2025 myexistences. All rights reserved.
+ * @license MIT License
+ *
+ * @description
+ * A release can usually be reached several ways: a full image in one
+ * request or as parallel ranges, a chain of patches, or a zip package of
+ * the whole application. Which is cheapest depends on more than the
+ * published sizes: each download pays a request round trip, the throughput
+ * learned for a mirror differs between one connection and several, an
+ * interrupted ranged download resumes where it stopped, and a package also
+ * replaces the release files the other routes download separately.
+ *
+ * The model estimates each step as
+ *
+ * ```
+ * requestMs + (size - resumedBytes) / throughput
+ * ```
+ *
+ * where ranged downloads (known size at or above the segment threshold,
+ * bare executables only) use the mirror's learned throughput and resume from
+ * their checkpoint, and single requests use that throughput divided by the
+ * learned connection count. The first step of a route that is not a package
+ * also pays for the release files. Mirrors without history are assumed to
+ * deliver DEFAULT_BYTES_PER_SECOND.
+ */
+
+#ifndef AUTO_UPDATER_COST_MODEL_H
+#define AUTO_UPDATER_COST_MODEL_H
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include "Manifest.h"
+
+namespace AutoUpdaterLib {
+
+/**
+ * @struct UpdatePlan
+ * @brief What an update would download and how long it is expected to take
+ */
+struct UpdatePlan {
+    enum class Strategy {
+        None,           ///< No update, or the version is unreachable
+        FullImage,      ///< One full image in a single request
+        SegmentedImage, ///< One full image as parallel ranged requests
+        Delta,          ///< A route containing patches
+        Package         ///< A zip package of the whole application
+    };
+
+    Strategy strategy = Strategy::None;
+    std::string targetVersion;
+    std::vector<UpdateArtifact> route;
+    uint64_t downloadBytes = 0;   ///< Bytes still to transfer, or UpdateArtifact::UNKNOWN_SIZE
+    uint64_t resumedBytes = 0;    ///< Bytes already on disk from interrupted downloads
+    uint64_t releaseBytes = 0;    ///< Release files downloaded besides the route; included in downloadBytes
+    uint64_t estimatedMs = 0;     ///< Expected download time; 0 when a size is unknown
+
+    static const char* strategyName(Strategy strategy) {
+        switch (strategy) {
+            case Strategy::FullImage: return "full image";
+            case Strategy::SegmentedImage: return "segmented full image";
+            case Strategy::Delta: return "delta";
+            case Strategy::Package: return "package";
+            default: return "none";
+        }
+    }
+};
+
+/**
+ * @class CostModel
+ * @brief Estimates download times and plans the fastest route
+ */
+class CostModel {
+public:
+    static constexpr uint64_t DEFAULT_BYTES_PER_SECOND = 2 * 1024 * 1024;
+    static constexpr uint64_t DEFAULT_REQUEST_MS = 250;
+
+    /**
+     * @brief Records what is known about the source of an artifact
+     * @param link Artifact URL
+     * @param bytesPerSecond Learned throughput of a ranged download from its mirror, 0 if unknown
+     * @param connections Connection count that throughput was reached with
+     * @param resumedBytes Bytes a ranged download of the artifact would resume from its checkpoint
+     */
+    void setSource(const std::string& link, uint64_t bytesPerSecond, unsigned connections, uint64_t resumedBytes) {
+        Source& source = m_sources[link];
+        source.bytesPerSecond = bytesPerSecond;
+        source.connections = std::max(connections, 1u);
+        source.resumedBytes = resumedBytes;
+    }
+
+    /**
+     * @brief Sets the fixed cost of each request, mostly its round trips
+     */
+    void setRequestMs(uint64_t ms) {
+        m_requestMs = ms;
+    }
+
+    /**
+     * @brief Sets the size from which bare executables are downloaded as ranges
+     * @param bytes Threshold; UINT64_MAX when every download uses a single request
+     */
+    void setSegmentThreshold(uint64_t bytes) {
+        m_segmentThreshold = bytes;
+    }
+
+    /**
+     * @brief Caps every throughput, e.g. at the current bandwidth limit
+     * @param bytesPerSecond Cap; 0 for none
+     */
+    void setRateLimit(uint64_t bytesPerSecond) {
+        m_rateLimit = bytesPerSecond;
+    }
+
+    /**
+     * @brief Records the release files a route must download unless it starts with a package
+     * @param bytes Total size of the files not yet installed, or
+     *              UpdateArtifact::UNKNOWN_SIZE if one of them has no size
+     * @param files Number of those files
+     */
+    void setReleaseFiles(uint64_t bytes, size_t files) {
+        m_releaseBytes = bytes;
+        m_releaseFiles = files;
+    }
+
+    /**
+     * @brief Estimates the download time of one artifact
+     * @return Milliseconds, or UpdatePlanner::UNKNOWN_COST if its size is unknown
+     */
+    uint64_t stepMs(const UpdateArtifact& artifact) const {
+        if (artifact.size == UpdateArtifact::UNKNOWN_SIZE) {
+            return UpdatePlanner::UNKNOWN_COST;
+        }
+        const bool ranged = isRanged(artifact);
+        return m_requestMs + transferMs(artifact.size - resumed(artifact, ranged), throughput(artifact.link, ranged));
+    }
+
+    /**
+     * @brief Plans the route with the lowest estimated time
+     * @param manifest Manifest listing the available images and patches
+     * @param installedVersion Version currently installed
+     * @return The plan; Strategy::None with an empty route if the version is unreachable
+     */
+    UpdatePlan plan(const UpdateManifest& manifest, const std::string& installedVersion) const {
+        UpdatePlan result;
+        result.targetVersion = manifest.version;
+        result.route = UpdatePlanner::plan(manifest, installedVersion, [this](const UpdateArtifact& artifact, bool first) {
+            return first && !isPackage(artifact) ? UpdatePlanner::saturatingAdd(stepMs(artifact), releaseMs(artifact))
+                                                 : stepMs(artifact);
+        });
+        if (result.route.empty()) {
+            return result;
+        }
+
+        const UpdateArtifact& first = result.route.front();
+        bool unknown = false;
+        if (!isPackage(first)) {
+            result.releaseBytes = m_releaseBytes;
+            unknown = m_releaseBytes == UpdateArtifact::UNKNOWN_SIZE;
+            if (!unknown) {
+                result.downloadBytes = m_releaseBytes;
+                result.estimatedMs = releaseMs(first);
+            }
+        }
+        for (const auto& step : result.route) {
+            if (step.size == UpdateArtifact::UNKNOWN_SIZE) {
+                unknown = true;
+                continue;
+            }
+            const uint64_t resumedBytes = resumed(step, isRanged(step));
+            result.resumedBytes += resumedBytes;
+            result.downloadBytes += step.size - resumedBytes;
+            result.estimatedMs += stepMs(step);
+            if (step.kind == UpdateArtifact::Kind::Patch) {
+                result.strategy = UpdatePlan::Strategy::Delta;
+            }
+        }
+        if (unknown) {
+            result.downloadBytes = UpdateArtifact::UNKNOWN_SIZE;
+            result.estimatedMs = 0;
+        }
+        if (result.strategy != UpdatePlan::Strategy::Delta) {
+            result.strategy = isPackage(first) ? UpdatePlan::Strategy::Package
+                            : isRanged(first) ? UpdatePlan::Strategy::SegmentedImage
+                                              : UpdatePlan::Strategy::FullImage;
+        }
+        return result;
+    }
+
+private:
+    struct Source {
+        uint64_t bytesPerSecond = 0;
+        unsigned connections = 1;
+        uint64_t resumedBytes = 0;
+    };
+
+    std::map<std::string, Source> m_sources;
+    uint64_t m_requestMs = DEFAULT_REQUEST_MS;
+    uint64_t m_segmentThreshold = UINT64_MAX;
+    uint64_t m_rateLimit = 0;
+    uint64_t m_releaseBytes = 0;
+    size_t m_releaseFiles = 0;
+
+    static bool isPackage(const UpdateArtifact& artifact) {
+        return artifact.kind == UpdateArtifact::Kind::FullImage && artifact.package == "zip";
+    }
+
+    bool isRanged(const UpdateArtifact& artifact) const {
+        return !isPackage(artifact) && artifact.size != UpdateArtifact::UNKNOWN_SIZE && artifact.size >= m_segmentThreshold;
+    }
+
+    uint64_t resumed(const UpdateArtifact& artifact, bool ranged) const {
+        auto it = m_sources.find(artifact.link);
+        return ranged && it != m_sources.end() ? std::min(it->second.resumedBytes, artifact.size) : 0;
+    }
+
+    /**
+     * @brief Gets the expected throughput of a download from a link
+     *
+     * The learned rate was reached over several connections; one request
+     * is assumed to get an equal share of it.
+     */
+    uint64_t throughput(const std::string& link, bool ranged) const {
+        uint64_t rate = static_cast<uint64_t>(DEFAULT_BYTES_PER_SECOND);
+        auto it = m_sources.find(link);
+        if (it != m_sources.end() && it->second.bytesPerSecond > 0) {
+            rate = ranged ? it->second.bytesPerSecond : std::max<uint64_t>(it->second.bytesPerSecond / it->second.connections, 1);
+        }
+        return m_rateLimit > 0 ? std::min(rate, m_rateLimit) : rate;
+    }
+
+    /**
+     * @brief Estimates the release files, fetched one request each from the first step's mirror
+     * @return Milliseconds, or UpdatePlanner::UNKNOWN_COST if a file's size is unknown
+     */
+    uint64_t releaseMs(const UpdateArtifact& first) const {
+        if (m_releaseBytes == UpdateArtifact::UNKNOWN_SIZE) {
+            return UpdatePlanner::UNKNOWN_COST;
+        }
+        return UpdatePlanner::saturatingAdd(m_releaseFiles * m_requestMs,
+                                            transferMs(m_releaseBytes, throughput(first.link, false)));
+    }
+
+    static uint64_t transferMs(uint64_t bytes, uint64_t bytesPerSecond) {
+        return bytes / bytesPerSecond * 1000 + bytes % bytesPerSecond * 1000 / bytesPerSecond;
+    }
+};
+
+} // namespace AutoUpdaterLib
+
+#endif // AUTO_UPDATER_COST_MODEL_H
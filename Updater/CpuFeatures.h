@@ -0,0 +1,232 @@
+/**
+ * @file CpuFeatures.h
+ * @brief Host CPU feature detection for choosing between build variants
+ *
+ * @author myexistences
+ * @copyright Copyright (c) 2025 myexistences. All rights reserved.
+ * @license MIT License
+ *
+ * @description
+ * Reads the x86 feature flags with CPUID and checks with XGETBV that the
+ * operating system saves the AVX and AVX-512 registers, since a CPU flag
+ * alone does not make those instructions usable. Requirements are written
+ * as feature names or x86-64 micro-architecture levels:
+ *
+ * ```
+ * "x86-64-v2"   cx16 lahf popcnt sse3 ssse3 sse4.1 sse4.2
+ * "x86-64-v3"   v2 + avx avx2 bmi1 bmi2 f16c fma lzcnt movbe
+ * "x86-64-v4"   v3 + avx512f avx512bw avx512cd avx512dq avx512vl
+ * "avx2 fma"    individual features, separated by spaces or commas
+ * ```
+ *
+ * Other architectures report no features, so only baseline builds match.
+ */
+
+#ifndef AUTO_UPDATER_CPU_FEATURES_H
+#define AUTO_UPDATER_CPU_FEATURES_H
+
+#include <cstdint>
+#include <string>
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define AUTO_UPDATER_X86 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace AutoUpdaterLib {
+
+/**
+ * @class CpuFeatures
+ * @brief Feature bit masks, their names and detection on the running host
+ */
+class CpuFeatures {
+public:
+    static constexpr uint64_t SSE3 = 1ULL << 0;
+    static constexpr uint64_t SSSE3 = 1ULL << 1;
+    static constexpr uint64_t SSE4_1 = 1ULL << 2;
+    static constexpr uint64_t SSE4_2 = 1ULL << 3;
+    static constexpr uint64_t POPCNT = 1ULL << 4;
+    static constexpr uint64_t CX16 = 1ULL << 5;
+    static constexpr uint64_t LAHF = 1ULL << 6;
+    static constexpr uint64_t AVX = 1ULL << 7;
+    static constexpr uint64_t AVX2 = 1ULL << 8;
+    static constexpr uint64_t BMI1 = 1ULL << 9;
+    static constexpr uint64_t BMI2 = 1ULL << 10;
+    static constexpr uint64_t F16C = 1ULL << 11;
+    static constexpr uint64_t FMA = 1ULL << 12;
+    static constexpr uint64_t LZCNT = 1ULL << 13;
+    static constexpr uint64_t MOVBE = 1ULL << 14;
+    static constexpr uint64_t AVX512F = 1ULL << 15;
+    static constexpr uint64_t AVX512BW = 1ULL << 16;
+    static constexpr uint64_t AVX512CD = 1ULL << 17;
+    static constexpr uint64_t AVX512DQ = 1ULL << 18;
+    static constexpr uint64_t AVX512VL = 1ULL << 19;
+
+    static constexpr uint64_t X86_64_V2 = CX16 | LAHF | POPCNT | SSE3 | SSSE3 | SSE4_1 | SSE4_2;
+    static constexpr uint64_t X86_64_V3 = X86_64_V2 | AVX | AVX2 | BMI1 | BMI2 | F16C | FMA | LZCNT | MOVBE;
+    static constexpr uint64_t X86_64_V4 = X86_64_V3 | AVX512F | AVX512BW | AVX512CD | AVX512DQ | AVX512VL;
+
+    /**
+     * @brief Gets the features of the running host, detected once
+     */
+    static uint64_t host() {
+        static const uint64_t features = detect();
+        return features;
+    }
+
+    /**
+     * @brief Parses a requirement list
+     * @param text Feature names and levels, separated by spaces or commas; case-insensitive
+     * @param mask Receives the union of the named features
+     * @return false if a name is unknown
+     */
+    static bool parse(const std::string& text, uint64_t& mask) {
+        mask = 0;
+        size_t start = 0;
+        while (start < text.size()) {
+            size_t end = text.find_first_of(" ,\t", start);
+            if (end == std::string::npos) {
+                end = text.size();
+            }
+            std::string name = text.substr(start, end - start);
+            for (auto& c : name) {
+                if (c >= 'A' && c <= 'Z') {
+                    c = static_cast<char>(c - 'A' + 'a');
+                }
+            }
+            start = end + 1;
+            if (name.empty()) {
+                continue;
+            }
+            uint64_t bits = 0;
+            if (!lookup(name, bits)) {
+                return false;
+            }
+            mask |= bits;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Counts the features in a mask; more features means a faster build
+     */
+    static unsigned count(uint64_t mask) {
+        unsigned result = 0;
+        for (; mask != 0; mask &= mask - 1) {
+            ++result;
+        }
+        return result;
+    }
+
+private:
+    static bool lookup(const std::string& name, uint64_t& bits) {
+        static const struct {
+            const char* name;
+            uint64_t bits;
+        } NAMES[] = {
+            {"x86-64", 0}, {"x86-64-v1", 0}, {"x86-64-v2", X86_64_V2}, {"x86-64-v3", X86_64_V3}, {"x86-64-v4", X86_64_V4},
+            {"sse3", SSE3}, {"ssse3", SSSE3}, {"sse4.1", SSE4_1}, {"sse4.2", SSE4_2}, {"popcnt", POPCNT},
+            {"cx16", CX16}, {"lahf", LAHF}, {"avx", AVX}, {"avx2", AVX2}, {"bmi1", BMI1}, {"bmi2", BMI2},
+            {"f16c", F16C}, {"fma", FMA}, {"lzcnt", LZCNT}, {"movbe", MOVBE}, {"avx512f", AVX512F},
+            {"avx512bw", AVX512BW}, {"avx512cd", AVX512CD}, {"avx512dq", AVX512DQ}, {"avx512vl", AVX512VL}};
+        for (const auto& entry : NAMES) {
+            if (name == entry.name) {
+                bits = entry.bits;
+                return true;
+            }
+        }
+        return false;
+    }
+
+#ifdef AUTO_UPDATER_X86
+    static void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4]) {
+#ifdef _MSC_VER
+        int values[4];
+        __cpuidex(values, static_cast<int>(leaf), static_cast<int>(subleaf));
+        for (int i = 0; i < 4; ++i) {
+            regs[i] = static_cast<uint32_t>(values[i]);
+        }
+#else
+        __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+    }
+
+    /**
+     * @brief Reads XCR0, the register state the operating system saves
+     */
+    static uint64_t xgetbv() {
+#ifdef _MSC_VER
+        return _xgetbv(0);
+#else
+        uint32_t eax, edx;
+        __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+        return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+    }
+
+    static uint64_t detect() {
+        uint32_t regs[4];
+        cpuid(0, 0, regs);
+        const uint32_t maxLeaf = regs[0];
+        if (maxLeaf < 1) {
+            return 0;
+        }
+
+        uint64_t features = 0;
+        cpuid(1, 0, regs);
+        const uint32_t ecx = regs[2];
+        if (ecx & (1u << 0)) features |= SSE3;
+        if (ecx & (1u << 9)) features |= SSSE3;
+        if (ecx & (1u << 13)) features |= CX16;
+        if (ecx & (1u << 19)) features |= SSE4_1;
+        if (ecx & (1u << 20)) features |= SSE4_2;
+        if (ecx & (1u << 22)) features |= MOVBE;
+        if (ecx & (1u << 23)) features |= POPCNT;
+
+        // AVX state (XMM and YMM) must be enabled by the OS, and ZMM state for AVX-512
+        const bool osxsave = (ecx & (1u << 27)) != 0;
+        const uint64_t xcr0 = osxsave ? xgetbv() : 0;
+        const bool avxState = (xcr0 & 0x6) == 0x6;
+        const bool avx512State = avxState && (xcr0 & 0xE0) == 0xE0;
+        if (avxState) {
+            if (ecx & (1u << 28)) features |= AVX;
+            if (ecx & (1u << 12)) features |= FMA;
+            if (ecx & (1u << 29)) features |= F16C;
+        }
+
+        if (maxLeaf >= 7) {
+            cpuid(7, 0, regs);
+            const uint32_t ebx = regs[1];
+            if (ebx & (1u << 3)) features |= BMI1;
+            if (ebx & (1u << 8)) features |= BMI2;
+            if (avxState && (ebx & (1u << 5))) features |= AVX2;
+            if (avx512State) {
+                if (ebx & (1u << 16)) features |= AVX512F;
+                if (ebx & (1u << 17)) features |= AVX512DQ;
+                if (ebx & (1u << 28)) features |= AVX512CD;
+                if (ebx & (1u << 30)) features |= AVX512BW;
+                if (ebx & (1u << 31)) features |= AVX512VL;
+            }
+        }
+
+        cpuid(0x80000000u, 0, regs);
+        if (regs[0] >= 0x80000001u) {
+            cpuid(0x80000001u, 0, regs);
+            if (regs[2] & (1u << 0)) features |= LAHF;
+            if (regs[2] & (1u << 5)) features |= LZCNT;
+        }
+        return features;
+    }
+#else
+    static uint64_t detect() {
+        return 0;
+    }
+#endif
+};
+
+} // namespace AutoUpdaterLib
+
+#endif // AUTO_UPDATER_CPU_FEATURES_H
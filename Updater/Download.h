@@ -0,0 +1,743 @@
+/**
+ * @file Download.h
+ * @brief Resumable, segmented HTTP downloads with a checkpoint sidecar
+ *
+ * @author myexistences
+ * @copyright Copyright (c) 2025 myexistences. All rights reserved.
+ * @license MIT License
+ *
+ * @description
+ * Large downloads are split into segments that are fetched in parallel
+ * with HTTP Range requests and written in place into a pre-sized file.
+ * Segments follow the manifest's content-defined chunks when they are
+ * known, so each one can be verified on arrival; otherwise they are fixed
+ * 1 MiB ranges covered by the whole-file digest.
+ *
+ * Next to the file, `<file>.ckpt` records which segments are complete.
+ * Completed segments are collected in memory and persisted in batches:
+ * every CHECKPOINT_SEGMENTS segments or CHECKPOINT_INTERVAL_MS, and when
+ * the download stops. Each batch flushes the file before the checkpoint
+ * that claims its segments replaces the old one atomically, so a crash
+ * costs at most one batch of refetching and never trusts unflushed data.
+ *
+ * The durability level (see Durability.h) applies as for single-request
+ * downloads. With Durability::None the file is never flushed, so after a
+ * power loss the checkpoint may claim lost segments; the artifact digest
+ * then rejects the file. With Durability::Ordered the ranges are written to
+ * `<file>.part`, with its checkpoint `<file>.part.ckpt`, and the complete
+ * file is renamed into place with a flushed rename.
+ *
+ * @checkpoint_format
+ * ```
+ * "AUCKPT01" string identity  varint segmentCount  bitmap[(segmentCount + 7) / 8]
+ * ```
+ * The identity binds the checkpoint to one URL, size and digest; a
+ * checkpoint for anything else is discarded.
+ *
+ * The number of parallel segments adapts while downloading (AIMD). Each
+ * second, one more connection is allowed if aggregate throughput improved
+ * by at least 5% since the previous second. A failed range, or 5 seconds
+ * without any data, halves the limit; a range whose read hangs that long
+ * times out and is retried. The best throughput and the limit that reached
+ * it are kept per host in a small tuning file, and the next download from
+ * that host starts at that limit.
+ *
+ * @tuning_format
+ * ```
+ * "AUMIRR01" varint hostCount { string host, varint connections, varint bytesPerSecond }
+ * ```
+ */
+
+#ifndef AUTO_UPDATER_DOWNLOAD_H
+#define AUTO_UPDATER_DOWNLOAD_H
+
+#include <windows.h>
+#include <wininet.h>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Blake3.h"
+#include "Connection.h"
+#include "Durability.h"
+#include "Manifest.h"
+#include "Varint.h"
+
+namespace AutoUpdaterLib {
+
+/**
+ * @class DownloadCheckpoint
+ * @brief Persistent bitmap of completed download segments
+ */
+class DownloadCheckpoint {
+public:
+    static constexpr const char* MAGIC = "AUCKPT01";
+    static constexpr size_t MAGIC_SIZE = 8;
+
+    /**
+     * @brief Creates a checkpoint for a download
+     * @param path Sidecar file path
+     * @param identity Text identifying the download (URL, size, digest)
+     * @param segmentCount Number of segments
+     */
+    DownloadCheckpoint(const std::string& path, const std::string& identity, size_t segmentCount)
+        : m_path(path), m_identity(identity), m_bitmap((segmentCount + 7) / 8, 0), m_segmentCount(segmentCount) {}
+
+    /**
+     * @brief Loads the sidecar if it belongs to this download
+     * @return true if progress was restored; false starts from zero
+     */
+    bool load() {
+        std::ifstream in(m_path, std::ios::binary);
+        char magic[MAGIC_SIZE];
+        std::string identity;
+        uint64_t count = 0;
+        if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, MAGIC, sizeof(magic)) != 0 ||
+            !Varint::readString(in, identity) || identity != m_identity ||
+            !Varint::read(in, count) || count != m_segmentCount) {
+            return false;
+        }
+        std::vector<uint8_t> bitmap(m_bitmap.size());
+        if (!in.read(reinterpret_cast<char*>(bitmap.data()), static_cast<std::streamsize>(bitmap.size()))) {
+            return false;
+        }
+        m_bitmap = bitmap;
+        return true;
+    }
+
+    /**
+     * @brief Checks whether a segment was completed
+     */
+    bool isDone(size_t segment) const {
+        return (m_bitmap[segment / 8] >> (segment % 8)) & 1;
+    }
+
+    /**
+     * @brief Marks a segment complete in memory; save() persists it
+     */
+    void markDone(size_t segment) {
+        m_bitmap[segment / 8] = static_cast<uint8_t>(m_bitmap[segment / 8] | (1u << (segment % 8)));
+    }
+
+    /**
+     * @brief Deletes the sidecar once the download is complete
+     */
+    void remove() const {
+        DeleteFileA(m_path.c_str());
+    }
+
+    /**
+     * @brief Writes a flushed temporary file and renames it over the sidecar
+     *
+     * The data of every segment marked done must be on disk first.
+     */
+    bool save() const {
+        std::ostringstream out;
+        out.write(MAGIC, MAGIC_SIZE);
+        Varint::writeString(out, m_identity);
+        Varint::write(out, m_segmentCount);
+        out.write(reinterpret_cast<const char*>(m_bitmap.data()), static_cast<std::streamsize>(m_bitmap.size()));
+        const std::string data = out.str();
+
+        const std::string temp = m_path + ".tmp";
+        HANDLE file = CreateFileA(temp.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        DWORD written = 0;
+        const bool ok = WriteFile(file, data.data(), static_cast<DWORD>(data.size()), &written, nullptr) &&
+                        written == data.size() && FlushFileBuffers(file);
+        CloseHandle(file);
+        return ok && MoveFileExA(temp.c_str(), m_path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+    }
+
+private:
+    std::string m_path;
+    std::string m_identity;
+    std::vector<uint8_t> m_bitmap;
+    size_t m_segmentCount;
+};
+
+/**
+ * @class ConcurrencyController
+ * @brief Additive-increase, multiplicative-decrease limit on parallel segments
+ */
+class ConcurrencyController {
+public:
+    static constexpr uint64_t WINDOW_MS = 1000;
+    static constexpr uint64_t STALL_MS = 5000;
+    static constexpr uint64_t IMPROVEMENT_PERCENT = 5;
+
+    /**
+     * @brief Creates a controller
+     * @param initial Starting limit
+     * @param maximum Highest limit ever allowed
+     */
+    ConcurrencyController(unsigned initial, unsigned maximum)
+        : m_limit(std::max(1u, std::min(initial, maximum))), m_maximum(std::max(1u, maximum)),
+          m_windowStart(GetTickCount64()) {}
+
+    /**
+     * @brief Waits until another segment may start
+     *
+     * Waiting workers also watch for stalls: if no data arrived for
+     * STALL_MS while segments are in flight, the limit is halved.
+     */
+    void acquire() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (m_active >= m_limit) {
+            if (m_wake.wait_for(lock, std::chrono::milliseconds(static_cast<uint64_t>(WINDOW_MS))) == std::cv_status::timeout) {
+                const uint64_t now = GetTickCount64();
+                if (m_windowBytes == 0 && now - m_windowStart >= STALL_MS) {
+                    backOff(now);
+                }
+            }
+        }
+        ++m_active;
+    }
+
+    /**
+     * @brief Marks a segment as finished, successfully or not
+     */
+    void release() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        --m_active;
+        m_wake.notify_all();
+    }
+
+    /**
+     * @brief Accounts received bytes and re-evaluates the limit once per window
+     */
+    void received(size_t bytes) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_windowBytes += bytes;
+        const uint64_t now = GetTickCount64();
+        const uint64_t elapsed = now - m_windowStart;
+        if (elapsed < WINDOW_MS) {
+            return;
+        }
+        const uint64_t rate = m_windowBytes * 1000 / elapsed;
+        const unsigned measured = m_limit; // The limit the window's rate was measured at
+        // Only a saturated limit says anything about whether more connections help
+        if (m_active >= m_limit && m_limit < m_maximum &&
+            rate * 100 > m_lastRate * (100 + IMPROVEMENT_PERCENT)) {
+            ++m_limit;
+            m_wake.notify_all();
+        }
+        m_lastRate = rate;
+        if (rate > m_bestRate) {
+            m_bestRate = rate;
+            m_bestLimit = measured;
+        }
+        m_windowStart = now;
+        m_windowBytes = 0;
+    }
+
+    /**
+     * @brief Halves the limit after a failed range
+     */
+    void failed() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        backOff(GetTickCount64());
+    }
+
+    unsigned limit() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_limit;
+    }
+
+    /**
+     * @brief Gets the best aggregate throughput seen in a full window
+     */
+    uint64_t bestRate() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_bestRate;
+    }
+
+    /**
+     * @brief Gets the limit that was active when bestRate() was measured
+     */
+    unsigned bestLimit() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_bestRate > 0 ? m_bestLimit : m_limit;
+    }
+
+private:
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    unsigned m_limit;
+    unsigned m_maximum;
+    unsigned m_active = 0;
+    uint64_t m_windowStart;
+    uint64_t m_windowBytes = 0;
+    uint64_t m_lastRate = 0;
+    uint64_t m_bestRate = 0;
+    unsigned m_bestLimit = 1;
+
+    void backOff(uint64_t now) {
+        m_limit = std::max(1u, m_limit / 2);
+        m_lastRate = 0;
+        m_windowStart = now;
+        m_windowBytes = 0;
+    }
+};
+
+/**
+ * @class MirrorTuning
+ * @brief Persistent per-host connection limits learned by earlier downloads
+ */
+class MirrorTuning {
+public:
+    static constexpr const char* MAGIC = "AUMIRR01";
+    static constexpr size_t MAGIC_SIZE = 8;
+
+    /**
+     * @brief Opens a tuning file; a missing or damaged file is treated as empty
+     */
+    explicit MirrorTuning(const std::string& path) : m_path(path) {
+        std::ifstream in(path, std::ios::binary);
+        char magic[MAGIC_SIZE];
+        uint64_t count = 0;
+        if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, MAGIC, sizeof(magic)) != 0 || !Varint::read(in, count)) {
+            return;
+        }
+        for (uint64_t i = 0; i < count; ++i) {
+            std::string host;
+            Entry entry;
+            if (!Varint::readString(in, host) || !Varint::read(in, entry.connections) || !Varint::read(in, entry.bytesPerSecond)) {
+                m_hosts.clear();
+                return;
+            }
+            m_hosts[host] = entry;
+        }
+    }
+
+    /**
+     * @brief Extracts "host[:port]" from a URL, in lowercase
+     */
+    static std::string hostOf(const std::string& url) {
+        const size_t scheme = url.find("://");
+        const size_t start = scheme == std::string::npos ? 0 : scheme + 3;
+        std::string host = url.substr(start, url.find_first_of("/?#", start) - start);
+        for (auto& c : host) c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+        return host;
+    }
+
+    /**
+     * @brief Gets the learned connection limit for a host
+     * @return Stored limit, or fallback if the host is unknown
+     */
+    unsigned connections(const std::string& host, unsigned fallback) const {
+        auto it = m_hosts.find(host);
+        return it == m_hosts.end() || it->second.connections == 0 ? fallback : static_cast<unsigned>(it->second.connections);
+    }
+
+    /**
+     * @brief Gets the best throughput an earlier download from a host reached
+     * @return Bytes per second with connections(host) connections, or 0 if the host is unknown
+     */
+    uint64_t bytesPerSecond(const std::string& host) const {
+        auto it = m_hosts.find(host);
+        return it == m_hosts.end() ? 0 : it->second.bytesPerSecond;
+    }
+
+    /**
+     * @brief Stores what a download learned and rewrites the file atomically
+     */
+    bool record(const std::string& host, unsigned connections, uint64_t bytesPerSecond) {
+        Entry& entry = m_hosts[host];
+        entry.connections = connections;
+        entry.bytesPerSecond = bytesPerSecond;
+
+        std::ostringstream out;
+        out.write(MAGIC, MAGIC_SIZE);
+        Varint::write(out, m_hosts.size());
+        for (const auto& item : m_hosts) {
+            Varint::writeString(out, item.first);
+            Varint::write(out, item.second.connections);
+            Varint::write(out, item.second.bytesPerSecond);
+        }
+        const std::string data = out.str();
+
+        const std::string temp = m_path + ".tmp";
+        HANDLE file = CreateFileA(temp.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        DWORD written = 0;
+        const bool ok = WriteFile(file, data.data(), static_cast<DWORD>(data.size()), &written, nullptr) &&
+                        written == data.size() && FlushFileBuffers(file);
+        CloseHandle(file);
+        return ok && MoveFileExA(temp.c_str(), m_path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+    }
+
+private:
+    struct Entry {
+        uint64_t connections = 0;
+        uint64_t bytesPerSecond = 0;
+    };
+
+    std::string m_path;
+    std::map<std::string, Entry> m_hosts;
+};
+
+/**
+ * @class SegmentedDownloader
+ * @brief Downloads a file of known size as parallel, resumable ranges
+ */
+class SegmentedDownloader {
+public:
+    /**
+     * @struct Segment
+     * @brief One byte range of the download
+     */
+    struct Segment {
+        uint64_t offset;
+        uint64_t size;
+        std::string digest;   ///< "blake3:<hex>" of the range, or empty
+    };
+
+    static constexpr uint64_t SEGMENT_SIZE = 1024 * 1024;
+    static constexpr unsigned INITIAL_CONNECTIONS = 4;   // For hosts without learned settings
+    static constexpr unsigned MAX_CONNECTIONS = 16;
+    static constexpr int SEGMENT_ATTEMPTS = 3;
+    static constexpr size_t CHECKPOINT_SEGMENTS = 64;        // Completed segments per checkpoint batch
+    static constexpr uint64_t CHECKPOINT_INTERVAL_MS = 2000; // Or this long since the last batch
+
+    /**
+     * @brief Splits a download into fixed-size segments
+     */
+    static std::vector<Segment> fixedSegments(uint64_t size) {
+        std::vector<Segment> segments;
+        for (uint64_t offset = 0; offset < size; offset += SEGMENT_SIZE) {
+            const uint64_t remaining = size - offset;
+            segments.push_back(Segment{offset, remaining < SEGMENT_SIZE ? remaining : static_cast<uint64_t>(SEGMENT_SIZE), ""});
+        }
+        return segments;
+    }
+
+    /**
+     * @brief Uses a file's chunk index as segments
+     */
+    static std::vector<Segment> chunkSegments(const std::vector<ChunkEntry>& chunks) {
+        std::vector<Segment> segments;
+        uint64_t offset = 0;
+        for (const auto& chunk : chunks) {
+            segments.push_back(Segment{offset, chunk.size, chunk.digest});
+            offset += chunk.size;
+        }
+        return segments;
+    }
+
+    /**
+     * @brief Remembers learned connection limits per host in a file
+     * @param path Tuning file; empty disables persistence
+     */
+    void setTuningFile(const std::string& path) {
+        m_tuningFile = path;
+    }
+
+    /**
+     * @brief Sets how far the file is flushed to stable storage
+     * @param durability Durability::FlushAtEnd (the default) flushes before each
+     *                   checkpoint batch; see the file description for the others
+     */
+    void setDurability(Durability durability) {
+        m_durability = durability;
+    }
+
+    /**
+     * @brief Reports progress as segments reach the disk
+     * @param progress Called with the byte count of each completed segment,
+     *                 including segments restored from a checkpoint; may be empty
+     */
+    void setProgress(const std::function<void(uint64_t)>& progress) {
+        m_progress = progress;
+    }
+
+    /**
+     * @brief Counts the bytes a download would resume from its checkpoint, without downloading
+     * @param path Destination file
+     * @param segments Ranges covering the whole file in order
+     * @param identity Text identifying this exact download, as passed to download()
+     * @param durability Level the download would run with
+     * @return Bytes of the segments already complete; 0 if nothing can be resumed
+     */
+    static uint64_t resumableBytes(const std::string& path, const std::vector<Segment>& segments,
+                                   const std::string& identity, Durability durability) {
+        const uint64_t total = segments.empty() ? 0 : segments.back().offset + segments.back().size;
+        const std::string target = RangedFile::writePath(path, durability);
+        DownloadCheckpoint checkpoint(target + ".ckpt", identity, segments.size());
+        if (fileSize(target) != total || !checkpoint.load()) {
+            return 0;
+        }
+        uint64_t done = 0;
+        for (size_t i = 0; i < segments.size(); ++i) {
+            if (checkpoint.isDone(i)) {
+                done += segments[i].size;
+            }
+        }
+        return done;
+    }
+
+    /**
+     * @brief Downloads or resumes a file
+     * @param url Source URL; the server must honour Range requests
+     * @param path Destination file
+     * @param segments Ranges covering the whole file in order
+     * @param identity Text identifying this exact download, e.g. URL and digest
+     * @return true once every segment is on disk under path; the checkpoint is then removed
+     */
+    bool download(const std::string& url, const std::string& path,
+                  const std::vector<Segment>& segments, const std::string& identity) {
+        m_rangeUnsupported = false;
+        m_resumedSegments = 0;
+        m_lastError.clear();
+        const uint64_t total = segments.empty() ? 0 : segments.back().offset + segments.back().size;
+
+        const std::string target = RangedFile::writePath(path, m_durability);
+        DownloadCheckpoint checkpoint(target + ".ckpt", identity, segments.size());
+        const bool resumed = fileSize(target) == total && checkpoint.load();
+
+        RangedFile file(m_durability);
+        if (!file.open(path, total, resumed)) {
+            return fail("Failed to create file: " + target);
+        }
+
+        std::vector<size_t> pending;
+        for (size_t i = 0; i < segments.size(); ++i) {
+            if (!checkpoint.isDone(i)) {
+                pending.push_back(i);
+            }
+        }
+        if (resumed && pending.size() < segments.size()) {
+            m_resumedSegments = segments.size() - pending.size();
+            if (m_progress) {
+                uint64_t restored = total;
+                for (size_t i : pending) {
+                    restored -= segments[i].size;
+                }
+                m_progress(restored);
+            }
+        }
+
+        if (!InternetSession::instance().handle()) {
+            return fail("Failed to initialize internet connection");
+        }
+
+        const std::string host = MirrorTuning::hostOf(url);
+        MirrorTuning tuning(m_tuningFile);
+        ConcurrencyController controller(tuning.connections(host, INITIAL_CONNECTIONS), MAX_CONNECTIONS);
+
+        std::atomic<size_t> next(0);
+        std::atomic<bool> failed(false);
+        std::mutex checkpointMutex;   // Guards the in-memory bitmap and the batch counters
+        std::mutex persistMutex;      // One batch at a time; other workers keep downloading
+        size_t unsaved = 0;
+        uint64_t lastSave = GetTickCount64();
+
+        // Flushes the file, then saves a copy of the bitmap taken before the flush,
+        // so the checkpoint only claims segments whose writes the flush covered
+        auto persist = [&]() {
+            DownloadCheckpoint snapshot(target + ".ckpt", identity, segments.size());
+            {
+                std::lock_guard<std::mutex> lock(checkpointMutex);
+                snapshot = checkpoint;
+                unsaved = 0;
+                lastSave = GetTickCount64();
+            }
+            return file.flush() && snapshot.save();
+        };
+        auto worker = [&]() {
+            std::vector<char> buffer;
+            for (;;) {
+                controller.acquire();
+                const size_t i = next++;
+                if (i >= pending.size() || failed) {
+                    controller.release();
+                    break;
+                }
+                const Segment& segment = segments[pending[i]];
+                bool ok = false;
+                for (int attempt = 0; attempt < SEGMENT_ATTEMPTS && !ok && !failed && !m_rangeUnsupported; ++attempt) {
+                    ok = fetchSegment(url, segment, total, buffer, controller) &&
+                         file.writeAt(segment.offset, buffer.data(), buffer.size());
+                    if (!ok && !m_rangeUnsupported) {
+                        controller.failed();
+                    }
+                }
+                controller.release();
+                bool due = false;
+                {
+                    std::lock_guard<std::mutex> lock(checkpointMutex);
+                    if (!ok) {
+                        if (!failed.exchange(true) && m_lastError.empty()) {
+                            m_lastError = "Failed to download range at offset " + std::to_string(segment.offset) + " of " + url;
+                        }
+                        continue;
+                    }
+                    checkpoint.markDone(pending[i]);
+                    due = ++unsaved >= CHECKPOINT_SEGMENTS || GetTickCount64() - lastSave >= CHECKPOINT_INTERVAL_MS;
+                    if (m_progress) {
+                        m_progress(segment.size);
+                    }
+                }
+                // A worker that finds a batch already being written leaves the segment to the next one
+                if (due && persistMutex.try_lock()) {
+                    std::lock_guard<std::mutex> flushing(persistMutex, std::adopt_lock);
+                    if (!persist() && !failed.exchange(true)) {
+                        std::lock_guard<std::mutex> lock(checkpointMutex);
+                        m_lastError = "Failed to write download checkpoint: " + target + ".ckpt";
+                    }
+                }
+            }
+        };
+
+        // Every worker exists up front; the controller decides how many are fetching
+        const size_t workers = std::min<size_t>(pending.size(), MAX_CONNECTIONS);
+        std::vector<std::thread> threads;
+        for (size_t t = 1; t < workers; ++t) {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        // A failed download keeps its progress in a last batch; a complete one only needs commit()'s flush
+        bool committed = false;
+        if (failed) {
+            persist();
+        } else {
+            committed = file.commit();
+        }
+        m_connections = controller.limit();
+        // The best rate is stored with the limit that reached it, not with one a later back-off left
+        if (!m_tuningFile.empty() && controller.bestRate() > 0) {
+            tuning.record(host, controller.bestLimit(), controller.bestRate());
+        }
+        if (failed) {
+            return false;
+        }
+        if (!committed) {
+            return fail("Failed to flush download: " + target);
+        }
+        checkpoint.remove();
+        return true;
+    }
+
+    /**
+     * @brief Gets the connection limit the last download ended with
+     */
+    unsigned connections() const {
+        return m_connections;
+    }
+
+    /**
+     * @brief Checks whether the last download failed because the server ignores Range
+     */
+    bool rangeUnsupported() const {
+        return m_rangeUnsupported;
+    }
+
+    /**
+     * @brief Gets the number of segments restored from a checkpoint by the last download
+     */
+    size_t resumedSegments() const {
+        return m_resumedSegments;
+    }
+
+    /**
+     * @brief Gets a description of the last failure
+     */
+    const std::string& lastError() const {
+        return m_lastError;
+    }
+
+private:
+    std::string m_lastError;
+    std::string m_tuningFile;
+    std::function<void(uint64_t)> m_progress;
+    Durability m_durability = Durability::FlushAtEnd;
+    std::atomic<bool> m_rangeUnsupported{false};
+    size_t m_resumedSegments = 0;
+    unsigned m_connections = 0;
+
+    bool fail(const std::string& message) {
+        m_lastError = message;
+        return false;
+    }
+
+    static uint64_t fileSize(const std::string& path) {
+        WIN32_FILE_ATTRIBUTE_DATA data;
+        if (!GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &data)) {
+            return UINT64_MAX;
+        }
+        return (static_cast<uint64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+    }
+
+    /**
+     * @brief Fetches one range into memory and verifies it when a digest is known
+     */
+    bool fetchSegment(const std::string& url, const Segment& segment,
+                      uint64_t total, std::vector<char>& buffer, ConcurrencyController& controller) {
+        const std::string headers = "Range: bytes=" + std::to_string(segment.offset) + "-" +
+                                    std::to_string(segment.offset + segment.size - 1) + "\r\n";
+        // A read that hangs for a stall period fails, so the range is retried instead of holding a slot
+        HINTERNET request = InternetSession::instance().openUrl(url, headers, static_cast<DWORD>(ConcurrencyController::STALL_MS));
+        if (!request) {
+            return false;
+        }
+
+        DWORD status = 0;
+        DWORD length = sizeof(status);
+        HttpQueryInfoA(request, HTTP_QUERY_STATUS_CODE | HTTP_QUERY_FLAG_NUMBER, &status, &length, nullptr);
+        const bool wholeFile = segment.offset == 0 && segment.size == total;
+        if (status != 206 && !(status == 200 && wholeFile)) {
+            if (status == 200) {
+                m_rangeUnsupported = true;
+            }
+            InternetCloseHandle(request);
+            return false;
+        }
+
+        buffer.resize(static_cast<size_t>(segment.size));
+        size_t received = 0;
+        DWORD bytesRead = 0;
+        while (received < buffer.size() &&
+               InternetReadFile(request, buffer.data() + received, static_cast<DWORD>(buffer.size() - received), &bytesRead) &&
+               bytesRead > 0) {
+            received += bytesRead;
+            controller.received(bytesRead);
+        }
+        InternetCloseHandle(request);
+        if (received != buffer.size()) {
+            return false;
+        }
+
+        if (!segment.digest.empty()) {
+            const size_t separator = segment.digest.find(':');
+            std::string expected = separator == std::string::npos ? segment.digest : segment.digest.substr(separator + 1);
+            for (auto& c : expected) c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+            Blake3 hasher;
+            hasher.update(buffer.data(), buffer.size());
+            return hasher.hexDigest() == expected;
+        }
+        return true;
+    }
+};
+
+} // namespace AutoUpdaterLib
+
+#endif // AUTO_UPDATER_DOWNLOAD_H
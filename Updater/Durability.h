@@ -0,0 +1,386 @@
+/**
+ * @file Durability.h
+ * @brief How far staged files are flushed to stable storage
+ *
+ * @author myexistences
+ * @copyright Copyright (c) 2025 myexistences. All rights reserved.
+ * @license MIT License
+ *
+ * @description
+ * Files written through the operating system's cache can lose their data
+ * in a power failure even after the write calls returned, while a rename
+ * of the same file may already be on disk. An install that renames such a
+ * file into place then comes back with a zero-filled or truncated
+ * executable. Flushing costs one synchronous disk write per file, so the
+ * level is a choice:
+ *
+ * ```
+ * None        no flushes; the operating system writes back when it likes
+ * FlushAtEnd  each completed file is flushed once, before anything renames it
+ * Ordered     the file is written as "<path>.part", flushed, renamed into
+ *             place and the rename flushed: a file under its final name is
+ *             always complete
+ * ```
+ *
+ * FlushAtEnd is enough for crash-consistent installs: the install journal
+ * only renames flushed files. Ordered additionally keeps torn files out of
+ * the staging directory. On Windows the rename is made durable with
+ * MOVEFILE_WRITE_THROUGH; elsewhere the directory is fsync'ed.
+ *
+ * StagingFile writes a file front to back. RangedFile writes a file of
+ * known size in ranges in any order, as ranged downloads do; its owner
+ * flushes it before each checkpoint batch.
+ * Tools/DurabilityBench.cpp measures the cost of each level for both.
+ */
+
+#ifndef AUTO_UPDATER_DURABILITY_H
+#define AUTO_UPDATER_DURABILITY_H
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace AutoUpdaterLib {
+
+/**
+ * @brief Durability level of staged files
+ */
+enum class Durability {
+    None,        ///< Leave write-back to the operating system
+    FlushAtEnd,  ///< Flush each file once it is complete
+    Ordered      ///< Flush the data, then rename into place and flush the rename
+};
+
+#ifndef _WIN32
+/**
+ * @brief Makes a rename durable by flushing the directory that holds the file
+ */
+inline bool flushDirectory(const std::string& path) {
+    const size_t slash = path.find_last_of('/');
+    const std::string directory = slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+    const int handle = ::open(directory.c_str(), O_RDONLY);
+    if (handle < 0) {
+        return false;
+    }
+    const bool ok = fsync(handle) == 0;
+    ::close(handle);
+    return ok;
+}
+#endif
+
+/**
+ * @class StagingFile
+ * @brief Writes one staged file with a chosen durability
+ */
+class StagingFile {
+public:
+    explicit StagingFile(Durability durability) : m_durability(durability) {}
+
+    ~StagingFile() {
+        abort();
+    }
+
+    StagingFile(const StagingFile&) = delete;
+    StagingFile& operator=(const StagingFile&) = delete;
+
+    /**
+     * @brief Creates the file, replacing an existing one
+     * @param path Final path; with Durability::Ordered it only appears on commit()
+     */
+    bool open(const std::string& path) {
+        abort();
+        m_path = path;
+        m_writePath = m_durability == Durability::Ordered ? path + ".part" : path;
+#ifdef _WIN32
+        m_file = CreateFileA(m_writePath.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        return m_file != INVALID_HANDLE_VALUE;
+#else
+        m_file = ::open(m_writePath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        return m_file >= 0;
+#endif
+    }
+
+    /**
+     * @brief Appends data
+     * @return false on a write error; the file should then be abandoned with abort()
+     */
+    bool write(const char* data, size_t size) {
+        while (size > 0) {
+#ifdef _WIN32
+            const DWORD chunk = size > 0x40000000 ? 0x40000000 : static_cast<DWORD>(size);
+            DWORD written = 0;
+            if (!WriteFile(m_file, data, chunk, &written, nullptr) || written == 0) {
+                return false;
+            }
+#else
+            const ssize_t written = ::write(m_file, data, size);
+            if (written < 0 && errno == EINTR) {
+                continue;
+            }
+            if (written <= 0) {
+                return false;
+            }
+#endif
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+        return true;
+    }
+
+    /**
+     * @brief Completes the file with the configured durability and closes it
+     * @return false if flushing, closing or the rename failed; the file is then removed
+     */
+    bool commit() {
+        if (!isOpen()) {
+            return false;
+        }
+        bool ok = m_durability == Durability::None || flush();
+        ok = closeFile() && ok;
+        if (ok && m_durability == Durability::Ordered) {
+#ifdef _WIN32
+            ok = MoveFileExA(m_writePath.c_str(), m_path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+            ok = std::rename(m_writePath.c_str(), m_path.c_str()) == 0 && flushDirectory(m_path);
+#endif
+        }
+        if (!ok) {
+            std::remove(m_writePath.c_str());
+        }
+        return ok;
+    }
+
+    /**
+     * @brief Closes and deletes an uncommitted file
+     */
+    void abort() {
+        if (isOpen()) {
+            closeFile();
+            std::remove(m_writePath.c_str());
+        }
+    }
+
+    /**
+     * @brief Flushes the cached data of an existing file, whoever wrote it
+     */
+    static bool flushFile(const std::string& path) {
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                                  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        const bool ok = FlushFileBuffers(file) != 0;
+        CloseHandle(file);
+#else
+        const int file = ::open(path.c_str(), O_WRONLY);
+        if (file < 0) {
+            return false;
+        }
+        const bool ok = fsync(file) == 0;
+        ::close(file);
+#endif
+        return ok;
+    }
+
+private:
+    Durability m_durability;
+    std::string m_path;
+    std::string m_writePath;
+#ifdef _WIN32
+    HANDLE m_file = INVALID_HANDLE_VALUE;
+
+    bool isOpen() const { return m_file != INVALID_HANDLE_VALUE; }
+
+    bool flush() { return FlushFileBuffers(m_file) != 0; }
+
+    bool closeFile() {
+        const bool ok = CloseHandle(m_file) != 0;
+        m_file = INVALID_HANDLE_VALUE;
+        return ok;
+    }
+#else
+    int m_file = -1;
+
+    bool isOpen() const { return m_file >= 0; }
+
+    bool flush() { return fsync(m_file) == 0; }
+
+    bool closeFile() {
+        const bool ok = ::close(m_file) == 0;
+        m_file = -1;
+        return ok;
+    }
+
+#endif
+};
+
+/**
+ * @class RangedFile
+ * @brief Writes a file of known size in ranges, in any order, with a chosen durability
+ *
+ * Unlike StagingFile, an unfinished file is kept when it is closed, so a
+ * later open() can resume it.
+ */
+class RangedFile {
+public:
+    explicit RangedFile(Durability durability) : m_durability(durability) {}
+
+    ~RangedFile() {
+        close();
+    }
+
+    RangedFile(const RangedFile&) = delete;
+    RangedFile& operator=(const RangedFile&) = delete;
+
+    /**
+     * @brief Gets the file written until commit()
+     * @return "<path>.part" with Durability::Ordered, otherwise path
+     */
+    static std::string writePath(const std::string& path, Durability durability) {
+        return durability == Durability::Ordered ? path + ".part" : path;
+    }
+
+    /**
+     * @brief Opens the file for writing
+     * @param path Final path; with Durability::Ordered it only appears on commit()
+     * @param size Size of the complete file
+     * @param resume true to keep the existing content of writePath(), false to recreate it
+     */
+    bool open(const std::string& path, uint64_t size, bool resume) {
+        close();
+        m_path = path;
+        m_writePath = writePath(path, m_durability);
+#ifdef _WIN32
+        m_file = CreateFileA(m_writePath.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                             resume ? OPEN_EXISTING : CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (m_file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        FILE_END_OF_FILE_INFO endOfFile;
+        endOfFile.EndOfFile.QuadPart = static_cast<LONGLONG>(size);
+        if (!resume && !SetFileInformationByHandle(m_file, FileEndOfFileInfo, &endOfFile, sizeof(endOfFile))) {
+            close();
+            return false;
+        }
+#else
+        m_file = ::open(m_writePath.c_str(), resume ? O_RDWR : O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (m_file < 0) {
+            return false;
+        }
+        if (!resume && ftruncate(m_file, static_cast<off_t>(size)) != 0) {
+            close();
+            return false;
+        }
+#endif
+        return true;
+    }
+
+    /**
+     * @brief Writes a range; safe to call from several threads for disjoint ranges
+     */
+    bool writeAt(uint64_t offset, const char* data, size_t size) {
+        while (size > 0) {
+#ifdef _WIN32
+            OVERLAPPED position;
+            std::memset(&position, 0, sizeof(position));
+            position.Offset = static_cast<DWORD>(offset);
+            position.OffsetHigh = static_cast<DWORD>(offset >> 32);
+            const DWORD chunk = size > 0x40000000 ? 0x40000000 : static_cast<DWORD>(size);
+            DWORD written = 0;
+            if (!WriteFile(m_file, data, chunk, &written, &position) || written == 0) {
+                return false;
+            }
+#else
+            const ssize_t written = pwrite(m_file, data, size, static_cast<off_t>(offset));
+            if (written < 0 && errno == EINTR) {
+                continue;
+            }
+            if (written <= 0) {
+                return false;
+            }
+#endif
+            data += written;
+            offset += static_cast<uint64_t>(written);
+            size -= static_cast<size_t>(written);
+        }
+        return true;
+    }
+
+    /**
+     * @brief Makes every range written so far durable; does nothing with Durability::None
+     */
+    bool flush() {
+        if (m_durability == Durability::None) {
+            return true;
+        }
+#ifdef _WIN32
+        return FlushFileBuffers(m_file) != 0;
+#else
+        return fsync(m_file) == 0;
+#endif
+    }
+
+    /**
+     * @brief Completes the file: flushes it, closes it and with Durability::Ordered renames it into place
+     * @return false if a step failed; the unfinished file is then kept
+     */
+    bool commit() {
+        if (!isOpen()) {
+            return false;
+        }
+        bool ok = flush();
+        ok = close() && ok;
+        if (ok && m_durability == Durability::Ordered) {
+#ifdef _WIN32
+            ok = MoveFileExA(m_writePath.c_str(), m_path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+            ok = std::rename(m_writePath.c_str(), m_path.c_str()) == 0 && flushDirectory(m_path);
+#endif
+        }
+        return ok;
+    }
+
+    /**
+     * @brief Closes the file, keeping what was written
+     */
+    bool close() {
+        if (!isOpen()) {
+            return true;
+        }
+#ifdef _WIN32
+        const bool ok = CloseHandle(m_file) != 0;
+        m_file = INVALID_HANDLE_VALUE;
+#else
+        const bool ok = ::close(m_file) == 0;
+        m_file = -1;
+#endif
+        return ok;
+    }
+
+private:
+    Durability m_durability;
+    std::string m_path;
+    std::string m_writePath;
+#ifdef _WIN32
+    HANDLE m_file = INVALID_HANDLE_VALUE;
+
+    bool isOpen() const { return m_file != INVALID_HANDLE_VALUE; }
+#else
+    int m_file = -1;
+
+    bool isOpen() const { return m_file >= 0; }
+#endif
+};
+
+} // namespace AutoUpdaterLib
+
+#endif // AUTO_UPDATER_DURABILITY_H
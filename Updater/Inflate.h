@@ -0,0 +1,466 @@
+/**
+ * @file Inflate.h
+ * @brief Dependency-free DEFLATE (RFC 1951) decoder
+ *
+ * @author myexistences
+ * @copyright Copyright (c) 2025 myexistences. All rights reserved.
+ * @license MIT License
+ *
+ * @description
+ * Decodes raw DEFLATE streams such as zip entries. Input is pulled from a
+ * source callback and output is pushed to a sink in large blocks, so memory
+ * use is one 32 KiB history window plus fixed buffers regardless of the
+ * stream's size. Huffman codes up to 10 bits are decoded with a single
+ * table lookup; longer codes fall back to canonical bit-by-bit decoding.
+ */
+
+#ifndef AUTO_UPDATER_INFLATE_H
+#define AUTO_UPDATER_INFLATE_H
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+#include "MemoryProfile.h"
+
+namespace AutoUpdaterLib {
+
+/**
+ * @class Inflater
+ * @brief Streaming raw DEFLATE decoder
+ */
+class Inflater {
+public:
+    /// Fills a buffer with up to `capacity` compressed bytes; returns 0 at end of input
+    typedef std::function<size_t(uint8_t* buffer, size_t capacity)> Source;
+    /// Receives decompressed bytes; returning false aborts decoding
+    typedef std::function<bool(const uint8_t* data, size_t length)> Sink;
+
+    Inflater() : m_input(INPUT_SIZE), m_output(WINDOW_SIZE + FLUSH_SIZE) {}
+
+    /**
+     * @brief Decodes one complete DEFLATE stream
+     * @param source Compressed input
+     * @param sink Decompressed output
+     * @return true if the final block was decoded; see lastError() otherwise
+     */
+    bool inflate(const Source& source, const Sink& sink) {
+        m_source = &source;
+        m_sink = &sink;
+        m_inputPos = m_inputLen = 0;
+        m_bitBuffer = 0;
+        m_bitCount = 0;
+        m_outputPos = 0;
+        m_error.clear();
+
+        bool last = false;
+        while (!last) {
+            uint32_t header = 0;
+            if (!bits(3, header)) {
+                return false;
+            }
+            last = (header & 1) != 0;
+
+            bool ok = false;
+            switch (header >> 1) {
+                case 0: ok = storedBlock(); break;
+                case 1: ok = fixedBlock(); break;
+                case 2: ok = dynamicBlock(); break;
+                default: return fail("Invalid DEFLATE block type");
+            }
+            if (!ok) {
+                return false;
+            }
+        }
+        return flush(m_outputPos);
+    }
+
+    /**
+     * @brief Describes why the last inflate() failed
+     */
+    const std::string& lastError() const {
+        return m_error;
+    }
+
+private:
+    static constexpr size_t INPUT_SIZE = MemoryProfile::BOUNDED ? 8 * 1024 : 64 * 1024;
+    static constexpr size_t WINDOW_SIZE = 32 * 1024;
+    static constexpr size_t FLUSH_SIZE = MemoryProfile::BOUNDED ? 8 * 1024 : 256 * 1024;
+    static constexpr unsigned MAX_BITS = 15;
+    static constexpr unsigned FAST_BITS = 10;
+
+    /**
+     * @struct Huffman
+     * @brief Canonical Huffman code with a direct lookup table for short codes
+     */
+    struct Huffman {
+        uint16_t fast[1 << FAST_BITS]; // (symbol << 4) | length, 0 if the code is longer
+        uint16_t count[MAX_BITS + 1];
+        uint16_t symbol[320];
+
+        bool build(const uint8_t* lengths, size_t n) {
+            std::memset(count, 0, sizeof(count));
+            for (size_t i = 0; i < n; ++i) {
+                ++count[lengths[i]];
+            }
+            count[0] = 0;
+
+            int left = 1;
+            for (unsigned len = 1; len <= MAX_BITS; ++len) {
+                left = (left << 1) - count[len];
+                if (left < 0) {
+                    return false; // Over-subscribed
+                }
+            }
+
+            uint16_t offsets[MAX_BITS + 1];
+            offsets[1] = 0;
+            for (unsigned len = 1; len < MAX_BITS; ++len) {
+                offsets[len + 1] = static_cast<uint16_t>(offsets[len] + count[len]);
+            }
+            for (size_t i = 0; i < n; ++i) {
+                if (lengths[i] != 0) {
+                    symbol[offsets[lengths[i]]++] = static_cast<uint16_t>(i);
+                }
+            }
+
+            std::memset(fast, 0, sizeof(fast));
+            uint32_t code = 0;
+            size_t index = 0;
+            for (unsigned len = 1; len <= FAST_BITS; ++len) {
+                for (unsigned k = 0; k < count[len]; ++k, ++code, ++index) {
+                    // Stream bits arrive LSB first, so the table is indexed by the reversed code
+                    uint32_t reversed = 0;
+                    for (unsigned b = 0; b < len; ++b) {
+                        reversed |= ((code >> b) & 1) << (len - 1 - b);
+                    }
+                    for (uint32_t fill = reversed; fill < (1u << FAST_BITS); fill += 1u << len) {
+                        fast[fill] = static_cast<uint16_t>((symbol[index] << 4) | len);
+                    }
+                }
+                code <<= 1;
+            }
+            return true;
+        }
+    };
+
+    const Source* m_source = nullptr;
+    const Sink* m_sink = nullptr;
+    std::vector<uint8_t> m_input;
+    size_t m_inputPos = 0;
+    size_t m_inputLen = 0;
+    uint64_t m_bitBuffer = 0;
+    unsigned m_bitCount = 0;
+    std::vector<uint8_t> m_output;
+    size_t m_outputPos = 0;
+    std::string m_error;
+    Huffman m_lengthCode;
+    Huffman m_distanceCode;
+
+    bool fail(const std::string& message) {
+        m_error = message;
+        return false;
+    }
+
+    bool nextByte(uint8_t& byte) {
+        if (m_inputPos == m_inputLen) {
+            m_inputLen = (*m_source)(m_input.data(), m_input.size());
+            m_inputPos = 0;
+            if (m_inputLen == 0) {
+                return false;
+            }
+        }
+        byte = m_input[m_inputPos++];
+        return true;
+    }
+
+    bool need(unsigned n) {
+        while (m_bitCount < n) {
+            uint8_t byte = 0;
+            if (!nextByte(byte)) {
+                return fail("Unexpected end of compressed data");
+            }
+            m_bitBuffer |= static_cast<uint64_t>(byte) << m_bitCount;
+            m_bitCount += 8;
+        }
+        return true;
+    }
+
+    bool bits(unsigned n, uint32_t& value) {
+        if (!need(n)) {
+            return false;
+        }
+        value = static_cast<uint32_t>(m_bitBuffer & ((1ULL << n) - 1));
+        m_bitBuffer >>= n;
+        m_bitCount -= n;
+        return true;
+    }
+
+    /**
+     * @brief Tops up the bit buffer without failing at end of input
+     */
+    void prefetch(unsigned n) {
+        while (m_bitCount < n) {
+            uint8_t byte = 0;
+            if (!nextByte(byte)) {
+                return;
+            }
+            m_bitBuffer |= static_cast<uint64_t>(byte) << m_bitCount;
+            m_bitCount += 8;
+        }
+    }
+
+    bool decode(const Huffman& huffman, uint32_t& symbol) {
+        prefetch(FAST_BITS);
+        const uint16_t entry = huffman.fast[m_bitBuffer & ((1u << FAST_BITS) - 1)];
+        const unsigned length = entry & 0x0F;
+        if (entry != 0 && length <= m_bitCount) {
+            symbol = entry >> 4;
+            m_bitBuffer >>= length;
+            m_bitCount -= length;
+            return true;
+        }
+
+        // Canonical decode one bit at a time for long codes
+        int code = 0;
+        int first = 0;
+        int index = 0;
+        for (unsigned len = 1; len <= MAX_BITS; ++len) {
+            uint32_t bit = 0;
+            if (!bits(1, bit)) {
+                return false;
+            }
+            code |= static_cast<int>(bit);
+            const int count = huffman.count[len];
+            if (code - count < first) {
+                symbol = huffman.symbol[index + (code - first)];
+                return true;
+            }
+            index += count;
+            first = (first + count) << 1;
+            code <<= 1;
+        }
+        return fail("Invalid Huffman code");
+    }
+
+    bool flush(size_t length) {
+        if (length > 0 && !(*m_sink)(m_output.data(), length)) {
+            return fail("Output rejected");
+        }
+        return true;
+    }
+
+    bool put(uint8_t byte) {
+        if (m_outputPos == m_output.size() && !slide()) {
+            return false;
+        }
+        m_output[m_outputPos++] = byte;
+        return true;
+    }
+
+    /**
+     * @brief Flushes the output buffer, keeping the last 32 KiB as history
+     */
+    bool slide() {
+        const size_t keep = WINDOW_SIZE;
+        if (!flush(m_outputPos - keep)) {
+            return false;
+        }
+        std::memmove(m_output.data(), m_output.data() + m_outputPos - keep, keep);
+        m_outputPos = keep;
+        return true;
+    }
+
+    /**
+     * @brief Copies a stored (uncompressed) block to the output
+     */
+    bool storedBlock() {
+        m_bitBuffer >>= m_bitCount & 7;
+        m_bitCount -= m_bitCount & 7;
+
+        uint32_t length = 0;
+        uint32_t complement = 0;
+        if (!bits(16, length) || !bits(16, complement)) {
+            return false;
+        }
+        if ((length ^ 0xFFFF) != complement) {
+            return fail("Corrupt stored block length");
+        }
+
+        while (length > 0 && m_bitCount >= 8) {
+            if (!put(static_cast<uint8_t>(m_bitBuffer))) {
+                return false;
+            }
+            m_bitBuffer >>= 8;
+            m_bitCount -= 8;
+            --length;
+        }
+        while (length > 0) {
+            uint8_t byte = 0;
+            if (!nextByte(byte)) {
+                return fail("Unexpected end of stored block");
+            }
+            if (!put(byte)) {
+                return false;
+            }
+            --length;
+        }
+        return true;
+    }
+
+    bool fixedBlock() {
+        uint8_t lengths[288 + 30];
+        size_t i = 0;
+        for (; i < 144; ++i) lengths[i] = 8;
+        for (; i < 256; ++i) lengths[i] = 9;
+        for (; i < 280; ++i) lengths[i] = 7;
+        for (; i < 288; ++i) lengths[i] = 8;
+        for (; i < 288 + 30; ++i) lengths[i] = 5;
+        m_lengthCode.build(lengths, 288);
+        m_distanceCode.build(lengths + 288, 30);
+        return codes();
+    }
+
+    bool dynamicBlock() {
+        static const uint8_t ORDER[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+        uint32_t nlen = 0, ndist = 0, ncode = 0;
+        if (!bits(5, nlen) || !bits(5, ndist) || !bits(4, ncode)) {
+            return false;
+        }
+        nlen += 257;
+        ndist += 1;
+        ncode += 4;
+        if (nlen > 286 || ndist > 30) {
+            return fail("Bad DEFLATE code counts");
+        }
+
+        uint8_t lengths[288 + 32] = {0};
+        for (uint32_t i = 0; i < ncode; ++i) {
+            uint32_t value = 0;
+            if (!bits(3, value)) {
+                return false;
+            }
+            lengths[ORDER[i]] = static_cast<uint8_t>(value);
+        }
+
+        Huffman lengthLengths;
+        if (!lengthLengths.build(lengths, 19)) {
+            return fail("Bad code-length code");
+        }
+
+        uint8_t codeLengths[288 + 32] = {0};
+        uint32_t index = 0;
+        while (index < nlen + ndist) {
+            uint32_t symbol = 0;
+            if (!decode(lengthLengths, symbol)) {
+                return false;
+            }
+            if (symbol < 16) {
+                codeLengths[index++] = static_cast<uint8_t>(symbol);
+                continue;
+            }
+
+            uint8_t repeatValue = 0;
+            uint32_t repeat = 0;
+            if (symbol == 16) {
+                if (index == 0) {
+                    return fail("Repeat with no previous length");
+                }
+                repeatValue = codeLengths[index - 1];
+                if (!bits(2, repeat)) return false;
+                repeat += 3;
+            } else if (symbol == 17) {
+                if (!bits(3, repeat)) return false;
+                repeat += 3;
+            } else {
+                if (!bits(7, repeat)) return false;
+                repeat += 11;
+            }
+            if (index + repeat > nlen + ndist) {
+                return fail("Too many code lengths");
+            }
+            while (repeat-- > 0) {
+                codeLengths[index++] = repeatValue;
+            }
+        }
+
+        if (codeLengths[256] == 0) {
+            return fail("Missing end-of-block code");
+        }
+        if (!m_lengthCode.build(codeLengths, nlen) || !m_distanceCode.build(codeLengths + nlen, ndist)) {
+            return fail("Bad literal/length or distance code");
+        }
+        return codes();
+    }
+
+    bool codes() {
+        static const uint16_t LENGTH_BASE[29] = {
+            3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+            35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+        static const uint8_t LENGTH_EXTRA[29] = {
+            0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+        static const uint16_t DIST_BASE[30] = {
+            1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+            257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+        static const uint8_t DIST_EXTRA[30] = {
+            0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+        for (;;) {
+            uint32_t symbol = 0;
+            if (!decode(m_lengthCode, symbol)) {
+                return false;
+            }
+            if (symbol < 256) {
+                if (!put(static_cast<uint8_t>(symbol))) {
+                    return false;
+                }
+                continue;
+            }
+            if (symbol == 256) {
+                return true;
+            }
+
+            symbol -= 257;
+            if (symbol >= 29) {
+                return fail("Invalid length symbol");
+            }
+            uint32_t extra = 0;
+            if (!bits(LENGTH_EXTRA[symbol], extra)) {
+                return false;
+            }
+            const size_t length = LENGTH_BASE[symbol] + extra;
+
+            uint32_t distSymbol = 0;
+            if (!decode(m_distanceCode, distSymbol)) {
+                return false;
+            }
+            if (distSymbol >= 30) {
+                return fail("Invalid distance symbol");
+            }
+            if (!bits(DIST_EXTRA[distSymbol], extra)) {
+                return false;
+            }
+            const size_t distance = DIST_BASE[distSymbol] + extra;
+
+            // Make room first so the match source stays inside the buffer
+            if (m_outputPos + length > m_output.size() && !slide()) {
+                return false;
+            }
+            if (distance > m_outputPos) {
+                return fail("Distance too far back");
+            }
+            uint8_t* out = m_output.data() + m_outputPos;
+            const uint8_t* from = out - distance;
+            for (size_t i = 0; i < length; ++i) {
+                out[i] = from[i];
+            }
+            m_outputPos += length;
+        }
+    }
+};
+
+} // namespace AutoUpdaterLib
+
+#endif // AUTO_UPDATER_INFLATE_H
@@ -0,0 +1,342 @@
+/**
+ * @file Journal.h
+ * @brief Write-ahead journal that makes applying an update crash-consistent
+ *
+ * @author myexistences
+ * @copyright Copyright (c) 2025 myexistences. All rights reserved.
+ * @license MIT License
+ *
+ * @description
+ * An update is applied in two phases, recorded in `<install>\.update_journal`:
+ *
+ * 1. Prepare: every new file is flushed and moved, or written, into
+ *    `<install>\.pending\new`, then a COMMIT record is flushed to the journal.
+ *    A rename can reach the disk before the renamed file's data, so moved
+ *    files are flushed first unless the durability is Durability::None.
+ * 2. Replace: for each file the installed copy is renamed into
+ *    `.pending\old`, the new copy is renamed into place and a DONE record is
+ *    appended. Renames use MOVEFILE_WRITE_THROUGH, and every record is
+ *    flushed before the next step starts.
+ *
+ * Each record carries a CRC-32, so a record torn by a power loss is ignored.
+ * After a crash, recover() uses only local data. Without COMMIT the install
+ * was never touched and the pending files are discarded. With COMMIT the
+ * replacement is rolled forward; if that fails, an ABORT record is written
+ * and every file is moved back from `.pending\old`.
+ */
+
+#ifndef AUTO_UPDATER_JOURNAL_H
+#define AUTO_UPDATER_JOURNAL_H
+
+#include <windows.h>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <set>
+#include <string>
+#include <vector>
+#include "Archive.h"
+#include "Durability.h"
+#include "Snapshot.h"
+
+namespace AutoUpdaterLib {
+
+/**
+ * @class ApplyJournal
+ * @brief Applies file replacements to an install directory through a journal
+ */
+class ApplyJournal {
+public:
+    static constexpr const char* JOURNAL_NAME = ".update_journal";
+    static constexpr const char* PENDING_DIRECTORY = ".pending";
+
+    /**
+     * @struct Replacement
+     * @brief One file to install
+     */
+    struct Replacement {
+        std::string source;   ///< New file; moved, so it may live on another volume
+        std::string target;   ///< Path relative to the install directory, '\\'-separated
+        /// Writes and flushes the new file at the given path instead of moving source
+        std::function<bool(const std::string&)> write;
+
+        Replacement() {}
+        Replacement(const std::string& sourcePath, const std::string& targetPath)
+            : source(sourcePath), target(targetPath) {}
+    };
+
+    /**
+     * @brief Creates a journal for an install directory
+     * @param installDir Install directory
+     * @param durability Durability::None skips flushing moved files; any other level flushes them
+     */
+    explicit ApplyJournal(const std::string& installDir, Durability durability = Durability::FlushAtEnd)
+        : m_durability(durability),
+          m_installDir(installDir),
+          m_journalPath(installDir + "\\" + JOURNAL_NAME),
+          m_pendingDir(installDir + "\\" + PENDING_DIRECTORY) {}
+
+    ~ApplyJournal() {
+        close();
+    }
+
+    ApplyJournal(const ApplyJournal&) = delete;
+    ApplyJournal& operator=(const ApplyJournal&) = delete;
+
+    /**
+     * @brief Checks whether an interrupted apply left a journal behind
+     */
+    bool needsRecovery() const {
+        return GetFileAttributesA(m_journalPath.c_str()) != INVALID_FILE_ATTRIBUTES;
+    }
+
+    /**
+     * @brief Applies a set of replacements
+     * @param replacements Files to install
+     * @param description Free text recorded in the journal, e.g. "1.0 -> 1.1"
+     * @return true if every file was replaced; on failure the install is unchanged
+     */
+    bool apply(const std::vector<Replacement>& replacements, const std::string& description) {
+        if (needsRecovery() && !recover()) {
+            return false;
+        }
+        RollbackSnapshot::removeTree(m_pendingDir);
+
+        std::vector<std::string> targets;
+        if (!open() || !append("BEGIN " + description)) {
+            return fail("Failed to create journal: " + m_journalPath);
+        }
+        for (const auto& replacement : replacements) {
+            const std::string staged = newPath(replacement.target);
+            if (!append("FILE " + replacement.target) || !RollbackSnapshot::createParents(staged) ||
+                !(replacement.write ? replacement.write(staged)
+                                    : (m_durability == Durability::None || StagingFile::flushFile(replacement.source)) &&
+                                      MoveFileExA(replacement.source.c_str(), staged.c_str(),
+                                                  MOVEFILE_COPY_ALLOWED | MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0)) {
+                discard();
+                return fail("Failed to stage " + replacement.target);
+            }
+            targets.push_back(replacement.target);
+        }
+        if (!append("COMMIT")) {
+            discard();
+            return fail("Failed to commit journal: " + m_journalPath);
+        }
+
+        return rollForward(targets, std::set<std::string>());
+    }
+
+    /**
+     * @brief Finishes or undoes an apply interrupted by a crash
+     * @return true if the install is consistent again, or there was nothing to do
+     */
+    bool recover() {
+        if (!needsRecovery()) {
+            return true;
+        }
+
+        std::vector<std::string> targets;
+        std::set<std::string> done;
+        std::set<std::string> undone;
+        bool committed = false;
+        bool aborted = false;
+        for (const auto& record : readRecords()) {
+            if (record.compare(0, 5, "FILE ") == 0) {
+                targets.push_back(record.substr(5));
+            } else if (record.compare(0, 5, "DONE ") == 0) {
+                done.insert(record.substr(5));
+            } else if (record.compare(0, 7, "UNDONE ") == 0) {
+                undone.insert(record.substr(7));
+            } else if (record == "COMMIT") {
+                committed = true;
+            } else if (record == "ABORT") {
+                aborted = true;
+            }
+        }
+
+        if (!committed) {
+            discard();
+            return true;
+        }
+        if (!open()) {
+            return fail("Failed to reopen journal: " + m_journalPath);
+        }
+        return aborted ? rollBack(targets, undone) : rollForward(targets, done);
+    }
+
+    /**
+     * @brief Gets a description of the last failure
+     */
+    const std::string& lastError() const {
+        return m_lastError;
+    }
+
+private:
+    Durability m_durability;
+    std::string m_installDir;
+    std::string m_journalPath;
+    std::string m_pendingDir;
+    std::string m_lastError;
+    HANDLE m_journal = INVALID_HANDLE_VALUE;
+
+    std::string targetPath(const std::string& target) const { return m_installDir + "\\" + target; }
+    std::string newPath(const std::string& target) const { return m_pendingDir + "\\new\\" + target; }
+    std::string oldPath(const std::string& target) const { return m_pendingDir + "\\old\\" + target; }
+
+    static bool exists(const std::string& path) {
+        return GetFileAttributesA(path.c_str()) != INVALID_FILE_ATTRIBUTES;
+    }
+
+    bool fail(const std::string& message) {
+        m_lastError = message;
+        return false;
+    }
+
+    /**
+     * @brief Replaces each file not yet recorded as done, then finishes
+     *
+     * Each step is idempotent: a missing new copy means it is already in
+     * place, and an existing old copy means the original was moved aside.
+     */
+    bool rollForward(const std::vector<std::string>& targets, const std::set<std::string>& done) {
+        for (const auto& target : targets) {
+            if (done.count(target)) {
+                continue;
+            }
+            const std::string installed = targetPath(target);
+            const std::string replacement = newPath(target);
+            const std::string original = oldPath(target);
+            bool ok = true;
+            if (exists(replacement)) {
+                if (exists(installed) && !exists(original)) {
+                    ok = RollbackSnapshot::createParents(original) &&
+                         MoveFileExA(installed.c_str(), original.c_str(), MOVEFILE_WRITE_THROUGH);
+                }
+                ok = ok && RollbackSnapshot::createParents(installed) &&
+                     MoveFileExA(replacement.c_str(), installed.c_str(), MOVEFILE_WRITE_THROUGH);
+            }
+            if (!ok || !append("DONE " + target)) {
+                const std::string message = "Failed to replace " + installed;
+                if (!append("ABORT") || !rollBack(targets, std::set<std::string>())) {
+                    return fail(message + "; rollback incomplete: " + m_lastError);
+                }
+                return fail(message + "; update rolled back");
+            }
+        }
+        finish();
+        return true;
+    }
+
+    /**
+     * @brief Moves every original back into place and removes added files
+     *
+     * Restored files are recorded as UNDONE, so a rollback interrupted by a
+     * second crash does not mistake a restored original for an added file.
+     */
+    bool rollBack(const std::vector<std::string>& targets, const std::set<std::string>& undone) {
+        for (auto it = targets.rbegin(); it != targets.rend(); ++it) {
+            if (undone.count(*it)) {
+                continue;
+            }
+            const std::string installed = targetPath(*it);
+            const std::string replacement = newPath(*it);
+            const std::string original = oldPath(*it);
+            bool ok = true;
+            if (exists(original)) {
+                ok = MoveFileExA(original.c_str(), installed.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+            } else if (!exists(replacement) && exists(installed)) {
+                ok = DeleteFileA(installed.c_str()) != 0; // The update added this file
+            }
+            if (!ok || !append("UNDONE " + *it)) {
+                return fail("Failed to restore " + installed);
+            }
+        }
+        finish();
+        return true;
+    }
+
+    /**
+     * @brief Drops the journal and pending files of an apply that never committed
+     */
+    void discard() {
+        close();
+        DeleteFileA(m_journalPath.c_str());
+        RollbackSnapshot::removeTree(m_pendingDir);
+    }
+
+    /**
+     * @brief Removes the journal once the install is consistent
+     *
+     * Originals of files still in use (such as the running executable) may
+     * survive in `.pending\old` until the next apply clears it.
+     */
+    void finish() {
+        close();
+        DeleteFileA(m_journalPath.c_str());
+        RollbackSnapshot::removeTree(m_pendingDir);
+    }
+
+    bool open() {
+        close();
+        m_journal = CreateFileA(m_journalPath.c_str(), GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                                OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_WRITE_THROUGH, nullptr);
+        if (m_journal == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        LARGE_INTEGER end;
+        end.QuadPart = 0;
+        return SetFilePointerEx(m_journal, end, nullptr, FILE_END) != 0;
+    }
+
+    void close() {
+        if (m_journal != INVALID_HANDLE_VALUE) {
+            CloseHandle(m_journal);
+            m_journal = INVALID_HANDLE_VALUE;
+        }
+    }
+
+    /**
+     * @brief Appends one record and flushes it before returning
+     */
+    bool append(const std::string& record) {
+        Crc32 crc;
+        crc.update(reinterpret_cast<const uint8_t*>(record.data()), record.size());
+        char prefix[10];
+        std::snprintf(prefix, sizeof(prefix), "%08X ", static_cast<unsigned>(crc.value()));
+        const std::string line = prefix + record + "\n";
+
+        DWORD written = 0;
+        return m_journal != INVALID_HANDLE_VALUE &&
+               WriteFile(m_journal, line.data(), static_cast<DWORD>(line.size()), &written, nullptr) &&
+               written == line.size() &&
+               FlushFileBuffers(m_journal);
+    }
+
+    /**
+     * @brief Reads records up to the first torn or corrupt one
+     */
+    std::vector<std::string> readRecords() const {
+        std::vector<std::string> records;
+        std::ifstream file(m_journalPath, std::ios::binary);
+        std::string line;
+        while (std::getline(file, line) && !file.eof()) {
+            if (line.size() < 9 || line[8] != ' ') {
+                break;
+            }
+            const std::string record = line.substr(9);
+            Crc32 crc;
+            crc.update(reinterpret_cast<const uint8_t*>(record.data()), record.size());
+            char expected[9];
+            std::snprintf(expected, sizeof(expected), "%08X", static_cast<unsigned>(crc.value()));
+            if (line.compare(0, 8, expected) != 0) {
+                break;
+            }
+            records.push_back(record);
+        }
+        return records;
+    }
+};
+
+} // namespace AutoUpdaterLib
+
+#endif // AUTO_UPDATER_JOURNAL_H
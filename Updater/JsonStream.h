@@ -0,0 +1,352 @@
+/**
+ * @file JsonStream.h
+ * @brief Push-mode JSON tokenizer with fixed memory use
+ *
+ * @author myexistences
+ * @copyright Copyright (c) 2025 myexistences. All rights reserved.
+ * @license MIT License
+ *
+ * @description
+ * Parses JSON fed in arbitrary pieces and reports structure and scalar
+ * values to a handler as they complete, without building a document.
+ * Memory is one token buffer of at most MemoryProfile::MAX_TOKEN_SIZE and a
+ * fixed nesting stack; longer tokens or deeper nesting are errors.
+ * Strings are unescaped, including \\u escapes and surrogate pairs; numbers
+ * are passed through as text.
+ */
+
+#ifndef AUTO_UPDATER_JSON_STREAM_H
+#define AUTO_UPDATER_JSON_STREAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "MemoryProfile.h"
+
+namespace AutoUpdaterLib {
+
+/**
+ * @class JsonStreamParser
+ * @brief Incremental JSON parser driving a Handler
+ */
+class JsonStreamParser {
+public:
+    static constexpr size_t MAX_DEPTH = 32;
+
+    enum class ValueType { String, Number, True, False, Null };
+
+    /**
+     * @class Handler
+     * @brief Receives parse events; returning false stops parsing with an error
+     */
+    class Handler {
+    public:
+        virtual ~Handler() {}
+        virtual bool startObject() = 0;
+        virtual bool endObject() = 0;
+        virtual bool startArray() = 0;
+        virtual bool endArray() = 0;
+        virtual bool key(const std::string& name) = 0;
+        virtual bool value(ValueType type, const std::string& text) = 0;
+    };
+
+    explicit JsonStreamParser(Handler& handler) : m_handler(handler) {
+        m_token.reserve(64);
+    }
+
+    /**
+     * @brief Parses the next piece of input
+     * @return false once the input is malformed or the handler refused it
+     */
+    bool feed(const char* data, size_t length) {
+        for (size_t i = 0; i < length && m_error.empty(); ++i) {
+            if (!step(data[i])) {
+                if (m_error.empty()) {
+                    fail("Rejected by handler");
+                }
+            }
+        }
+        return m_error.empty();
+    }
+
+    /**
+     * @brief Signals the end of input
+     * @return true if exactly one complete JSON value was parsed
+     */
+    bool finish() {
+        if (m_error.empty() && (m_state == State::Number || m_state == State::Literal) && m_depth == 0) {
+            if (!completeScalar()) {
+                return false;
+            }
+        }
+        if (m_error.empty() && m_state != State::Done) {
+            fail("Unexpected end of JSON");
+        }
+        return m_error.empty();
+    }
+
+    /**
+     * @brief Describes why parsing failed
+     */
+    const std::string& lastError() const {
+        return m_error;
+    }
+
+private:
+    enum class State {
+        Value,          // Any value
+        ValueOrEnd,     // After '['
+        KeyOrEnd,       // After '{'
+        Key,            // After ',' in an object
+        Colon,
+        CommaOrEnd,
+        String,
+        Escape,
+        Unicode,
+        Number,
+        Literal,
+        Done
+    };
+
+    Handler& m_handler;
+    State m_state = State::Value;
+    bool m_containers[MAX_DEPTH]; // true for objects
+    size_t m_depth = 0;
+    bool m_stringIsKey = false;
+    std::string m_token;
+    uint32_t m_codeUnit = 0;
+    unsigned m_hexDigits = 0;
+    uint32_t m_highSurrogate = 0;
+    size_t m_offset = 0;
+    std::string m_error;
+
+    bool fail(const std::string& message) {
+        if (m_error.empty()) {
+            m_error = message + " at offset " + std::to_string(m_offset);
+        }
+        return false;
+    }
+
+    static bool isSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    bool append(char c) {
+        if (m_token.size() >= MemoryProfile::MAX_TOKEN_SIZE) {
+            return fail("JSON token too long");
+        }
+        m_token += c;
+        return true;
+    }
+
+    bool appendCodePoint(uint32_t cp) {
+        if (cp < 0x80) {
+            return append(static_cast<char>(cp));
+        }
+        if (cp < 0x800) {
+            return append(static_cast<char>(0xC0 | (cp >> 6))) && append(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
+        if (cp < 0x10000) {
+            return append(static_cast<char>(0xE0 | (cp >> 12))) && append(static_cast<char>(0x80 | ((cp >> 6) & 0x3F))) &&
+                   append(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
+        return append(static_cast<char>(0xF0 | (cp >> 18))) && append(static_cast<char>(0x80 | ((cp >> 12) & 0x3F))) &&
+               append(static_cast<char>(0x80 | ((cp >> 6) & 0x3F))) && append(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+
+    /**
+     * @brief Replaces a high surrogate that was not followed by a low one
+     */
+    bool flushSurrogate() {
+        if (m_highSurrogate == 0) {
+            return true;
+        }
+        m_highSurrogate = 0;
+        return appendCodePoint(0xFFFD);
+    }
+
+    /**
+     * @brief Moves on after a complete value
+     */
+    bool valueDone() {
+        m_state = m_depth == 0 ? State::Done : State::CommaOrEnd;
+        return true;
+    }
+
+    bool completeScalar() {
+        ValueType type = ValueType::Number;
+        if (m_state == State::Literal) {
+            if (m_token == "true") {
+                type = ValueType::True;
+            } else if (m_token == "false") {
+                type = ValueType::False;
+            } else if (m_token == "null") {
+                type = ValueType::Null;
+            } else {
+                return fail("Invalid literal");
+            }
+        }
+        if (!m_handler.value(type, m_token)) {
+            return false;
+        }
+        m_token.clear();
+        return valueDone();
+    }
+
+    bool open(bool object) {
+        if (m_depth >= MAX_DEPTH) {
+            return fail("JSON nested too deeply");
+        }
+        m_containers[m_depth++] = object;
+        m_state = object ? State::KeyOrEnd : State::ValueOrEnd;
+        return object ? m_handler.startObject() : m_handler.startArray();
+    }
+
+    bool close(bool object) {
+        if (m_depth == 0 || m_containers[m_depth - 1] != object) {
+            return fail("Mismatched bracket");
+        }
+        --m_depth;
+        if (!(object ? m_handler.endObject() : m_handler.endArray())) {
+            return false;
+        }
+        return valueDone();
+    }
+
+    bool startValue(char c) {
+        switch (c) {
+            case '{': return open(true);
+            case '[': return open(false);
+            case '"':
+                m_stringIsKey = false;
+                m_state = State::String;
+                return true;
+            default:
+                break;
+        }
+        if (c == '-' || (c >= '0' && c <= '9')) {
+            m_state = State::Number;
+            return append(c);
+        }
+        if (c >= 'a' && c <= 'z') {
+            m_state = State::Literal;
+            return append(c);
+        }
+        return fail("Unexpected character");
+    }
+
+    bool startKey(char c) {
+        if (c != '"') {
+            return fail("Expected object key");
+        }
+        m_stringIsKey = true;
+        m_state = State::String;
+        return true;
+    }
+
+    bool step(char c) {
+        ++m_offset;
+        switch (m_state) {
+            case State::Value:
+                return isSpace(c) || startValue(c);
+            case State::ValueOrEnd:
+                if (isSpace(c)) return true;
+                return c == ']' ? close(false) : startValue(c);
+            case State::KeyOrEnd:
+                if (isSpace(c)) return true;
+                return c == '}' ? close(true) : startKey(c);
+            case State::Key:
+                return isSpace(c) || startKey(c);
+            case State::Colon:
+                if (isSpace(c)) return true;
+                if (c != ':') return fail("Expected ':'");
+                m_state = State::Value;
+                return true;
+            case State::CommaOrEnd:
+                if (isSpace(c)) return true;
+                if (c == ',') {
+                    m_state = m_containers[m_depth - 1] ? State::Key : State::Value;
+                    return true;
+                }
+                if (c == '}' || c == ']') return close(c == '}');
+                return fail("Expected ',' or closing bracket");
+            case State::String:
+                if (c == '"') {
+                    if (!flushSurrogate()) return false;
+                    const bool ok = m_stringIsKey ? m_handler.key(m_token) : m_handler.value(ValueType::String, m_token);
+                    m_token.clear();
+                    if (!ok) return false;
+                    if (m_stringIsKey) {
+                        m_state = State::Colon;
+                        return true;
+                    }
+                    return valueDone();
+                }
+                if (c == '\\') {
+                    m_state = State::Escape;
+                    return true;
+                }
+                if (static_cast<unsigned char>(c) < 0x20) return fail("Control character in string");
+                return flushSurrogate() && append(c);
+            case State::Escape:
+                m_state = State::String;
+                if (c != 'u' && !flushSurrogate()) return false;
+                switch (c) {
+                    case '"': return append('"');
+                    case '\\': return append('\\');
+                    case '/': return append('/');
+                    case 'b': return append('\b');
+                    case 'f': return append('\f');
+                    case 'n': return append('\n');
+                    case 'r': return append('\r');
+                    case 't': return append('\t');
+                    case 'u':
+                        m_state = State::Unicode;
+                        m_codeUnit = 0;
+                        m_hexDigits = 0;
+                        return true;
+                    default: return fail("Invalid escape");
+                }
+            case State::Unicode: {
+                uint32_t digit;
+                if (c >= '0' && c <= '9') digit = static_cast<uint32_t>(c - '0');
+                else if (c >= 'a' && c <= 'f') digit = static_cast<uint32_t>(c - 'a' + 10);
+                else if (c >= 'A' && c <= 'F') digit = static_cast<uint32_t>(c - 'A' + 10);
+                else return fail("Invalid \\u escape");
+                m_codeUnit = (m_codeUnit << 4) | digit;
+                if (++m_hexDigits < 4) return true;
+                m_state = State::String;
+                if (m_codeUnit >= 0xD800 && m_codeUnit <= 0xDBFF) {
+                    if (!flushSurrogate()) return false;
+                    m_highSurrogate = m_codeUnit;
+                    return true;
+                }
+                if (m_codeUnit >= 0xDC00 && m_codeUnit <= 0xDFFF) {
+                    const uint32_t high = m_highSurrogate;
+                    m_highSurrogate = 0;
+                    return appendCodePoint(high != 0 ? 0x10000 + ((high - 0xD800) << 10) + (m_codeUnit - 0xDC00) : 0xFFFD);
+                }
+                return flushSurrogate() && appendCodePoint(m_codeUnit);
+            }
+            case State::Number:
+                if ((c >= '0' && c <= '9') || c == '.' || c == 'e' || c == 'E' || c == '+' || c == '-') {
+                    return append(c);
+                }
+                --m_offset;
+                return completeScalar() && step(c);
+            case State::Literal:
+                if (c >= 'a' && c <= 'z') {
+                    return append(c);
+                }
+                --m_offset;
+                return completeScalar() && step(c);
+            case State::Done:
+                return isSpace(c) || fail("Trailing data after JSON");
+        }
+        return fail("Invalid parser state");
+    }
+};
+
+} // namespace AutoUpdaterLib
+
+#endif // AUTO_UPDATER_JSON_STREAM_H
@@ -0,0 +1,206 @@
+/**
+ * @file Maintenance.h
+ * @brief Cron-style maintenance windows for downloading and restarting
+ *
+ * @author myexistences
+ * @copyright Copyright (c) 2025 myexistences. All rights reserved.
+ * @license MIT License
+ *
+ * @description
+ * A TimeWindow is the set of minutes matched by a five-field cron
+ * expression, evaluated in local time:
+ *
+ * ```
+ * minute hour day-of-month month day-of-week
+ * "* 1-5 * * *"            01:00 to 05:59 every day
+ * "* 0-6,22-23 * * 1-5"    nights on weekdays
+ * "0-29 3 * * 0"           03:00 to 03:29 on Sundays
+ * ```
+ *
+ * Fields accept `*`, numbers, ranges `a-b`, lists `a,b` and steps `*\/n` or
+ * `a-b/n`. Day-of-week runs from 0 (Sunday) to 6, and 7 also means Sunday.
+ * As in cron, when both day fields are restricted, a day matching either
+ * one is in the window.
+ *
+ * WindowPolicy combines three windows: when downloads may start, when they
+ * may use the full bandwidth rather than a throttled rate, and when the
+ * application may restart into a new version. Default windows are always
+ * open.
+ */
+
+#ifndef AUTO_UPDATER_MAINTENANCE_H
+#define AUTO_UPDATER_MAINTENANCE_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <string>
+
+namespace AutoUpdaterLib {
+
+/**
+ * @class TimeWindow
+ * @brief Minutes of the week and year matched by a cron expression
+ */
+class TimeWindow {
+public:
+    /**
+     * @brief Creates a window that is always open ("* * * * *")
+     */
+    TimeWindow() = default;
+
+    /**
+     * @brief Parses a five-field cron expression
+     * @param expression Fields separated by spaces or tabs
+     * @param window Receives the window
+     * @param error Receives a description when parsing fails
+     * @return true if the expression is well-formed
+     */
+    static bool parse(const std::string& expression, TimeWindow& window, std::string& error) {
+        static const struct {
+            const char* name;
+            unsigned low;
+            unsigned high;
+        } FIELDS[] = {{"minute", 0, 59}, {"hour", 0, 23}, {"day-of-month", 1, 31}, {"month", 1, 12}, {"day-of-week", 0, 7}};
+
+        TimeWindow result;
+        uint64_t* masks[] = {&result.m_minutes, &result.m_hours, &result.m_days, &result.m_months, &result.m_weekdays};
+        bool restricted[5] = {false, false, false, false, false};
+        size_t position = 0;
+        for (size_t field = 0; field < 5; ++field) {
+            position = expression.find_first_not_of(" \t", position);
+            if (position == std::string::npos) {
+                error = "Cron expression needs five fields: " + expression;
+                return false;
+            }
+            size_t end = expression.find_first_of(" \t", position);
+            if (end == std::string::npos) {
+                end = expression.size();
+            }
+            const std::string text = expression.substr(position, end - position);
+            if (!parseField(text, FIELDS[field].low, FIELDS[field].high, *masks[field], restricted[field])) {
+                error = "Invalid " + std::string(FIELDS[field].name) + " field '" + text + "' in: " + expression;
+                return false;
+            }
+            position = end;
+        }
+        if (expression.find_first_not_of(" \t", position) != std::string::npos) {
+            error = "Cron expression has more than five fields: " + expression;
+            return false;
+        }
+
+        if (result.m_weekdays & (1u << 7)) {
+            result.m_weekdays |= 1u; // 7 is another name for Sunday
+        }
+        result.m_daysRestricted = restricted[2];
+        result.m_weekdaysRestricted = restricted[4];
+        result.m_expression = expression;
+        window = result;
+        return true;
+    }
+
+    /**
+     * @brief Tests whether a local time falls in the window
+     * @param local Broken-down local time; tm_min, tm_hour, tm_mday, tm_mon and tm_wday are used
+     */
+    bool contains(const std::tm& local) const {
+        if (!bit(m_minutes, local.tm_min) || !bit(m_hours, local.tm_hour) || !bit(m_months, local.tm_mon + 1)) {
+            return false;
+        }
+        const bool day = bit(m_days, local.tm_mday);
+        const bool weekday = bit(m_weekdays, local.tm_wday);
+        if (m_daysRestricted && m_weekdaysRestricted) {
+            return day || weekday;
+        }
+        return day && weekday;
+    }
+
+    bool alwaysOpen() const { return m_expression.empty(); }
+    const std::string& expression() const { return m_expression; } ///< Empty for the default window
+
+private:
+    uint64_t m_minutes = (1ULL << 60) - 1;
+    uint64_t m_hours = (1ULL << 24) - 1;
+    uint64_t m_days = ((1ULL << 31) - 1) << 1;
+    uint64_t m_months = ((1ULL << 12) - 1) << 1;
+    uint64_t m_weekdays = (1ULL << 8) - 1;
+    bool m_daysRestricted = false;
+    bool m_weekdaysRestricted = false;
+    std::string m_expression;
+
+    static bool bit(uint64_t mask, int value) {
+        return value >= 0 && value < 64 && (mask >> value) & 1;
+    }
+
+    static bool parseNumber(const std::string& text, unsigned& value) {
+        if (text.empty() || text.size() > 4 || text.find_first_not_of("0123456789") != std::string::npos) {
+            return false;
+        }
+        value = static_cast<unsigned>(std::strtoul(text.c_str(), nullptr, 10));
+        return true;
+    }
+
+    /**
+     * @brief Parses one comma-separated field into a bit mask
+     * @param restricted Set unless the field is a bare "*"
+     */
+    static bool parseField(const std::string& text, unsigned low, unsigned high, uint64_t& mask, bool& restricted) {
+        mask = 0;
+        restricted = text != "*";
+        size_t start = 0;
+        while (start <= text.size()) {
+            size_t end = text.find(',', start);
+            if (end == std::string::npos) {
+                end = text.size();
+            }
+            std::string item = text.substr(start, end - start);
+
+            unsigned step = 1;
+            const size_t slash = item.find('/');
+            if (slash != std::string::npos) {
+                if (!parseNumber(item.substr(slash + 1), step) || step == 0) {
+                    return false;
+                }
+                item.resize(slash);
+            }
+
+            unsigned first = low;
+            unsigned last = high;
+            if (item != "*") {
+                const size_t dash = item.find('-');
+                if (dash == std::string::npos) {
+                    if (!parseNumber(item, first)) {
+                        return false;
+                    }
+                    // "a/n" runs from a to the end of the range, as in cron
+                    last = slash != std::string::npos ? high : first;
+                } else if (!parseNumber(item.substr(0, dash), first) || !parseNumber(item.substr(dash + 1), last)) {
+                    return false;
+                }
+            }
+            if (first < low || last > high || first > last) {
+                return false;
+            }
+            for (unsigned value = first; value <= last; value += step) {
+                mask |= 1ULL << value;
+            }
+            start = end + 1;
+        }
+        return mask != 0;
+    }
+};
+
+/**
+ * @struct WindowPolicy
+ * @brief Maintenance windows for the stages of an update
+ */
+struct WindowPolicy {
+    TimeWindow download;        ///< Checks may download an update; outside it they only record it as pending
+    TimeWindow fullBandwidth;   ///< Downloads may run at full speed; outside it they are throttled
+    TimeWindow restart;         ///< The application may restart into a staged update
+    uint64_t throttledBytesPerSecond = 256 * 1024; ///< Download rate outside fullBandwidth
+};
+
+} // namespace AutoUpdaterLib
+
+#endif // AUTO_UPDATER_MAINTENANCE_H
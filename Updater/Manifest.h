@@ -0,0 +1,1190 @@
+/**
+ * @file Manifest.h
+ * @brief Update manifest model and update route planning
+ *
+ * @author myexistences
+ * @copyright Copyright (c) 2025 myexistences. All rights reserved.
+ * @license MIT License
+ *
+ * @description
+ * Parses the version JSON served by the update host into a manifest and
+ * plans the cheapest way from the installed version to the advertised one.
+ * Every full image and patch is an edge in a version graph weighted by its
+ * download size, and the route is found with Dijkstra's algorithm, so a
+ * host several versions behind downloads the fewest bytes possible.
+ *
+ * @json_format
+ * ```json
+ * {
+ *     "AppVersion": "1.2",
+ *     "UpdateLink": "https://example.com/app_v1.2.exe",
+ *     "Size": 48234496,
+ *     "Digest": "blake3:...",
+ *     "Images": [
+ *         { "Version": "1.1", "UpdateLink": "https://...", "Size": 48100000, "Digest": "blake3:..." }
+ *     ],
+ *     "Patches": [
+ *         { "From": "1.0", "To": "1.1", "Link": "https://...", "Size": 812345, "Digest": "blake3:..." },
+ *         { "From": "1.1", "To": "1.2", "Link": "https://...", "Size": 402112, "Digest": "blake3:..." }
+ *     ]
+ * }
+ * ```
+ * A `Digest` always covers the bytes that are downloaded. `Images` lists
+ * full images of intermediate versions that patches can start from. The
+ * latest image and entries of `Images` may set `"Package": "zip"` when the
+ * link is a zip of the whole application directory rather than a bare
+ * executable; patches then apply to the executable inside the package.
+ *
+ * Multi-file releases add a `Files` array (produced by Tools/Publisher.cpp):
+ * ```json
+ * "Files": [
+ *     { "Path": "bin/app.exe", "Link": "https://...", "Size": 48234496, "Digest": "blake3:...",
+ *       "Chunks": [ { "Size": 1048576, "Digest": "blake3:..." } ] }
+ * ]
+ * ```
+ * Chunks are content-defined (see Chunker.h) and listed in file order.
+ * Files are needed to launch the new version unless they set
+ * `"Priority": "deferred"`; deferred files, typically bulk assets, are
+ * fetched after the application has restarted into the new version.
+ * `"Priority": "lazy"` files are only fetched when the application asks
+ * for them (AutoUpdater::ensureAsset), and afterwards kept up to date.
+ *
+ * Builds of the latest version for newer CPUs are listed as `Variants`:
+ * ```json
+ * "Variants": [
+ *     { "Requires": "x86-64-v3", "UpdateLink": "https://...", "Size": 48110000, "Digest": "blake3:..." },
+ *     { "Requires": "x86-64-v4", "UpdateLink": "https://...", "Size": 48370000, "Digest": "blake3:..." }
+ * ]
+ * ```
+ * `Requires` names CPU features or micro-architecture levels (see
+ * CpuFeatures.h). The top-level `UpdateLink` is the baseline build that
+ * every host can run; selectVariant() swaps in the variant with the most
+ * features the host supports.
+ *
+ * @binary_format
+ * The same manifest can be served in a compact binary form, recognised by
+ * its "AUMANIF1" magic. Strings are varint-length-prefixed, sizes are
+ * varint(size + 1) with 0 meaning unknown, and digests are a tag byte
+ * (0 none, 1 raw 32-byte BLAKE3, 2 string) followed by the value.
+ * ```
+ * "AUMANIF1" string version
+ * varint artifactCount { u8 kind, string from, string to, string link, string package,
+ *                        size, digest }
+ * varint fileCount { string path, string link, varint flags, size, digest,
+ *                    varint chunkCount { varint size, digest } }
+ * [varint variantCount { string requires, string link, string package, size, digest }]
+ * ```
+ * The variant section is optional, so manifests without variants are
+ * unchanged and older readers ignore it.
+ *
+ * @memory_budget
+ * fromJsonStream() and fromBinary() accept a budget for the parsed model.
+ * Strings and entries are charged against it as they are read, and a
+ * manifest that does not fit is rejected instead of exhausting memory.
+ * With a finite budget, chunk lists are skipped: they only serve the
+ * chunk-level delta download, which the bounded-memory build does not use.
+ *
+ * The file list is the part that grows with the release. Given a spool
+ * path, both parsers write each Files entry to that file as soon as it is
+ * complete, in the binary form's file-entry layout, and charge the budget
+ * for one entry at a time. Consumers visit the files with forEachFile(),
+ * which reads the spool back entry by entry, so a release of any size
+ * fits in a fixed budget. Every loader keeps the list sorted by path and
+ * rejects a path listed twice; a list that is spooled cannot be sorted
+ * afterwards, so it must arrive sorted, as Publisher writes it.
+ */
+
+#ifndef AUTO_UPDATER_MANIFEST_H
+#define AUTO_UPDATER_MANIFEST_H
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <istream>
+#include <map>
+#include <ostream>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include "json.hpp" // nlohmann::json library
+#include "CpuFeatures.h"
+#include "JsonStream.h"
+#include "MemoryProfile.h"
+#include "Varint.h"
+
+namespace AutoUpdaterLib {
+
+/**
+ * @struct UpdateArtifact
+ * @brief A downloadable full image or patch
+ */
+struct UpdateArtifact {
+    enum class Kind { FullImage, Patch };
+
+    static constexpr uint64_t UNKNOWN_SIZE = UINT64_MAX;
+
+    Kind kind = Kind::FullImage;
+    std::string fromVersion;   ///< Base version for patches; empty for full images
+    std::string toVersion;     ///< Version produced by this artifact
+    std::string link;          ///< Download URL
+    std::string package;       ///< "zip" for a packaged application directory; empty for a bare executable
+    uint64_t size = UNKNOWN_SIZE;
+    std::string digest;        ///< "algorithm:hex" digest of the downloaded bytes, if published
+    std::string cpuRequirements; ///< Variants only: CPU features the build needs (see CpuFeatures.h)
+};
+
+/**
+ * @struct ChunkEntry
+ * @brief One content-defined chunk of a file; offsets follow from list order
+ */
+struct ChunkEntry {
+    uint64_t size = 0;
+    std::string digest;
+};
+
+/**
+ * @struct FileEntry
+ * @brief One file of a multi-file release
+ */
+struct FileEntry {
+    std::string path;   ///< Path relative to the install directory, '/'-separated
+    std::string link;   ///< Download URL
+    static constexpr uint64_t FLAG_DEFERRED = 1; ///< Fetched after the restart into the new version
+    static constexpr uint64_t FLAG_LAZY = 2;     ///< Fetched only when the application asks for it
+
+    uint64_t flags = 0; ///< FLAG_* bits; other bits are reserved
+    uint64_t size = UpdateArtifact::UNKNOWN_SIZE;
+    std::string digest;
+    std::vector<ChunkEntry> chunks;
+};
+
+/**
+ * @struct UpdateManifest
+ * @brief Parsed contents of the version JSON
+ */
+struct UpdateManifest {
+    static constexpr const char* BINARY_MAGIC = "AUMANIF1";
+    static constexpr size_t BINARY_MAGIC_SIZE = 8;
+
+    std::string version;                  ///< Latest available version ("AppVersion")
+    std::string digest;                   ///< Digest of the latest full image, if published
+    std::vector<UpdateArtifact> artifacts; ///< Latest image first, then other images and patches
+    std::vector<FileEntry> files;         ///< Files of a multi-file release, sorted by path
+    std::vector<UpdateArtifact> variants; ///< Builds of the latest version for newer CPUs
+    std::string fileSpool;                ///< File holding the spooled files; see @memory_budget
+    uint64_t spooledFiles = 0;            ///< Files in fileSpool, listed after `files`
+
+    /**
+     * @brief Checks whether the manifest lists any file, in memory or spooled
+     */
+    bool hasFiles() const {
+        return !files.empty() || spooledFiles > 0;
+    }
+
+    /**
+     * @brief Visits every file, whether held in `files` or spooled to disk
+     * @param visit Called once per file in list order; returning false stops early
+     * @return false if the spooled files could not be read back completely
+     */
+    bool forEachFile(const std::function<bool(const FileEntry&)>& visit) const {
+        for (const auto& file : files) {
+            if (!visit(file)) {
+                return true;
+            }
+        }
+        if (spooledFiles == 0) {
+            return true;
+        }
+        std::ifstream in(fileSpool, std::ios::binary);
+        for (uint64_t i = 0; i < spooledFiles; ++i) {
+            FileEntry file;
+            size_t unlimited = SIZE_MAX;
+            if (!readBinaryFile(in, file, unlimited, false)) {
+                return false;
+            }
+            if (!visit(file)) {
+                return true;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Builds a manifest from the server's JSON document
+     * @param json Parsed version JSON
+     * @param manifest Receives the manifest
+     * @param error Receives a description when parsing fails
+     * @return true if the required fields are present and well-typed and
+     *         no file path is listed twice
+     *
+     * Files are sorted by path, as the other loaders keep them.
+     */
+    static bool fromJson(const nlohmann::json& json, UpdateManifest& manifest, std::string& error) {
+        if (!json.is_object() || !json.contains("AppVersion") || !json.contains("UpdateLink")) {
+            error = "Invalid or missing version information from server";
+            return false;
+        }
+
+        try {
+            manifest = UpdateManifest();
+            manifest.version = json["AppVersion"].get<std::string>();
+
+            UpdateArtifact latest;
+            latest.toVersion = manifest.version;
+            latest.link = json["UpdateLink"].get<std::string>();
+            readOptional(json, latest);
+            manifest.digest = latest.digest;
+            manifest.artifacts.push_back(latest);
+
+            if (json.contains("Images")) {
+                for (const auto& entry : json["Images"]) {
+                    UpdateArtifact image;
+                    image.toVersion = entry.at("Version").get<std::string>();
+                    image.link = entry.at("UpdateLink").get<std::string>();
+                    readOptional(entry, image);
+                    manifest.artifacts.push_back(image);
+                }
+            }
+
+            if (json.contains("Patches")) {
+                for (const auto& entry : json["Patches"]) {
+                    UpdateArtifact patch;
+                    patch.kind = UpdateArtifact::Kind::Patch;
+                    patch.fromVersion = entry.at("From").get<std::string>();
+                    patch.toVersion = entry.at("To").get<std::string>();
+                    patch.link = entry.at("Link").get<std::string>();
+                    readOptional(entry, patch);
+                    manifest.artifacts.push_back(patch);
+                }
+            }
+
+            if (json.contains("Variants")) {
+                for (const auto& entry : json["Variants"]) {
+                    UpdateArtifact variant;
+                    variant.toVersion = manifest.version;
+                    variant.cpuRequirements = entry.at("Requires").get<std::string>();
+                    variant.link = entry.at("UpdateLink").get<std::string>();
+                    readOptional(entry, variant);
+                    manifest.variants.push_back(variant);
+                }
+            }
+
+            if (json.contains("Files")) {
+                for (const auto& entry : json["Files"]) {
+                    FileEntry file;
+                    file.path = entry.at("Path").get<std::string>();
+                    file.link = entry.at("Link").get<std::string>();
+                    if (entry.contains("Size")) file.size = readSize(entry["Size"]);
+                    if (entry.contains("Digest")) file.digest = entry["Digest"].get<std::string>();
+                    if (entry.contains("Priority")) {
+                        const std::string priority = entry["Priority"].get<std::string>();
+                        if (priority == "deferred") file.flags |= FileEntry::FLAG_DEFERRED;
+                        if (priority == "lazy") file.flags |= FileEntry::FLAG_LAZY;
+                    }
+                    if (entry.contains("Chunks")) {
+                        for (const auto& chunkJson : entry["Chunks"]) {
+                            ChunkEntry chunk;
+                            chunk.size = readSize(chunkJson.at("Size"));
+                            chunk.digest = chunkJson.at("Digest").get<std::string>();
+                            file.chunks.push_back(chunk);
+                        }
+                    }
+                    manifest.files.push_back(file);
+                }
+            }
+        } catch (const std::exception& e) {
+            error = "Failed to parse version information: " + std::string(e.what());
+            return false;
+        }
+
+        if (!sortFiles(manifest.files, error)) {
+            manifest = UpdateManifest();
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Builds a manifest by parsing the version JSON as a stream
+     * @param in Stream positioned at the JSON document
+     * @param manifest Receives the manifest
+     * @param error Receives a description when parsing fails
+     * @param budget Bytes the parsed manifest may occupy; see @memory_budget
+     * @param spoolPath File to spool the file list to instead of `files`; empty to keep it in memory
+     * @return true if the required fields are present, well-typed and within budget
+     *
+     * Produces the same manifest as fromJson() without building a DOM; memory
+     * is one read buffer, one token and the manifest itself.
+     */
+    static bool fromJsonStream(std::istream& in, UpdateManifest& manifest, std::string& error,
+                               size_t budget = SIZE_MAX, const std::string& spoolPath = std::string()) {
+        manifest = UpdateManifest();
+        std::ofstream spool;
+        if (!spoolPath.empty()) {
+            spool.open(spoolPath, std::ios::binary | std::ios::trunc);
+            if (!spool.is_open()) {
+                error = "Failed to create file: " + spoolPath;
+                return false;
+            }
+        }
+        StreamBuilder builder(manifest, budget, spool.is_open() ? &spool : nullptr);
+        JsonStreamParser parser(builder);
+        std::vector<char> buffer(MemoryProfile::IO_BUFFER_SIZE);
+        bool ok = true;
+        while (ok && in) {
+            in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            ok = parser.feed(buffer.data(), static_cast<size_t>(in.gcount()));
+        }
+        ok = ok && parser.finish() && builder.finish();
+        bool spoolFailed = false;
+        if (spool.is_open()) {
+            spool.close();
+            spoolFailed = ok && spool.fail();
+            ok = ok && !spoolFailed;
+            manifest.fileSpool = spoolPath;
+        }
+        if (!ok) {
+            error = spoolFailed ? "Failed to write file: " + spoolPath
+                  : !builder.error().empty() ? builder.error()
+                                             : "Failed to parse version information: " + parser.lastError();
+            manifest = UpdateManifest();
+        }
+        return ok;
+    }
+
+    /**
+     * @brief Serialises the manifest to JSON with a fixed key order
+     * @return JSON document; identical manifests always produce identical text
+     */
+    nlohmann::ordered_json toJson() const {
+        nlohmann::ordered_json json;
+        json["AppVersion"] = version;
+        if (!artifacts.empty()) {
+            json["UpdateLink"] = artifacts.front().link;
+            if (!artifacts.front().package.empty()) json["Package"] = artifacts.front().package;
+            writeOptional(json, artifacts.front().size, artifacts.front().digest);
+        }
+
+        nlohmann::ordered_json images = nlohmann::ordered_json::array();
+        nlohmann::ordered_json patches = nlohmann::ordered_json::array();
+        for (size_t i = 1; i < artifacts.size(); ++i) {
+            const UpdateArtifact& artifact = artifacts[i];
+            nlohmann::ordered_json entry;
+            if (artifact.kind == UpdateArtifact::Kind::Patch) {
+                entry["From"] = artifact.fromVersion;
+                entry["To"] = artifact.toVersion;
+                entry["Link"] = artifact.link;
+                writeOptional(entry, artifact.size, artifact.digest);
+                patches.push_back(entry);
+            } else {
+                entry["Version"] = artifact.toVersion;
+                entry["UpdateLink"] = artifact.link;
+                if (!artifact.package.empty()) entry["Package"] = artifact.package;
+                writeOptional(entry, artifact.size, artifact.digest);
+                images.push_back(entry);
+            }
+        }
+        if (!images.empty()) json["Images"] = images;
+        if (!patches.empty()) json["Patches"] = patches;
+
+        if (!variants.empty()) {
+            nlohmann::ordered_json variantList = nlohmann::ordered_json::array();
+            for (const auto& variant : variants) {
+                nlohmann::ordered_json entry;
+                entry["Requires"] = variant.cpuRequirements;
+                entry["UpdateLink"] = variant.link;
+                if (!variant.package.empty()) entry["Package"] = variant.package;
+                writeOptional(entry, variant.size, variant.digest);
+                variantList.push_back(entry);
+            }
+            json["Variants"] = variantList;
+        }
+
+        if (hasFiles()) {
+            nlohmann::ordered_json fileList = nlohmann::ordered_json::array();
+            forEachFile([&fileList](const FileEntry& file) {
+                nlohmann::ordered_json entry;
+                entry["Path"] = file.path;
+                entry["Link"] = file.link;
+                if (file.flags & FileEntry::FLAG_DEFERRED) entry["Priority"] = "deferred";
+                if (file.flags & FileEntry::FLAG_LAZY) entry["Priority"] = "lazy";
+                writeOptional(entry, file.size, file.digest);
+                if (!file.chunks.empty()) {
+                    nlohmann::ordered_json chunks = nlohmann::ordered_json::array();
+                    for (const auto& chunk : file.chunks) {
+                        nlohmann::ordered_json chunkJson;
+                        chunkJson["Size"] = chunk.size;
+                        chunkJson["Digest"] = chunk.digest;
+                        chunks.push_back(chunkJson);
+                    }
+                    entry["Chunks"] = chunks;
+                }
+                fileList.push_back(entry);
+                return true;
+            });
+            json["Files"] = fileList;
+        }
+        return json;
+    }
+
+    /**
+     * @brief Serialises the manifest in the compact binary form
+     * @param out Destination stream
+     */
+    void toBinary(std::ostream& out) const {
+        out.write(BINARY_MAGIC, BINARY_MAGIC_SIZE);
+        Varint::writeString(out, version);
+
+        Varint::write(out, artifacts.size());
+        for (const auto& artifact : artifacts) {
+            out.put(artifact.kind == UpdateArtifact::Kind::Patch ? 1 : 0);
+            Varint::writeString(out, artifact.fromVersion);
+            Varint::writeString(out, artifact.toVersion);
+            Varint::writeString(out, artifact.link);
+            Varint::writeString(out, artifact.package);
+            writeBinarySize(out, artifact.size);
+            writeBinaryDigest(out, artifact.digest);
+        }
+
+        Varint::write(out, files.size() + spooledFiles);
+        forEachFile([&out](const FileEntry& file) {
+            writeBinaryFile(out, file);
+            return true;
+        });
+
+        if (!variants.empty()) {
+            Varint::write(out, variants.size());
+            for (const auto& variant : variants) {
+                Varint::writeString(out, variant.cpuRequirements);
+                Varint::writeString(out, variant.link);
+                Varint::writeString(out, variant.package);
+                writeBinarySize(out, variant.size);
+                writeBinaryDigest(out, variant.digest);
+            }
+        }
+    }
+
+    /**
+     * @brief Parses the compact binary form
+     * @param in Stream positioned at the magic
+     * @param manifest Receives the manifest
+     * @param error Receives a description when parsing fails
+     * @param budget Bytes the parsed manifest may occupy; see @memory_budget
+     * @param spoolPath File to spool the file list to instead of `files`; empty to keep it in memory
+     * @return true if the whole manifest was read
+     */
+    static bool fromBinary(std::istream& in, UpdateManifest& manifest, std::string& error,
+                           size_t budget = SIZE_MAX, const std::string& spoolPath = std::string()) {
+        char magic[BINARY_MAGIC_SIZE];
+        in.read(magic, sizeof(magic));
+        if (in.gcount() != static_cast<std::streamsize>(sizeof(magic)) ||
+            std::memcmp(magic, BINARY_MAGIC, sizeof(magic)) != 0) {
+            error = "Not a binary manifest";
+            return false;
+        }
+
+        manifest = UpdateManifest();
+        const bool keepChunks = budget == SIZE_MAX;
+        size_t remaining = budget;
+        uint64_t count = 0;
+        bool ok = readString(in, manifest.version, remaining) && Varint::read(in, count);
+        for (uint64_t i = 0; ok && i < count; ++i) {
+            UpdateArtifact artifact;
+            const int kind = in.get();
+            artifact.kind = kind == 1 ? UpdateArtifact::Kind::Patch : UpdateArtifact::Kind::FullImage;
+            ok = (kind == 0 || kind == 1) &&
+                 charge(remaining, sizeof(UpdateArtifact)) &&
+                 readString(in, artifact.fromVersion, remaining) &&
+                 readString(in, artifact.toVersion, remaining) &&
+                 readString(in, artifact.link, remaining) &&
+                 readString(in, artifact.package, remaining) &&
+                 readBinarySize(in, artifact.size) &&
+                 readBinaryDigest(in, artifact.digest, remaining);
+            manifest.artifacts.push_back(artifact);
+        }
+
+        std::ofstream spool;
+        bool spoolFailed = false;
+        if (ok && !spoolPath.empty()) {
+            spool.open(spoolPath, std::ios::binary | std::ios::trunc);
+            spoolFailed = !spool.is_open();
+            ok = !spoolFailed;
+        }
+        ok = ok && !manifest.artifacts.empty() && Varint::read(in, count);
+        std::string fileError;
+        std::string previousPath;
+        for (uint64_t i = 0; ok && i < count; ++i) {
+            FileEntry file;
+            const size_t entryStart = remaining;
+            ok = readBinaryFile(in, file, remaining, keepChunks);
+            if (spool.is_open()) {
+                // A spooled entry only occupies the budget while it is read
+                ok = ok && followsInOrder(previousPath, manifest.spooledFiles, file.path, fileError);
+                writeBinaryFile(spool, file);
+                remaining = entryStart;
+                ++manifest.spooledFiles;
+                previousPath = file.path;
+            } else {
+                manifest.files.push_back(file);
+            }
+        }
+        if (ok && !spool.is_open()) {
+            ok = sortFiles(manifest.files, fileError);
+        }
+        if (spool.is_open()) {
+            spool.close();
+            spoolFailed = ok && spool.fail();
+            ok = ok && !spoolFailed;
+            manifest.fileSpool = spoolPath;
+        }
+
+        count = 0;
+        if (ok && in.peek() != std::char_traits<char>::eof()) {
+            ok = Varint::read(in, count);
+        }
+        for (uint64_t i = 0; ok && i < count; ++i) {
+            UpdateArtifact variant;
+            variant.toVersion = manifest.version;
+            ok = charge(remaining, sizeof(UpdateArtifact)) &&
+                 readString(in, variant.cpuRequirements, remaining) &&
+                 readString(in, variant.link, remaining) &&
+                 readString(in, variant.package, remaining) &&
+                 readBinarySize(in, variant.size) &&
+                 readBinaryDigest(in, variant.digest, remaining);
+            manifest.variants.push_back(variant);
+        }
+
+        if (!ok) {
+            error = spoolFailed         ? "Failed to write file: " + spoolPath
+                  : !fileError.empty()  ? fileError
+                  : keepChunks          ? "Truncated or corrupt binary manifest"
+                                        : "Truncated, corrupt or over-budget binary manifest";
+            manifest = UpdateManifest();
+            return false;
+        }
+        manifest.digest = manifest.artifacts.front().digest;
+        return true;
+    }
+
+    /**
+     * @brief Replaces the latest image with the fastest variant the host can run
+     * @param features Host features, normally CpuFeatures::host()
+     * @return Requirements of the chosen variant, or empty if the baseline build stays
+     *
+     * The variant requiring the most features wins; variants naming an
+     * unknown feature are never chosen. Patches to the latest version are
+     * built against the baseline image, so they are dropped when a variant
+     * is chosen and the route downloads the variant in full.
+     */
+    std::string selectVariant(uint64_t features) {
+        const UpdateArtifact* best = nullptr;
+        unsigned bestCount = 0;
+        for (const auto& variant : variants) {
+            uint64_t required = 0;
+            if (CpuFeatures::parse(variant.cpuRequirements, required) && (required & ~features) == 0 &&
+                CpuFeatures::count(required) > bestCount) {
+                best = &variant;
+                bestCount = CpuFeatures::count(required);
+            }
+        }
+        if (!best || artifacts.empty()) {
+            return std::string();
+        }
+
+        artifacts.front() = *best;
+        artifacts.front().toVersion = version;
+        digest = best->digest;
+        const std::string& latest = version;
+        artifacts.erase(std::remove_if(artifacts.begin() + 1, artifacts.end(),
+                                       [&latest](const UpdateArtifact& artifact) {
+                                           return artifact.kind == UpdateArtifact::Kind::Patch && artifact.toVersion == latest;
+                                       }),
+                        artifacts.end());
+        return best->cpuRequirements;
+    }
+
+private:
+    static constexpr const char* BLAKE3_PREFIX = "blake3:";
+
+    static void writeOptional(nlohmann::ordered_json& json, uint64_t size, const std::string& digest) {
+        if (size != UpdateArtifact::UNKNOWN_SIZE) json["Size"] = size;
+        if (!digest.empty()) json["Digest"] = digest;
+    }
+
+    static void writeBinarySize(std::ostream& out, uint64_t size) {
+        Varint::write(out, size == UpdateArtifact::UNKNOWN_SIZE ? 0 : size + 1);
+    }
+
+    static bool readBinarySize(std::istream& in, uint64_t& size) {
+        uint64_t raw = 0;
+        if (!Varint::read(in, raw)) {
+            return false;
+        }
+        size = raw == 0 ? UpdateArtifact::UNKNOWN_SIZE : raw - 1;
+        return true;
+    }
+
+    static void writeBinaryDigest(std::ostream& out, const std::string& digest) {
+        const size_t prefixLen = std::strlen(BLAKE3_PREFIX);
+        if (digest.empty()) {
+            out.put(0);
+        } else if (digest.size() == prefixLen + 64 && digest.compare(0, prefixLen, BLAKE3_PREFIX) == 0 &&
+                   digest.find_first_not_of("0123456789abcdef", prefixLen) == std::string::npos) {
+            out.put(1);
+            for (size_t i = prefixLen; i < digest.size(); i += 2) {
+                out.put(static_cast<char>(std::stoi(digest.substr(i, 2), nullptr, 16)));
+            }
+        } else {
+            out.put(2);
+            Varint::writeString(out, digest);
+        }
+    }
+
+    /**
+     * @brief Sorts a file list by path, the order `files` is kept in
+     * @return false, naming the path, if a path is listed twice
+     */
+    static bool sortFiles(std::vector<FileEntry>& files, std::string& error) {
+        std::stable_sort(files.begin(), files.end(),
+                         [](const FileEntry& a, const FileEntry& b) { return a.path < b.path; });
+        for (size_t i = 1; i < files.size(); ++i) {
+            if (files[i - 1].path == files[i].path) {
+                error = "File is listed twice: " + files[i].path;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Checks that a spooled file follows the one before it in path order
+     * @param previous Path of the previous spooled file
+     * @param spooled Number of files spooled so far
+     *
+     * A spooled list cannot be sorted after the fact, so it must arrive
+     * sorted, as Publisher writes it.
+     */
+    static bool followsInOrder(const std::string& previous, uint64_t spooled, const std::string& path, std::string& error) {
+        if (spooled == 0 || previous < path) {
+            return true;
+        }
+        error = previous == path ? "File is listed twice: " + path : "Files are not sorted by path at " + path;
+        return false;
+    }
+
+    static void writeBinaryFile(std::ostream& out, const FileEntry& file) {
+        Varint::writeString(out, file.path);
+        Varint::writeString(out, file.link);
+        Varint::write(out, file.flags);
+        writeBinarySize(out, file.size);
+        writeBinaryDigest(out, file.digest);
+        Varint::write(out, file.chunks.size());
+        for (const auto& chunk : file.chunks) {
+            Varint::write(out, chunk.size);
+            writeBinaryDigest(out, chunk.digest);
+        }
+    }
+
+    static bool readBinaryFile(std::istream& in, FileEntry& file, size_t& remaining, bool keepChunks) {
+        uint64_t chunkCount = 0;
+        bool ok = charge(remaining, sizeof(FileEntry)) &&
+                  readString(in, file.path, remaining) &&
+                  readString(in, file.link, remaining) &&
+                  Varint::read(in, file.flags) &&
+                  readBinarySize(in, file.size) &&
+                  readBinaryDigest(in, file.digest, remaining) &&
+                  Varint::read(in, chunkCount);
+        for (uint64_t c = 0; ok && c < chunkCount; ++c) {
+            ChunkEntry chunk;
+            size_t scratch = MemoryProfile::MAX_TOKEN_SIZE; // Skipped digests are read, then dropped
+            ok = Varint::read(in, chunk.size) &&
+                 (keepChunks ? charge(remaining, sizeof(ChunkEntry)) &&
+                                   readBinaryDigest(in, chunk.digest, remaining)
+                             : readBinaryDigest(in, chunk.digest, scratch));
+            if (keepChunks) {
+                file.chunks.push_back(chunk);
+            }
+        }
+        return ok;
+    }
+
+    /**
+     * @brief Deducts bytes from a budget
+     * @return false, leaving the budget untouched, if they do not fit
+     */
+    static bool charge(size_t& remaining, size_t bytes) {
+        if (remaining != SIZE_MAX) {
+            if (bytes > remaining) {
+                return false;
+            }
+            remaining -= bytes;
+        }
+        return true;
+    }
+
+    static bool readString(std::istream& in, std::string& value, size_t& remaining) {
+        return Varint::readString(in, value, std::min<uint64_t>(remaining, 1 << 20)) && charge(remaining, value.size());
+    }
+
+    static bool readBinaryDigest(std::istream& in, std::string& digest, size_t& remaining) {
+        static const char DIGITS[] = "0123456789abcdef";
+        const int tag = in.get();
+        if (tag == 0) {
+            digest.clear();
+            return true;
+        }
+        if (tag == 2) {
+            return readString(in, digest, remaining);
+        }
+        if (tag != 1) {
+            return false;
+        }
+        char raw[32];
+        in.read(raw, sizeof(raw));
+        if (in.gcount() != static_cast<std::streamsize>(sizeof(raw))) {
+            return false;
+        }
+        digest = BLAKE3_PREFIX;
+        for (char c : raw) {
+            digest.push_back(DIGITS[static_cast<unsigned char>(c) >> 4]);
+            digest.push_back(DIGITS[static_cast<unsigned char>(c) & 0x0F]);
+        }
+        return charge(remaining, digest.size());
+    }
+
+    /**
+     * @brief Reads a size, which must be an unsigned integer that fits in 64 bits
+     * @throws std::runtime_error otherwise; larger numbers parse as floating point
+     */
+    static uint64_t readSize(const nlohmann::json& value) {
+        if (!value.is_number_unsigned()) {
+            throw std::runtime_error("Size must be an unsigned integer of at most 64 bits");
+        }
+        return value.get<uint64_t>();
+    }
+
+    static void readOptional(const nlohmann::json& entry, UpdateArtifact& artifact) {
+        if (entry.contains("Package")) {
+            artifact.package = entry["Package"].get<std::string>();
+        }
+        if (entry.contains("Size")) {
+            artifact.size = readSize(entry["Size"]);
+        }
+        if (entry.contains("Digest")) {
+            artifact.digest = entry["Digest"].get<std::string>();
+        }
+    }
+
+    /**
+     * @class StreamBuilder
+     * @brief Fills a manifest from JsonStreamParser events
+     *
+     * Tracks the nesting level: 1 is the document, 2 an Images, Patches,
+     * Variants or Files array, 3 one of their entries, 4 a Chunks array and 5 a chunk.
+     * Containers anywhere else are skipped.
+     */
+    class StreamBuilder : public JsonStreamParser::Handler {
+    public:
+        StreamBuilder(UpdateManifest& manifest, size_t budget, std::ostream* spool)
+            : m_manifest(manifest), m_spool(spool), m_remaining(budget), m_keepChunks(budget == SIZE_MAX) {}
+
+        /**
+         * @brief Checks the top-level fields and assembles the artifact list
+         */
+        bool finish() {
+            if ((m_topSeen & (SEEN_VERSION | SEEN_LINK)) != (SEEN_VERSION | SEEN_LINK)) {
+                return fail("Invalid or missing version information from server");
+            }
+            m_latest.toVersion = m_manifest.version;
+            m_manifest.digest = m_latest.digest;
+            m_manifest.artifacts.insert(m_manifest.artifacts.begin(), m_latest);
+            m_manifest.artifacts.insert(m_manifest.artifacts.end(), m_patches.begin(), m_patches.end());
+            m_patches.clear();
+            for (auto& variant : m_manifest.variants) {
+                variant.toVersion = m_manifest.version;
+            }
+            std::string message;
+            if (!m_spool && !sortFiles(m_manifest.files, message)) {
+                return fail(message);
+            }
+            return true;
+        }
+
+        const std::string& error() const { return m_error; }
+
+        bool startObject() override {
+            if (m_skip > 0 || !(m_depth == 0 || m_depth == 2 || (m_depth == 4 && m_keepChunks))) {
+                ++m_skip;
+                return true;
+            }
+            ++m_depth;
+            if (m_depth == 5) {
+                m_fileSeen = m_seen;
+            }
+            m_seen = 0;
+            if (m_depth == 3) {
+                m_artifact = UpdateArtifact();
+                m_artifact.kind = m_section == Section::Patches ? UpdateArtifact::Kind::Patch : UpdateArtifact::Kind::FullImage;
+                m_file = FileEntry();
+                m_entryStart = m_remaining;
+            } else if (m_depth == 5) {
+                m_chunk = ChunkEntry();
+            }
+            return true;
+        }
+
+        bool startArray() override {
+            if (m_skip == 0 && m_depth == 1 &&
+                (m_key == "Images" || m_key == "Patches" || m_key == "Variants" || m_key == "Files")) {
+                m_section = m_key == "Images"     ? Section::Images
+                            : m_key == "Patches"  ? Section::Patches
+                            : m_key == "Variants" ? Section::Variants
+                                                  : Section::Files;
+                m_depth = 2;
+                return true;
+            }
+            if (m_skip == 0 && m_depth == 3 && m_section == Section::Files && m_key == "Chunks") {
+                m_depth = 4;
+                return true;
+            }
+            if (m_depth == 0) {
+                return fail("Invalid or missing version information from server");
+            }
+            ++m_skip;
+            return true;
+        }
+
+        bool endObject() override {
+            if (m_skip > 0) {
+                --m_skip;
+                return true;
+            }
+            if (m_depth == 5) {
+                if ((m_seen & (SEEN_SIZE | SEEN_DIGEST)) != (SEEN_SIZE | SEEN_DIGEST)) {
+                    return fail("Chunk entry needs Size and Digest");
+                }
+                if (!charge(sizeof(ChunkEntry))) return false;
+                m_file.chunks.push_back(m_chunk);
+                m_seen = m_fileSeen;
+            } else if (m_depth == 3 && !endEntry()) {
+                return false;
+            }
+            --m_depth;
+            return true;
+        }
+
+        bool endArray() override {
+            if (m_skip > 0) {
+                --m_skip;
+                return true;
+            }
+            if (m_depth == 4) {
+                m_depth = 3;
+            } else {
+                m_depth = 1;
+                m_section = Section::None;
+            }
+            return true;
+        }
+
+        bool key(const std::string& name) override {
+            if (m_skip == 0) {
+                m_key = name;
+            }
+            return true;
+        }
+
+        bool value(JsonStreamParser::ValueType type, const std::string& text) override {
+            if (m_skip > 0 || m_depth == 2 || m_depth == 4) {
+                return true;
+            }
+            if (m_depth == 1) {
+                if (m_key == "AppVersion") return setString(type, text, m_manifest.version, SEEN_VERSION, m_topSeen);
+                if (m_key == "UpdateLink") return setString(type, text, m_latest.link, SEEN_LINK, m_topSeen);
+                if (m_key == "Package") return setString(type, text, m_latest.package, 0, m_topSeen);
+                if (m_key == "Digest") return setString(type, text, m_latest.digest, 0, m_topSeen);
+                if (m_key == "Size") return setNumber(type, text, m_latest.size);
+                return true;
+            }
+            if (m_depth == 5) {
+                if (m_key == "Size") return setNumber(type, text, m_chunk.size) && mark(SEEN_SIZE);
+                if (m_key == "Digest") return setString(type, text, m_chunk.digest, SEEN_DIGEST, m_seen);
+                return true;
+            }
+            if (m_section == Section::Files) {
+                if (m_key == "Path") return setString(type, text, m_file.path, SEEN_VERSION, m_seen);
+                if (m_key == "Link") return setString(type, text, m_file.link, SEEN_LINK, m_seen);
+                if (m_key == "Digest") return setString(type, text, m_file.digest, 0, m_seen);
+                if (m_key == "Size") return setNumber(type, text, m_file.size);
+                if (m_key == "Priority") {
+                    if (type != JsonStreamParser::ValueType::String) return fail("Priority must be a string");
+                    if (text == "deferred") m_file.flags |= FileEntry::FLAG_DEFERRED;
+                    if (text == "lazy") m_file.flags |= FileEntry::FLAG_LAZY;
+                }
+                return true;
+            }
+            if (m_section == Section::Variants) {
+                if (m_key == "Requires") return setString(type, text, m_artifact.cpuRequirements, SEEN_FROM, m_seen);
+                if (m_key == "UpdateLink") return setString(type, text, m_artifact.link, SEEN_LINK, m_seen);
+                if (m_key == "Package") return setString(type, text, m_artifact.package, 0, m_seen);
+            } else if (m_section == Section::Patches) {
+                if (m_key == "From") return setString(type, text, m_artifact.fromVersion, SEEN_FROM, m_seen);
+                if (m_key == "To") return setString(type, text, m_artifact.toVersion, SEEN_VERSION, m_seen);
+                if (m_key == "Link") return setString(type, text, m_artifact.link, SEEN_LINK, m_seen);
+            } else {
+                if (m_key == "Version") return setString(type, text, m_artifact.toVersion, SEEN_VERSION, m_seen);
+                if (m_key == "UpdateLink") return setString(type, text, m_artifact.link, SEEN_LINK, m_seen);
+                if (m_key == "Package") return setString(type, text, m_artifact.package, 0, m_seen);
+            }
+            if (m_key == "Digest") return setString(type, text, m_artifact.digest, 0, m_seen);
+            if (m_key == "Size") return setNumber(type, text, m_artifact.size);
+            return true;
+        }
+
+    private:
+        enum class Section { None, Images, Patches, Variants, Files };
+
+        // Required-field bits; their meaning depends on the entry kind
+        static constexpr unsigned SEEN_VERSION = 1;  ///< AppVersion, Version, To or Path
+        static constexpr unsigned SEEN_LINK = 2;     ///< UpdateLink or Link
+        static constexpr unsigned SEEN_FROM = 4;     ///< From, or Requires of a variant
+        static constexpr unsigned SEEN_SIZE = 8;
+        static constexpr unsigned SEEN_DIGEST = 16;
+
+        UpdateManifest& m_manifest;
+        std::ostream* m_spool;     // Receives Files entries instead of m_manifest.files, if set
+        size_t m_remaining;
+        size_t m_entryStart = 0;   // Budget left before the current entry
+        std::string m_lastPath;    // Path of the last spooled entry, to check the order
+        bool m_keepChunks;
+        std::string m_error;
+        std::string m_key;
+        size_t m_depth = 0;
+        size_t m_skip = 0;
+        Section m_section = Section::None;
+        unsigned m_topSeen = 0;
+        unsigned m_seen = 0;
+        unsigned m_fileSeen = 0;
+        UpdateArtifact m_latest;
+        UpdateArtifact m_artifact;
+        FileEntry m_file;
+        ChunkEntry m_chunk;
+        std::vector<UpdateArtifact> m_patches; // Kept apart so images precede patches, as in fromJson()
+
+        bool fail(const std::string& message) {
+            if (m_error.empty()) {
+                m_error = message;
+            }
+            return false;
+        }
+
+        bool charge(size_t bytes) {
+            return UpdateManifest::charge(m_remaining, bytes) || fail("Manifest exceeds the memory budget");
+        }
+
+        bool mark(unsigned bit) {
+            m_seen |= bit;
+            return true;
+        }
+
+        bool setString(JsonStreamParser::ValueType type, const std::string& text, std::string& field, unsigned bit,
+                   unsigned& seen) {
+            if (type != JsonStreamParser::ValueType::String) {
+                return fail("Failed to parse version information: " + m_key + " must be a string");
+            }
+            if (!charge(text.size())) {
+                return false;
+            }
+            field = text;
+            seen |= bit;
+            return true;
+        }
+
+        bool setNumber(JsonStreamParser::ValueType type, const std::string& text, uint64_t& field) {
+            if (type != JsonStreamParser::ValueType::Number || text.empty() ||
+                text.find_first_not_of("0123456789") != std::string::npos) {
+                return fail("Failed to parse version information: " + m_key + " must be an unsigned integer");
+            }
+            errno = 0;
+            field = std::strtoull(text.c_str(), nullptr, 10);
+            if (errno == ERANGE) {
+                return fail("Failed to parse version information: " + m_key + " is out of range");
+            }
+            return true;
+        }
+
+        /**
+         * @brief Validates and stores a finished Images, Patches, Variants or Files entry
+         */
+        bool endEntry() {
+            if (m_section == Section::Files) {
+                if ((m_seen & (SEEN_VERSION | SEEN_LINK)) != (SEEN_VERSION | SEEN_LINK)) {
+                    return fail("File entry needs Path and Link");
+                }
+                if (!charge(sizeof(FileEntry))) return false;
+                if (m_spool) {
+                    std::string message;
+                    if (!followsInOrder(m_lastPath, m_manifest.spooledFiles, m_file.path, message)) {
+                        return fail(message);
+                    }
+                    m_lastPath = m_file.path;
+                    // A spooled entry only occupies the budget while it is parsed
+                    writeBinaryFile(*m_spool, m_file);
+                    m_remaining = m_entryStart;
+                    ++m_manifest.spooledFiles;
+                    return !m_spool->fail() || fail("Failed to write the spooled file list");
+                }
+                m_manifest.files.push_back(std::move(m_file));
+                return true;
+            }
+            if (m_section == Section::Variants) {
+                if ((m_seen & (SEEN_FROM | SEEN_LINK)) != (SEEN_FROM | SEEN_LINK)) {
+                    return fail("Variant entry needs Requires and UpdateLink");
+                }
+                if (!charge(sizeof(UpdateArtifact))) return false;
+                m_manifest.variants.push_back(m_artifact);
+                return true;
+            }
+            const unsigned required = SEEN_VERSION | SEEN_LINK | (m_section == Section::Patches ? static_cast<unsigned>(SEEN_FROM) : 0);
+            if ((m_seen & required) != required) {
+                return fail(m_section == Section::Patches ? "Patch entry needs From, To and Link"
+                                                          : "Image entry needs Version and UpdateLink");
+            }
+            if (!charge(sizeof(UpdateArtifact))) return false;
+            if (m_section == Section::Patches) {
+                m_patches.push_back(m_artifact);
+            } else {
+                m_manifest.artifacts.push_back(m_artifact);
+            }
+            return true;
+        }
+    };
+};
+
+/**
+ * @class UpdatePlanner
+ * @brief Finds the cheapest sequence of downloads that reaches a version
+ */
+class UpdatePlanner {
+public:
+    /**
+     * @brief Plans the route from the installed version to the manifest's version
+     * @param manifest Manifest listing the available images and patches
+     * @param installedVersion Version currently installed
+     * @return Artifacts to download and apply in order; empty if unreachable
+     *
+     * Full images are reachable from any installed version; patches only
+     * from their base version. The cost is the total download size, with
+     * ties broken by fewer steps. Artifacts without a published size are
+     * costed as if they were larger than any sized artifact, so a route with
+     * known sizes is preferred.
+     */
+    static std::vector<UpdateArtifact> plan(const UpdateManifest& manifest, const std::string& installedVersion) {
+        return plan(manifest, installedVersion, [](const UpdateArtifact& artifact, bool) { return edgeCost(artifact); });
+    }
+
+    /**
+     * @brief Plans the route with the lowest total of a caller-defined step cost
+     * @param manifest Manifest listing the available images and patches
+     * @param installedVersion Version currently installed
+     * @param stepCost Cost of downloading and applying one artifact; the flag
+     *                 is true for the first step of a route. Ties are broken by fewer steps.
+     * @return Artifacts to download and apply in order; empty if unreachable
+     */
+    static std::vector<UpdateArtifact> plan(const UpdateManifest& manifest, const std::string& installedVersion,
+                                            const std::function<uint64_t(const UpdateArtifact&, bool)>& stepCost) {
+        typedef std::pair<uint64_t, size_t> Cost; // (cost, steps)
+        typedef std::pair<Cost, std::string> QueueEntry;
+
+        std::map<std::string, Cost> best;
+        std::map<std::string, size_t> via; // version -> artifact index used to reach it
+        std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> queue;
+
+        best[installedVersion] = Cost(0, 0);
+        queue.push(QueueEntry(Cost(0, 0), installedVersion));
+
+        while (!queue.empty()) {
+            const QueueEntry current = queue.top();
+            queue.pop();
+
+            const std::string& version = current.second;
+            if (current.first != best[version]) {
+                continue; // Stale queue entry
+            }
+            if (version == manifest.version) {
+                break;
+            }
+
+            for (size_t i = 0; i < manifest.artifacts.size(); ++i) {
+                const UpdateArtifact& artifact = manifest.artifacts[i];
+                const bool usable = artifact.kind == UpdateArtifact::Kind::FullImage
+                    ? version == installedVersion
+                    : artifact.fromVersion == version;
+                if (!usable || artifact.toVersion == installedVersion) {
+                    continue;
+                }
+
+                const Cost next(saturatingAdd(current.first.first, stepCost(artifact, version == installedVersion)),
+                                current.first.second + 1);
+                auto known = best.find(artifact.toVersion);
+                if (known == best.end() || next < known->second) {
+                    best[artifact.toVersion] = next;
+                    via[artifact.toVersion] = i;
+                    queue.push(QueueEntry(next, artifact.toVersion));
+                }
+            }
+        }
+
+        std::vector<UpdateArtifact> route;
+        if (!via.count(manifest.version)) {
+            return route;
+        }
+
+        for (std::string version = manifest.version; version != installedVersion;) {
+            const UpdateArtifact& artifact = manifest.artifacts[via[version]];
+            route.insert(route.begin(), artifact);
+            if (artifact.kind == UpdateArtifact::Kind::FullImage) {
+                break;
+            }
+            version = artifact.fromVersion;
+        }
+        return route;
+    }
+
+    /**
+     * @brief Sums the published sizes of a route
+     * @return Total bytes, or UpdateArtifact::UNKNOWN_SIZE if any size is unknown
+     */
+    static uint64_t totalSize(const std::vector<UpdateArtifact>& route) {
+        uint64_t total = 0;
+        for (const auto& artifact : route) {
+            if (artifact.size == UpdateArtifact::UNKNOWN_SIZE) {
+                return UpdateArtifact::UNKNOWN_SIZE;
+            }
+            total += artifact.size;
+        }
+        return total;
+    }
+
+    // Larger than any real download, small enough that sums cannot overflow
+    static constexpr uint64_t UNKNOWN_COST = 1ULL << 48;
+
+    static uint64_t saturatingAdd(uint64_t a, uint64_t b) {
+        return a > UINT64_MAX - b ? UINT64_MAX : a + b;
+    }
+
+private:
+    static uint64_t edgeCost(const UpdateArtifact& artifact) {
+        return artifact.size == UpdateArtifact::UNKNOWN_SIZE ? static_cast<uint64_t>(UNKNOWN_COST) : artifact.size;
+    }
+};
+
+} // namespace AutoUpdaterLib
+
+#endif // AUTO_UPDATER_MANIFEST_H
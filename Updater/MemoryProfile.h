@@ -0,0 +1,61 @@
+/**
+ * @file MemoryProfile.h
+ * @brief Buffer sizes and limits, with a bounded-memory build for small hosts
+ *
+ * @author myexistences
+ * @copyright Copyright (c) 2025 myexistences. All rights reserved.
+ * @license MIT License
+ *
+ * @description
+ * Define AUTO_UPDATER_BOUNDED_MEMORY before including Updater.h to keep the
+ * updater's heap use under AUTO_UPDATER_MEMORY_CEILING (256 KiB by default),
+ * whatever the size of the payload or manifest:
+ *
+ * - the manifest is parsed as a stream (JsonStream.h) into a model capped
+ *   at a quarter of the ceiling; chunk indexes are skipped and the file
+ *   list is spooled to the temp directory one entry at a time, so only
+ *   oversized single fields are rejected;
+ * - downloads, hashing, patching and comparisons use small fixed buffers,
+ *   and nothing is held in memory whole;
+ * - downloads use one connection instead of parallel ranges, and hashing
+ *   runs on one thread;
+ * - zip entries are spooled to disk and decompressed one at a time.
+ *
+ * The default build trades memory for speed with larger buffers and
+ * parallelism. Memory owned by WinINet and the C runtime is outside both
+ * budgets.
+ */
+
+#ifndef AUTO_UPDATER_MEMORY_PROFILE_H
+#define AUTO_UPDATER_MEMORY_PROFILE_H
+
+#include <cstddef>
+#include <cstdint>
+
+#ifndef AUTO_UPDATER_MEMORY_CEILING
+#define AUTO_UPDATER_MEMORY_CEILING (256 * 1024)
+#endif
+
+namespace AutoUpdaterLib {
+
+/**
+ * @struct MemoryProfile
+ * @brief Compile-time memory settings shared by every component
+ */
+struct MemoryProfile {
+#ifdef AUTO_UPDATER_BOUNDED_MEMORY
+    static constexpr bool BOUNDED = true;
+    static constexpr size_t IO_BUFFER_SIZE = 16 * 1024;                      ///< File and stream buffers
+    static constexpr size_t MANIFEST_BUDGET = AUTO_UPDATER_MEMORY_CEILING / 4; ///< Parsed manifest model
+    static constexpr size_t MAX_TOKEN_SIZE = 4 * 1024;                        ///< Longest JSON string or number
+#else
+    static constexpr bool BOUNDED = false;
+    static constexpr size_t IO_BUFFER_SIZE = 64 * 1024;
+    static constexpr size_t MANIFEST_BUDGET = SIZE_MAX;
+    static constexpr size_t MAX_TOKEN_SIZE = 1 << 20;
+#endif
+};
+
+} // namespace AutoUpdaterLib
+
+#endif // AUTO_UPDATER_MEMORY_PROFILE_H
@@ -0,0 +1,285 @@
+/**
+ * @file Patch.h
+ * @brief Binary patch format used for delta updates
+ *
+ * @author myexistences
+ * @copyright Copyright (c) 2025 myexistences. All rights reserved.
+ * @license MIT License
+ *
+ * @description
+ * A patch rebuilds a new file from an old one with bsdiff-style control
+ * records: copy-and-add a run of bytes from the old file, append literal
+ * bytes, then seek in the old file. The add-bytes are mostly zero for
+ * similar executables, so they are stored as zero runs and literals to keep
+ * the patch compact without a general-purpose compressor.
+ *
+ * @format
+ * ```
+ * "AUPATCH1"
+ * varint oldSize, varint newSize
+ * repeat until newSize bytes have been produced:
+ *     varint diffLen, varint extraLen, zigzag varint oldSeek
+ *     diff:  (varint zeroRun, varint literalLen, literalLen bytes)... covering diffLen
+ *     extra: extraLen raw bytes
+ * ```
+ */
+
+#ifndef AUTO_UPDATER_PATCH_H
+#define AUTO_UPDATER_PATCH_H
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "MemoryProfile.h"
+#include "Varint.h"
+
+namespace AutoUpdaterLib {
+
+/**
+ * @class PatchFormat
+ * @brief Patch container constants
+ */
+class PatchFormat {
+public:
+    static constexpr const char* MAGIC = "AUPATCH1";
+    static constexpr size_t MAGIC_SIZE = 8;
+};
+
+/**
+ * @class PatchWriter
+ * @brief Serialises control records produced by a differ into AUPATCH1
+ */
+class PatchWriter {
+private:
+    // Zero runs shorter than this are cheaper to keep inside a literal run
+    static constexpr size_t MIN_ZERO_RUN = 4;
+
+    std::ostream& m_out;
+
+public:
+    explicit PatchWriter(std::ostream& out) : m_out(out) {}
+
+    /**
+     * @brief Writes the patch header
+     * @param oldSize Size of the base file
+     * @param newSize Size of the file the patch produces
+     */
+    void begin(uint64_t oldSize, uint64_t newSize) {
+        m_out.write(PatchFormat::MAGIC, PatchFormat::MAGIC_SIZE);
+        Varint::write(m_out, oldSize);
+        Varint::write(m_out, newSize);
+    }
+
+    /**
+     * @brief Writes one control record
+     * @param diff Bytewise difference new - old for the copied region
+     * @param diffLen Length of the copied region
+     * @param extra Literal bytes appended after the copied region
+     * @param extraLen Number of literal bytes
+     * @param seek Adjustment of the old-file position after the record
+     */
+    void addRecord(const uint8_t* diff, size_t diffLen, const uint8_t* extra, size_t extraLen, int64_t seek) {
+        Varint::write(m_out, diffLen);
+        Varint::write(m_out, extraLen);
+        Varint::writeSigned(m_out, seek);
+
+        size_t pos = 0;
+        while (pos < diffLen) {
+            size_t zeroRun = 0;
+            while (pos + zeroRun < diffLen && diff[pos + zeroRun] == 0) {
+                ++zeroRun;
+            }
+
+            // Extend the literal run until a zero run long enough to pay for a new pair
+            size_t literalEnd = pos + zeroRun;
+            while (literalEnd < diffLen) {
+                size_t zeros = 0;
+                while (literalEnd + zeros < diffLen && diff[literalEnd + zeros] == 0 && zeros < MIN_ZERO_RUN) {
+                    ++zeros;
+                }
+                if (zeros == MIN_ZERO_RUN || literalEnd + zeros == diffLen) {
+                    break;
+                }
+                literalEnd += zeros + 1;
+            }
+
+            const size_t literalLen = literalEnd - (pos + zeroRun);
+            Varint::write(m_out, zeroRun);
+            Varint::write(m_out, literalLen);
+            m_out.write(reinterpret_cast<const char*>(diff + pos + zeroRun), static_cast<std::streamsize>(literalLen));
+            pos = literalEnd;
+        }
+
+        m_out.write(reinterpret_cast<const char*>(extra), static_cast<std::streamsize>(extraLen));
+    }
+};
+
+/**
+ * @class PatchApplier
+ * @brief Streams a patch over an old file to produce the new file
+ *
+ * Memory use is bounded by one I/O buffer; the old file is read with seeks
+ * and the new file is written sequentially.
+ */
+class PatchApplier {
+private:
+    static constexpr size_t BUFFER_SIZE = MemoryProfile::IO_BUFFER_SIZE;
+
+    std::string m_error;
+
+    static size_t stepSize(uint64_t remaining) {
+        return remaining < BUFFER_SIZE ? static_cast<size_t>(remaining) : static_cast<size_t>(BUFFER_SIZE);
+    }
+
+    bool fail(const std::string& message) {
+        m_error = message;
+        return false;
+    }
+
+public:
+    /**
+     * @brief Applies a patch file
+     * @param oldPath File the patch was generated against
+     * @param patchPath Patch in AUPATCH1 format
+     * @param newPath Output file to create
+     * @return true on success; see lastError() otherwise
+     */
+    bool apply(const std::string& oldPath, const std::string& patchPath, const std::string& newPath) {
+        std::ifstream oldFile(oldPath, std::ios::binary | std::ios::ate);
+        if (!oldFile.is_open()) {
+            return fail("Failed to open base file: " + oldPath);
+        }
+        const uint64_t actualOldSize = static_cast<uint64_t>(oldFile.tellg());
+        oldFile.seekg(0);
+
+        std::ifstream patch(patchPath, std::ios::binary);
+        if (!patch.is_open()) {
+            return fail("Failed to open patch: " + patchPath);
+        }
+
+        char magic[PatchFormat::MAGIC_SIZE];
+        patch.read(magic, sizeof(magic));
+        if (patch.gcount() != static_cast<std::streamsize>(sizeof(magic)) ||
+            std::memcmp(magic, PatchFormat::MAGIC, sizeof(magic)) != 0) {
+            return fail("Not a patch file: " + patchPath);
+        }
+
+        uint64_t oldSize = 0;
+        uint64_t newSize = 0;
+        if (!Varint::read(patch, oldSize) || !Varint::read(patch, newSize)) {
+            return fail("Truncated patch header");
+        }
+        if (oldSize != actualOldSize) {
+            return fail("Patch does not match base file size");
+        }
+
+        std::ofstream out(newPath, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            return fail("Failed to create file: " + newPath);
+        }
+
+        std::vector<char> oldBuffer(BUFFER_SIZE);
+        std::vector<char> patchBuffer(BUFFER_SIZE);
+        int64_t oldPos = 0;
+        uint64_t written = 0;
+
+        while (written < newSize) {
+            uint64_t diffLen = 0;
+            uint64_t extraLen = 0;
+            int64_t seek = 0;
+            if (!Varint::read(patch, diffLen) ||
+                !Varint::read(patch, extraLen) ||
+                !Varint::readSigned(patch, seek)) {
+                return fail("Truncated patch control record");
+            }
+            // Compared without sums, which hostile varints could wrap past the check
+            if (diffLen > newSize - written || extraLen > newSize - written - diffLen) {
+                return fail("Patch control record exceeds output size");
+            }
+            if (diffLen > 0 && (oldPos < 0 || static_cast<uint64_t>(oldPos) > oldSize ||
+                                diffLen > oldSize - static_cast<uint64_t>(oldPos))) {
+                return fail("Patch reads outside base file");
+            }
+
+            // Diff section: old bytes plus a sparse delta, coded as zero runs and literals
+            oldFile.seekg(static_cast<std::streamoff>(oldPos));
+            uint64_t remaining = diffLen;
+            while (remaining > 0) {
+                uint64_t zeroRun = 0;
+                uint64_t literalLen = 0;
+                if (!Varint::read(patch, zeroRun) || !Varint::read(patch, literalLen) ||
+                    zeroRun > remaining || literalLen > remaining - zeroRun || zeroRun + literalLen == 0) {
+                    return fail("Corrupt patch diff section");
+                }
+
+                for (uint64_t done = 0; done < zeroRun + literalLen;) {
+                    const size_t step = stepSize(zeroRun + literalLen - done);
+                    oldFile.read(oldBuffer.data(), static_cast<std::streamsize>(step));
+                    if (static_cast<size_t>(oldFile.gcount()) != step) {
+                        return fail("Failed to read base file");
+                    }
+
+                    // Only the part of this step past the zero run carries literals
+                    const uint64_t literalStart = done < zeroRun ? zeroRun - done : 0;
+                    if (literalStart < step) {
+                        const size_t count = step - static_cast<size_t>(literalStart);
+                        patch.read(patchBuffer.data(), static_cast<std::streamsize>(count));
+                        if (static_cast<size_t>(patch.gcount()) != count) {
+                            return fail("Truncated patch diff literals");
+                        }
+                        for (size_t i = 0; i < count; ++i) {
+                            char& target = oldBuffer[static_cast<size_t>(literalStart) + i];
+                            target = static_cast<char>(static_cast<unsigned char>(target) +
+                                                       static_cast<unsigned char>(patchBuffer[i]));
+                        }
+                    }
+
+                    out.write(oldBuffer.data(), static_cast<std::streamsize>(step));
+                    done += step;
+                }
+                remaining -= zeroRun + literalLen;
+            }
+            oldPos += static_cast<int64_t>(diffLen);
+
+            // Extra section: literal bytes with no counterpart in the old file
+            for (uint64_t done = 0; done < extraLen;) {
+                const size_t step = stepSize(extraLen - done);
+                patch.read(patchBuffer.data(), static_cast<std::streamsize>(step));
+                if (static_cast<size_t>(patch.gcount()) != step) {
+                    return fail("Truncated patch extra section");
+                }
+                out.write(patchBuffer.data(), static_cast<std::streamsize>(step));
+                done += step;
+            }
+
+            written += diffLen + extraLen;
+            if ((seek > 0 && oldPos > INT64_MAX - seek) || (seek < 0 && oldPos < INT64_MIN - seek)) {
+                return fail("Patch seeks outside base file");
+            }
+            oldPos += seek;
+
+            if (out.fail()) {
+                return fail("Failed to write to file: " + newPath);
+            }
+        }
+
+        out.close();
+        if (out.fail()) {
+            return fail("Failed to write to file: " + newPath);
+        }
+        return true;
+    }
+
+    /**
+     * @brief Describes why the last apply() failed
+     */
+    const std::string& lastError() const {
+        return m_error;
+    }
+};
+
+} // namespace AutoUpdaterLib
+
+#endif // AUTO_UPDATER_PATCH_H
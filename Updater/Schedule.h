@@ -0,0 +1,265 @@
+/**
+ * @file Schedule.h
+ * @brief Check scheduling with jitter and backoff, conditional manifest requests and load-aware apply
+ *
+ * @author myexistences
+ * @copyright Copyright (c) 2025 myexistences. All rights reserved.
+ * @license MIT License
+ *
+ * @description
+ * Long-running processes check for updates on a schedule. Two things keep
+ * a large fleet from overwhelming the update host:
+ *
+ * - CheckSchedule spreads checks out. Each interval is randomised by
+ *   a jitter percentage, so clients started together drift apart. After a
+ *   failure the delay grows exponentially with "equal jitter" (half fixed,
+ *   half random) up to a cap, and never undercuts a server's Retry-After.
+ * - ConditionalRequest remembers the manifest's ETag and Last-Modified
+ *   validators and turns repeat checks into If-None-Match /
+ *   If-Modified-Since requests, answered with a bodiless 304 while nothing
+ *   has been published.
+ *
+ * Once an update is staged, ApplyGate decides when to restart into it: it
+ * samples the application's own load figure and opens when the load has
+ * stayed at or below a threshold for a while, or when the update has been
+ * held for the maximum deferral.
+ *
+ * All three are independent of WinINet and of the wall clock; times are plain
+ * millisecond counts. AutoUpdater::pollForUpdates() drives them with
+ * GetTickCount64(), and Tools/FleetSim.cpp with a virtual clock.
+ */
+
+#ifndef AUTO_UPDATER_SCHEDULE_H
+#define AUTO_UPDATER_SCHEDULE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <string>
+
+namespace AutoUpdaterLib {
+
+/**
+ * @struct CheckPolicy
+ * @brief Timing of periodic checks, in milliseconds
+ */
+struct CheckPolicy {
+    uint64_t intervalMs = 6ULL * 60 * 60 * 1000;    ///< Time between successful checks
+    uint32_t jitterPercent = 10;                   ///< Each interval varies by up to this much either way
+    uint64_t startSpreadMs = 0;                    ///< First check waits a random time up to this
+    uint64_t minBackoffMs = 60 * 1000;             ///< Delay after the first failure
+    uint64_t maxBackoffMs = 6ULL * 60 * 60 * 1000; ///< Cap on the delay after repeated failures
+};
+
+/**
+ * @class CheckSchedule
+ * @brief Decides when the next update check is due
+ */
+class CheckSchedule {
+public:
+    /**
+     * @brief Creates a schedule
+     * @param policy Timing to follow
+     * @param seed Seed for the jitter; give every client a different one
+     */
+    explicit CheckSchedule(const CheckPolicy& policy = CheckPolicy(), uint64_t seed = 0)
+        : m_policy(policy), m_random(seed) {}
+
+    /**
+     * @brief Schedules the first check
+     * @param now Current time
+     * @return Time of the first check
+     */
+    uint64_t start(uint64_t now) {
+        m_failures = 0;
+        m_next = now + (m_policy.startSpreadMs > 0 ? uniform(0, m_policy.startSpreadMs) : 0);
+        return m_next;
+    }
+
+    /**
+     * @brief Schedules the next check after one that reached the server
+     * @param now Time the check finished
+     * @return Time of the next check
+     */
+    uint64_t succeeded(uint64_t now) {
+        m_failures = 0;
+        const uint64_t spread = m_policy.intervalMs / 100 * std::min<uint32_t>(m_policy.jitterPercent, 100);
+        m_next = now + m_policy.intervalMs - spread + uniform(0, 2 * spread);
+        return m_next;
+    }
+
+    /**
+     * @brief Schedules a retry after a failed check
+     * @param now Time the check failed
+     * @param retryAfterMs Minimum delay requested by the server, or 0
+     * @return Time of the retry
+     */
+    uint64_t failed(uint64_t now, uint64_t retryAfterMs = 0) {
+        uint64_t backoff = m_policy.minBackoffMs;
+        for (uint32_t i = 0; i < m_failures && backoff < m_policy.maxBackoffMs; ++i) {
+            backoff *= 2;
+        }
+        backoff = std::min(backoff, m_policy.maxBackoffMs);
+        ++m_failures;
+        m_next = now + std::max(backoff / 2 + uniform(0, backoff / 2), retryAfterMs);
+        return m_next;
+    }
+
+    /**
+     * @brief Parses a Retry-After header given in seconds
+     * @return Delay in milliseconds, or 0 if absent or given as an HTTP date
+     */
+    static uint64_t parseRetryAfter(const std::string& value) {
+        if (value.empty() || value.find_first_not_of("0123456789 ") != std::string::npos) {
+            return 0;
+        }
+        return std::min<uint64_t>(std::strtoull(value.c_str(), nullptr, 10), 7ULL * 24 * 60 * 60) * 1000;
+    }
+
+    uint64_t nextCheck() const { return m_next; }
+    uint32_t failures() const { return m_failures; }
+
+private:
+    CheckPolicy m_policy;
+    uint64_t m_random;
+    uint64_t m_next = 0;
+    uint32_t m_failures = 0;
+
+    /**
+     * @brief Returns a pseudo-random value in [low, high] (SplitMix64)
+     */
+    uint64_t uniform(uint64_t low, uint64_t high) {
+        uint64_t z = (m_random += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        z ^= z >> 31;
+        const uint64_t range = high - low;
+        return range == UINT64_MAX ? z : low + z % (range + 1);
+    }
+};
+
+/**
+ * @class ConditionalRequest
+ * @brief Validators of the last manifest and the outcome of the latest request
+ */
+class ConditionalRequest {
+public:
+    /**
+     * @brief Gets the request headers that make the next request conditional
+     * @return "Name: value\r\n" lines; empty before the first response
+     */
+    std::string headers() const {
+        std::string result;
+        if (!m_etag.empty()) {
+            result += "If-None-Match: " + m_etag + "\r\n";
+        }
+        if (!m_lastModified.empty()) {
+            result += "If-Modified-Since: " + m_lastModified + "\r\n";
+        }
+        return result;
+    }
+
+    /**
+     * @brief Records a response
+     * @param status HTTP status code
+     * @param etag ETag response header, possibly empty
+     * @param lastModified Last-Modified response header, possibly empty
+     * @param retryAfter Retry-After response header, possibly empty
+     */
+    void received(unsigned status, const std::string& etag, const std::string& lastModified, const std::string& retryAfter) {
+        m_notModified = status == 304;
+        m_retryAfterMs = status == 429 || status == 503 ? CheckSchedule::parseRetryAfter(retryAfter) : 0;
+        if (status == 200) {
+            m_etag = etag;
+            m_lastModified = lastModified;
+        }
+    }
+
+    /**
+     * @brief Forgets the validators, so the next request fetches the manifest
+     */
+    void reset() {
+        m_etag.clear();
+        m_lastModified.clear();
+        m_notModified = false;
+        m_retryAfterMs = 0;
+    }
+
+    bool notModified() const { return m_notModified; }   ///< The latest response was 304
+    uint64_t retryAfterMs() const { return m_retryAfterMs; } ///< Delay requested with a 429 or 503
+    const std::string& etag() const { return m_etag; }
+
+private:
+    std::string m_etag;
+    std::string m_lastModified;
+    bool m_notModified = false;
+    uint64_t m_retryAfterMs = 0;
+};
+
+/**
+ * @struct ApplyPolicy
+ * @brief When a staged update may restart the application, in milliseconds
+ */
+struct ApplyPolicy {
+    /// Current load in the application's own units, e.g. in-flight requests
+    /// plus queue depth; empty to apply as soon as the update is staged
+    std::function<uint64_t()> load;
+    uint64_t threshold = 0;                  ///< Highest load at which the restart may happen
+    uint64_t quietMs = 10 * 1000;            ///< Load must stay at or below the threshold this long
+    uint64_t maxDeferralMs = 60 * 60 * 1000; ///< Restart anyway once the update has been held this long
+    uint64_t sampleIntervalMs = 1000;        ///< Time between load samples
+};
+
+/**
+ * @class ApplyGate
+ * @brief Holds a staged update until the application's load allows a restart
+ */
+class ApplyGate {
+public:
+    /**
+     * @brief Starts holding an update
+     * @param policy Threshold and deferral limits
+     * @param now Time the update was staged
+     */
+    ApplyGate(const ApplyPolicy& policy, uint64_t now) : m_policy(policy), m_start(now) {}
+
+    /**
+     * @brief Samples the load and decides whether to restart now
+     * @param now Current time
+     * @return true once the load has been low for quietMs, or maxDeferralMs has passed
+     */
+    bool ready(uint64_t now) {
+        if (!m_policy.load) {
+            return true;
+        }
+        m_lastLoad = m_policy.load();
+        if (m_lastLoad > m_policy.threshold) {
+            m_quiet = false;
+        } else if (!m_quiet) {
+            m_quiet = true;
+            m_quietSince = now;
+        }
+        if (m_quiet && now - m_quietSince >= m_policy.quietMs) {
+            return true;
+        }
+        m_expired = now - m_start >= m_policy.maxDeferralMs;
+        return m_expired;
+    }
+
+    uint64_t lastLoad() const { return m_lastLoad; }  ///< Load at the latest sample
+    bool expired() const { return m_expired; }        ///< ready() gave up waiting for low load
+    uint64_t heldMs(uint64_t now) const { return now - m_start; }
+
+private:
+    ApplyPolicy m_policy;
+    uint64_t m_start;
+    uint64_t m_quietSince = 0;
+    uint64_t m_lastLoad = 0;
+    bool m_quiet = false;
+    bool m_expired = false;
+};
+
+} // namespace AutoUpdaterLib
+
+#endif // AUTO_UPDATER_SCHEDULE_H
@@ -0,0 +1,505 @@
+/**
+ * @file Snapshot.h
+ * @brief Copy-on-write rollback snapshots of the install directory
+ *
+ * @author myexistences
+ * @copyright Copyright (c) 2025 myexistences. All rights reserved.
+ * @license MIT License
+ *
+ * @description
+ * Before an update is applied, the install directory is snapshotted into
+ * `<install>\.rollback\<version>`. Files the update leaves alone are
+ * hard-linked into the snapshot and cost one directory entry each. Files
+ * the update replaces are block-cloned where the volume supports it (ReFS)
+ * and copied otherwise. A snapshot therefore costs time and space in
+ * proportion to the update rather than to the install.
+ *
+ * A hard link shares its contents with the installed file, so an update
+ * must never rewrite an unchanged file in place. The updater removes
+ * unchanged files from its staging directory for this reason.
+ *
+ * Each snapshot also records the paths the update writes. A restore only
+ * touches those paths, so logs, caches and settings the application
+ * wrote after the update survive a rollback.
+ */
+
+#ifndef AUTO_UPDATER_SNAPSHOT_H
+#define AUTO_UPDATER_SNAPSHOT_H
+
+#include <windows.h>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <set>
+#include <string>
+#include <vector>
+#include "MemoryProfile.h"
+
+namespace AutoUpdaterLib {
+
+/**
+ * @class RollbackSnapshot
+ * @brief Creates, restores and prunes snapshots of an install directory
+ */
+class RollbackSnapshot {
+public:
+    static constexpr const char* DIRECTORY_NAME = ".rollback";
+    static constexpr const char* CHANGES_NAME = ".rollback_changes"; // Paths the update writes, one per line
+
+    /**
+     * @struct Stats
+     * @brief How each file of a snapshot was materialised
+     */
+    struct Stats {
+        size_t linked = 0;         ///< Unchanged files shared through hard links
+        size_t cloned = 0;         ///< Changed files block-cloned on the volume
+        size_t copied = 0;         ///< Files copied byte for byte
+        uint64_t bytesCopied = 0;  ///< Bytes actually written by copies
+    };
+
+    /**
+     * @brief Gets the snapshot directory for a version
+     * @param installDir Install directory
+     * @param version Version the snapshot preserves
+     * @return Path of the snapshot directory
+     */
+    static std::string path(const std::string& installDir, const std::string& version) {
+        return installDir + "\\" + DIRECTORY_NAME + "\\" + directoryName(version);
+    }
+
+    /**
+     * @brief Lists files below a directory, skipping the snapshot store
+     * @param root Directory to walk
+     * @param files Receives '\\'-separated paths relative to root
+     * @return false if a directory could not be read
+     */
+    static bool listFiles(const std::string& root, std::vector<std::string>& files) {
+        return listFiles(root, "", files, nullptr);
+    }
+
+    /**
+     * @brief Normalises a relative path for case-insensitive comparison
+     */
+    static std::string normalise(std::string relativePath) {
+        for (auto& c : relativePath) {
+            c = c == '/' ? '\\' : static_cast<char>(tolower(static_cast<unsigned char>(c)));
+        }
+        return relativePath;
+    }
+
+    /**
+     * @brief Snapshots the install directory before an update
+     * @param installDir Install directory
+     * @param snapshotDir Snapshot directory to create; an older one is replaced
+     * @param changedPaths normalise()d relative paths the update will write,
+     *                     whether it replaces or adds them
+     * @param stats Receives how files were materialised
+     * @param error Receives a description when the snapshot fails
+     * @return true if every file was preserved
+     */
+    static bool create(const std::string& installDir, const std::string& snapshotDir,
+                       const std::set<std::string>& changedPaths, Stats& stats, std::string& error) {
+        removeAsideFiles(installDir);
+        std::vector<std::string> files;
+        if (!listFiles(installDir, files)) {
+            error = "Failed to read install directory: " + installDir;
+            return false;
+        }
+
+        removeTree(snapshotDir);
+        if (!createDirectories(snapshotDir)) {
+            error = "Failed to create snapshot directory: " + snapshotDir;
+            return false;
+        }
+
+        const VolumeInfo volume = volumeInfo(installDir);
+        for (const auto& file : files) {
+            const std::string source = installDir + "\\" + file;
+            const std::string target = snapshotDir + "\\" + file;
+            if (!createParents(target)) {
+                error = "Failed to create directory for " + target;
+                removeTree(snapshotDir);
+                return false;
+            }
+
+            const bool changed = changedPaths.count(normalise(file)) != 0;
+            if (!changed && volume.hardLinks && CreateHardLinkA(target.c_str(), source.c_str(), nullptr)) {
+                ++stats.linked;
+            } else if (changed && volume.blockCloning && blockClone(source, target, volume.clusterSize)) {
+                ++stats.cloned;
+            } else if (CopyFileA(source.c_str(), target.c_str(), FALSE)) {
+                ++stats.copied;
+                stats.bytesCopied += fileSize(target);
+            } else {
+                error = "Failed to preserve " + source;
+                removeTree(snapshotDir);
+                return false;
+            }
+        }
+
+        std::ofstream changes(snapshotDir + "\\" + CHANGES_NAME, std::ios::trunc);
+        for (const auto& changed : changedPaths) {
+            changes << changed << '\n';
+        }
+        changes.close();
+        if (changes.fail()) {
+            error = "Failed to record the changed files in " + snapshotDir;
+            removeTree(snapshotDir);
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Restores the install directory from a snapshot
+     * @param snapshotDir Snapshot to restore
+     * @param installDir Install directory
+     * @param error Receives a description when the restore fails
+     * @return true if every file the update wrote is back to its snapshot state
+     *
+     * Only the paths the update wrote are touched: replaced files are
+     * restored and files the update added are removed. Everything else in
+     * the install directory, including data the application wrote since,
+     * is left alone. Files still hard-linked to the snapshot are already
+     * correct and are skipped. Replaced files are renamed aside first,
+     * which Windows allows even for the running executable. A snapshot
+     * without a record of its changes, taken by an older version, has
+     * every differing file restored and nothing removed.
+     */
+    static bool restore(const std::string& snapshotDir, const std::string& installDir, std::string& error) {
+        std::vector<std::string> snapshotFiles;
+        if (!listFiles(snapshotDir, snapshotFiles) || snapshotFiles.empty()) {
+            error = "Snapshot is missing or unreadable: " + snapshotDir;
+            return false;
+        }
+        removeAsideFiles(installDir);
+
+        std::set<std::string> changes;
+        std::ifstream recorded(snapshotDir + "\\" + CHANGES_NAME);
+        const bool haveChanges = recorded.is_open();
+        for (std::string line; std::getline(recorded, line);) {
+            if (!line.empty()) {
+                changes.insert(line);
+            }
+        }
+
+        for (const auto& file : snapshotFiles) {
+            const std::string source = snapshotDir + "\\" + file;
+            const std::string target = installDir + "\\" + file;
+            if ((haveChanges && changes.erase(normalise(file)) == 0) || sameFile(source, target)) {
+                continue;
+            }
+            if (!createParents(target) || !moveAside(target) ||
+                !CopyFileA(source.c_str(), target.c_str(), FALSE)) {
+                error = "Failed to restore " + target;
+                return false;
+            }
+        }
+
+        // What is left was added by the update
+        for (const auto& added : changes) {
+            if (!moveAside(installDir + "\\" + added)) {
+                error = "Failed to remove " + installDir + "\\" + added;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Removes every snapshot except the one for a version
+     * @param installDir Install directory
+     * @param keepVersion Version whose snapshot survives; empty removes all
+     */
+    static void prune(const std::string& installDir, const std::string& keepVersion) {
+        const std::string store = installDir + "\\" + DIRECTORY_NAME;
+        WIN32_FIND_DATAA findData;
+        HANDLE find = FindFirstFileA((store + "\\*").c_str(), &findData);
+        if (find == INVALID_HANDLE_VALUE) {
+            return;
+        }
+        do {
+            const std::string name = findData.cFileName;
+            if (name != "." && name != ".." && (keepVersion.empty() || name != directoryName(keepVersion))) {
+                removeTree(store + "\\" + name);
+            }
+        } while (FindNextFileA(find, &findData));
+        FindClose(find);
+    }
+
+    /**
+     * @brief Deletes a directory and everything below it
+     * @param path Directory to remove; missing directories are ignored
+     */
+    static void removeTree(const std::string& path) {
+        WIN32_FIND_DATAA findData;
+        HANDLE find = FindFirstFileA((path + "\\*").c_str(), &findData);
+        if (find != INVALID_HANDLE_VALUE) {
+            do {
+                const std::string name = findData.cFileName;
+                if (name == "." || name == "..") {
+                    continue;
+                }
+                const std::string child = path + "\\" + name;
+                if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+                    removeTree(child);
+                } else {
+                    DeleteFileA(child.c_str());
+                }
+            } while (FindNextFileA(find, &findData));
+            FindClose(find);
+        }
+        RemoveDirectoryA(path.c_str());
+    }
+
+    /**
+     * @brief Compares the contents of two files
+     * @return true if both exist and hold the same bytes
+     */
+    static bool sameContents(const std::string& a, const std::string& b) {
+        if (fileSize(a) != fileSize(b)) {
+            return false;
+        }
+        std::ifstream first(a, std::ios::binary);
+        std::ifstream second(b, std::ios::binary);
+        if (!first.is_open() || !second.is_open()) {
+            return false;
+        }
+        std::vector<char> left(COMPARE_BUFFER_SIZE);
+        std::vector<char> right(COMPARE_BUFFER_SIZE);
+        for (;;) {
+            first.read(left.data(), static_cast<std::streamsize>(left.size()));
+            second.read(right.data(), static_cast<std::streamsize>(right.size()));
+            const std::streamsize got = first.gcount();
+            if (got != second.gcount() || std::memcmp(left.data(), right.data(), static_cast<size_t>(got)) != 0) {
+                return false;
+            }
+            if (got == 0) {
+                return first.eof() && second.eof();
+            }
+        }
+    }
+
+    /**
+     * @brief Creates the directories leading to a file
+     * @param path File path
+     * @return true if the parent directory exists afterwards
+     */
+    static bool createParents(const std::string& path) {
+        const size_t separator = path.find_last_of('\\');
+        return separator == std::string::npos || createDirectories(path.substr(0, separator));
+    }
+
+    /**
+     * @brief Creates a directory and any missing parents
+     * @param path Directory path
+     * @return true if the directory exists afterwards
+     */
+    static bool createDirectories(const std::string& path) {
+        if (GetFileAttributesA(path.c_str()) != INVALID_FILE_ATTRIBUTES) {
+            return true;
+        }
+        if (!createParents(path)) {
+            return false;
+        }
+        return CreateDirectoryA(path.c_str(), nullptr) || GetLastError() == ERROR_ALREADY_EXISTS;
+    }
+
+private:
+    static constexpr size_t COMPARE_BUFFER_SIZE = MemoryProfile::IO_BUFFER_SIZE;
+    static constexpr uint64_t CLONE_LIMIT = 1ULL << 31; // Per-request limit is below 4 GiB
+
+    struct VolumeInfo {
+        bool hardLinks = false;
+        bool blockCloning = false;
+        uint64_t clusterSize = 0;
+    };
+
+    /**
+     * @brief Maps a version to a directory name that cannot escape the store
+     */
+    static std::string directoryName(const std::string& version) {
+        std::string name = "v";
+        for (char c : version) {
+            name.push_back(isalnum(static_cast<unsigned char>(c)) || c == '.' || c == '-' ? c : '_');
+        }
+        return name;
+    }
+
+    /**
+     * @brief Deletes files renamed aside by an earlier restore, where possible
+     */
+    static void removeAsideFiles(const std::string& root) {
+        std::vector<std::string> files;
+        std::vector<std::string> aside;
+        listFiles(root, "", files, &aside);
+        for (const auto& file : aside) {
+            DeleteFileA((root + "\\" + file).c_str());
+        }
+    }
+
+    static bool listFiles(const std::string& root, const std::string& relative, std::vector<std::string>& files,
+                          std::vector<std::string>* aside) {
+        const std::string directory = relative.empty() ? root : root + "\\" + relative;
+        WIN32_FIND_DATAA findData;
+        HANDLE find = FindFirstFileA((directory + "\\*").c_str(), &findData);
+        if (find == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        bool ok = true;
+        do {
+            const std::string name = findData.cFileName;
+            if (name == "." || name == ".." || (relative.empty() && isReserved(name))) {
+                continue;
+            }
+            const std::string path = relative.empty() ? name : relative + "\\" + name;
+            if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+                ok = listFiles(root, path, files, aside) && ok;
+            } else if (isAside(name)) {
+                if (aside) {
+                    aside->push_back(path); // Left behind by an earlier restore
+                }
+            } else {
+                files.push_back(path);
+            }
+        } while (FindNextFileA(find, &findData));
+        FindClose(find);
+        return ok;
+    }
+
+    /**
+     * @brief Checks for the updater's own bookkeeping in the install root
+     *
+     * Covers the snapshot store, a snapshot's record of its changes and
+     * the apply journal with its pending files (see Journal.h), none of
+     * which belong to the application.
+     */
+    static bool isReserved(const std::string& name) {
+        return name == DIRECTORY_NAME || name == CHANGES_NAME || name == ".pending" || name == ".update_journal";
+    }
+
+    static VolumeInfo volumeInfo(const std::string& path) {
+        VolumeInfo info;
+        char root[MAX_PATH];
+        DWORD flags = 0;
+        if (!GetVolumePathNameA(path.c_str(), root, MAX_PATH) ||
+            !GetVolumeInformationA(root, nullptr, 0, nullptr, nullptr, &flags, nullptr, 0)) {
+            return info;
+        }
+        info.hardLinks = (flags & FILE_SUPPORTS_HARD_LINKS) != 0;
+
+        DWORD sectorsPerCluster = 0, bytesPerSector = 0, freeClusters = 0, totalClusters = 0;
+        if ((flags & FILE_SUPPORTS_BLOCK_REFCOUNTING) &&
+            GetDiskFreeSpaceA(root, &sectorsPerCluster, &bytesPerSector, &freeClusters, &totalClusters)) {
+            info.clusterSize = static_cast<uint64_t>(sectorsPerCluster) * bytesPerSector;
+            info.blockCloning = info.clusterSize != 0;
+        }
+        return info;
+    }
+
+    /**
+     * @brief Clones a file's extents into a new file on the same volume
+     * @return false if the volume refused, leaving no target behind
+     */
+    static bool blockClone(const std::string& source, const std::string& target, uint64_t clusterSize) {
+        HANDLE from = CreateFileA(source.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+                                  nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (from == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        HANDLE to = CreateFileA(target.c_str(), GENERIC_READ | GENERIC_WRITE, 0,
+                                nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (to == INVALID_HANDLE_VALUE) {
+            CloseHandle(from);
+            return false;
+        }
+
+        LARGE_INTEGER size;
+        FILE_END_OF_FILE_INFO endOfFile;
+        bool ok = GetFileSizeEx(from, &size) != 0;
+        endOfFile.EndOfFile = size;
+        ok = ok && SetFileInformationByHandle(to, FileEndOfFileInfo, &endOfFile, sizeof(endOfFile));
+
+        // Ranges must be whole clusters; the last one may run past end of file
+        const uint64_t total = ok ? (static_cast<uint64_t>(size.QuadPart) + clusterSize - 1) / clusterSize * clusterSize : 0;
+        for (uint64_t offset = 0; ok && offset < total; ) {
+            const uint64_t remaining = total - offset;
+            const uint64_t length = remaining < CLONE_LIMIT ? remaining : static_cast<uint64_t>(CLONE_LIMIT);
+            DUPLICATE_EXTENTS_DATA extents;
+            extents.FileHandle = from;
+            extents.SourceFileOffset.QuadPart = static_cast<LONGLONG>(offset);
+            extents.TargetFileOffset.QuadPart = static_cast<LONGLONG>(offset);
+            extents.ByteCount.QuadPart = static_cast<LONGLONG>(length);
+            DWORD returned = 0;
+            ok = DeviceIoControl(to, FSCTL_DUPLICATE_EXTENTS_TO_FILE, &extents, sizeof(extents),
+                                 nullptr, 0, &returned, nullptr) != 0;
+            offset += length;
+        }
+
+        CloseHandle(to);
+        CloseHandle(from);
+        if (!ok) {
+            DeleteFileA(target.c_str());
+        }
+        return ok;
+    }
+
+    /**
+     * @brief Checks whether two paths are hard links to the same file
+     */
+    static bool sameFile(const std::string& a, const std::string& b) {
+        BY_HANDLE_FILE_INFORMATION first;
+        BY_HANDLE_FILE_INFORMATION second;
+        if (!fileInformation(a, first) || !fileInformation(b, second)) {
+            return false;
+        }
+        return first.dwVolumeSerialNumber == second.dwVolumeSerialNumber &&
+               first.nFileIndexHigh == second.nFileIndexHigh &&
+               first.nFileIndexLow == second.nFileIndexLow;
+    }
+
+    static bool fileInformation(const std::string& path, BY_HANDLE_FILE_INFORMATION& info) {
+        HANDLE file = CreateFileA(path.c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                  nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        const bool ok = GetFileInformationByHandle(file, &info) != 0;
+        CloseHandle(file);
+        return ok;
+    }
+
+    static uint64_t fileSize(const std::string& path) {
+        WIN32_FILE_ATTRIBUTE_DATA data;
+        if (!GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &data)) {
+            return UINT64_MAX;
+        }
+        return (static_cast<uint64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+    }
+
+    static bool isAside(const std::string& name) {
+        static const std::string suffix = ".rollback_old";
+        return name.size() > suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    /**
+     * @brief Moves a file out of the way so its name can be reused
+     * @return true if the path is free afterwards
+     *
+     * A running executable cannot be deleted but can be renamed; the
+     * renamed file is deleted by the next snapshot or restore, and is
+     * never listed as part of the install.
+     */
+    static bool moveAside(const std::string& path) {
+        if (GetFileAttributesA(path.c_str()) == INVALID_FILE_ATTRIBUTES || DeleteFileA(path.c_str())) {
+            return true;
+        }
+        const std::string aside = path + ".rollback_old";
+        return MoveFileExA(path.c_str(), aside.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+    }
+};
+
+} // namespace AutoUpdaterLib
+
+#endif // AUTO_UPDATER_SNAPSHOT_H
@@ -0,0 +1,297 @@
+/**
+ * @file StatusBoard.h
+ * @brief Update status shared with every local process through named shared memory
+ *
+ * @author myexistences
+ * @copyright Copyright (c) 2025 myexistences. All rights reserved.
+ * @license MIT License
+ *
+ * @description
+ * The updater publishes its state (current and target version, download
+ * progress, time of the last check) in a small named shared-memory segment.
+ * Any process in the same session can map it and read the state without
+ * I/O, locks or its own update check:
+ *
+ * ```cpp
+ * AutoUpdaterLib::StatusBoard board;
+ * AutoUpdaterLib::UpdateStatus status;
+ * if (board.open("YourApp") && board.read(status) && status.state == AutoUpdaterLib::UpdateState::Staged) {
+ *     showRestartHint(status.targetVersion);
+ * }
+ * ```
+ *
+ * The segment is guarded by a sequence lock. A writer makes the sequence
+ * odd, stores the record and makes it even again; a reader copies the
+ * record and retries if the sequence was odd or changed meanwhile. Readers
+ * never block writers. Every field is an atomic word, so a torn copy is
+ * detected and discarded rather than being undefined behaviour.
+ *
+ * Writers, e.g. two updater processes publishing to one board, take a
+ * named mutex around each record. A writer that dies mid-record abandons
+ * the mutex with the sequence odd. The next writer keeps it odd, writes a
+ * whole record over the torn one and only then makes the sequence even, so
+ * the sequence never goes backwards and a torn record is never accepted. A
+ * writer that cannot get the mutex within WRITER_WAIT_MS skips its record.
+ *
+ * @segment_format
+ * ```
+ * u32 sequence, u32 reserved
+ * u64 record[13]: state | writerProcessId << 32, downloadedBytes, totalBytes,
+ *                 lastCheckUnixMs, updatedUnixMs, currentVersion[32 bytes],
+ *                 targetVersion[32 bytes]
+ * ```
+ * Versions longer than 31 bytes are truncated. The segment lives while any
+ * process has it mapped; an all-zero segment reads as UpdateState::Unknown.
+ */
+
+#ifndef AUTO_UPDATER_STATUS_BOARD_H
+#define AUTO_UPDATER_STATUS_BOARD_H
+
+#include <windows.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+
+namespace AutoUpdaterLib {
+
+/**
+ * @brief Stage of the update cycle
+ */
+enum class UpdateState : uint32_t {
+    Unknown = 0,   ///< Nothing published yet
+    Idle,          ///< Between checks
+    Checking,      ///< Fetching the manifest
+    UpToDate,      ///< The last check found no newer version
+    Pending,       ///< A newer version waits for the download window
+    Downloading,   ///< Downloading the target version
+    Staged,        ///< Downloaded and verified; waiting for a restart window
+    Installing,    ///< Installing; the application restarts next
+    Failed         ///< The last check or download failed
+};
+
+/**
+ * @struct UpdateStatus
+ * @brief One consistent copy of the published state
+ */
+struct UpdateStatus {
+    UpdateState state = UpdateState::Unknown;
+    uint32_t writerProcessId = 0;
+    uint64_t downloadedBytes = 0;
+    uint64_t totalBytes = 0;       ///< 0 when the download size is unknown
+    uint64_t lastCheckUnixMs = 0;  ///< When the last check finished, 0 if none has
+    uint64_t updatedUnixMs = 0;    ///< When the record was last written
+    std::string currentVersion;
+    std::string targetVersion;     ///< Version found, downloading or staged
+};
+
+/**
+ * @class StatusBoard
+ * @brief Writer or reader view of a named status segment
+ */
+class StatusBoard {
+public:
+    static constexpr size_t VERSION_SIZE = 32;
+    static constexpr size_t RECORD_WORDS = 5 + 2 * VERSION_SIZE / 8;
+    static constexpr int READ_ATTEMPTS = 1000;
+    static constexpr DWORD WRITER_WAIT_MS = 1000;
+
+    StatusBoard() = default;
+
+    ~StatusBoard() {
+        close();
+    }
+
+    StatusBoard(const StatusBoard&) = delete;
+    StatusBoard& operator=(const StatusBoard&) = delete;
+
+    /**
+     * @brief Creates or opens the segment for publishing
+     * @param name Board name shared by writer and readers, e.g. the product name
+     * @return true if the segment is mapped for writing
+     */
+    bool create(const std::string& name) {
+        close();
+        m_writerMutex = CreateMutexA(nullptr, FALSE, (objectName(name) + ".writer").c_str());
+        if (!m_writerMutex) {
+            return false;
+        }
+        m_mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0,
+                                       static_cast<DWORD>(sizeof(Segment)), objectName(name).c_str());
+        if (!m_mapping) {
+            close();
+            return false;
+        }
+        return mapView(FILE_MAP_READ | FILE_MAP_WRITE);
+    }
+
+    /**
+     * @brief Opens an existing segment for reading
+     * @param name Board name passed to create()
+     * @return false if no updater has created the board
+     */
+    bool open(const std::string& name) {
+        close();
+        m_mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, objectName(name).c_str());
+        return m_mapping && mapView(FILE_MAP_READ);
+    }
+
+    void close() {
+        if (m_segment) {
+            UnmapViewOfFile(m_segment);
+        }
+        if (m_mapping) {
+            CloseHandle(m_mapping);
+        }
+        if (m_writerMutex) {
+            CloseHandle(m_writerMutex);
+        }
+        m_segment = nullptr;
+        m_mapping = nullptr;
+        m_writerMutex = nullptr;
+    }
+
+    bool isOpen() const { return m_segment != nullptr; }
+
+    /**
+     * @brief Writes a new record
+     * @param status State to publish; updatedUnixMs and writerProcessId are filled in
+     * @return false if the board is not open for writing or another writer held it too long
+     */
+    bool publish(const UpdateStatus& status) {
+        if (!m_segment || !m_writerMutex) {
+            return false;
+        }
+        uint64_t words[RECORD_WORDS];
+        UpdateStatus stamped = status;
+        stamped.updatedUnixMs = unixTimeMs();
+        stamped.writerProcessId = GetCurrentProcessId();
+        encode(stamped, words);
+
+        // WAIT_ABANDONED also grants the mutex: the previous writer died, possibly mid-record
+        const DWORD wait = WaitForSingleObject(m_writerMutex, WRITER_WAIT_MS);
+        if (wait != WAIT_OBJECT_0 && wait != WAIT_ABANDONED) {
+            return false;
+        }
+        // An odd sequence left by a dead writer stays odd until this record is whole
+        uint32_t sequence = m_segment->sequence.load(std::memory_order_relaxed);
+        if ((sequence & 1) == 0) {
+            m_segment->sequence.store(++sequence, std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < RECORD_WORDS; ++i) {
+            m_segment->record[i].store(words[i], std::memory_order_relaxed);
+        }
+        m_segment->sequence.store(sequence + 1, std::memory_order_release);
+        ReleaseMutex(m_writerMutex);
+        return true;
+    }
+
+    /**
+     * @brief Copies the current record without blocking the writer
+     * @param status Receives the record
+     * @return false if the board is not open or no consistent copy could be taken
+     */
+    bool read(UpdateStatus& status) const {
+        if (!m_segment) {
+            return false;
+        }
+        uint64_t words[RECORD_WORDS];
+        for (int attempt = 0; attempt < READ_ATTEMPTS; ++attempt) {
+            const uint32_t before = m_segment->sequence.load(std::memory_order_acquire);
+            if (before & 1) {
+                std::this_thread::yield();
+                continue;
+            }
+            for (size_t i = 0; i < RECORD_WORDS; ++i) {
+                words[i] = m_segment->record[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (m_segment->sequence.load(std::memory_order_relaxed) == before) {
+                decode(words, status);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Gets the current time in milliseconds since 1970
+     */
+    static uint64_t unixTimeMs() {
+        FILETIME now;
+        GetSystemTimeAsFileTime(&now);
+        const uint64_t ticks = (static_cast<uint64_t>(now.dwHighDateTime) << 32) | now.dwLowDateTime;
+        return (ticks - 116444736000000000ULL) / 10000; // FILETIME counts 100 ns from 1601
+    }
+
+private:
+    struct Segment {
+        std::atomic<uint32_t> sequence;
+        uint32_t reserved;
+        std::atomic<uint64_t> record[RECORD_WORDS];
+    };
+
+    HANDLE m_mapping = nullptr;
+    HANDLE m_writerMutex = nullptr;   // Only held by boards opened with create()
+    Segment* m_segment = nullptr;
+
+    static std::string objectName(const std::string& name) {
+        std::string result = "Local\\AutoUpdaterStatus1.";
+        for (char c : name) {
+            result += c == '\\' ? '_' : c;
+        }
+        return result;
+    }
+
+    bool mapView(DWORD access) {
+        m_segment = static_cast<Segment*>(MapViewOfFile(m_mapping, access, 0, 0, sizeof(Segment)));
+        if (!m_segment) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    static void packVersion(const std::string& version, uint64_t* words) {
+        char text[VERSION_SIZE] = {};
+        std::memcpy(text, version.data(), std::min(version.size(), static_cast<size_t>(VERSION_SIZE - 1)));
+        std::memcpy(words, text, sizeof(text));
+    }
+
+    static std::string unpackVersion(const uint64_t* words) {
+        char text[VERSION_SIZE];
+        std::memcpy(text, words, sizeof(text));
+        text[VERSION_SIZE - 1] = '\0';
+        return std::string(text);
+    }
+
+    static void encode(const UpdateStatus& status, uint64_t words[RECORD_WORDS]) {
+        words[0] = static_cast<uint64_t>(status.state) | (static_cast<uint64_t>(status.writerProcessId) << 32);
+        words[1] = status.downloadedBytes;
+        words[2] = status.totalBytes;
+        words[3] = status.lastCheckUnixMs;
+        words[4] = status.updatedUnixMs;
+        packVersion(status.currentVersion, words + 5);
+        packVersion(status.targetVersion, words + 5 + VERSION_SIZE / 8);
+    }
+
+    static void decode(const uint64_t words[RECORD_WORDS], UpdateStatus& status) {
+        const uint32_t state = static_cast<uint32_t>(words[0]);
+        status.state = state <= static_cast<uint32_t>(UpdateState::Failed) ? static_cast<UpdateState>(state)
+                                                                          : UpdateState::Unknown;
+        status.writerProcessId = static_cast<uint32_t>(words[0] >> 32);
+        status.downloadedBytes = words[1];
+        status.totalBytes = words[2];
+        status.lastCheckUnixMs = words[3];
+        status.updatedUnixMs = words[4];
+        status.currentVersion = unpackVersion(words + 5);
+        status.targetVersion = unpackVersion(words + 5 + VERSION_SIZE / 8);
+    }
+};
+
+} // namespace AutoUpdaterLib
+
+#endif // AUTO_UPDATER_STATUS_BOARD_H
@@ -17,7 +17,7 @@
  * 
  * @dependencies
  * - nlohmann/json library
- * - Windows API (wininet.lib, shell32.lib)
+ * - Windows API (wininet.lib, shell32.lib, psapi.lib)
  * - C++11 or later
  * 
  * @usage
@@ -40,27 +40,66 @@
  * ```json
  * {
  *     "UpdateLink": "https://example.com/app_v2.0.exe",
- *     "AppVersion": "2.0.0"
+ *     "AppVersion": "2.0.0",
+ *     "Digest": "blake3:<64 hex digits>"
  * }
  * ```
+ * `Digest` is optional; when present the download is verified before it is
+ * applied. BLAKE3 digests of large payloads are verified on all cores.
+ * Manifests may also offer intermediate images and patches (see Manifest.h);
+ * the updater then downloads the cheapest chain to the latest version.
+ * Setting `"Package": "zip"` ships the whole application directory as a zip
+ * archive, which is extracted while it downloads.
+ *
+ * Files are installed through a write-ahead journal (see Journal.h), so an
+ * update interrupted by a crash or power loss is finished or undone from
+ * local data the next time the application checks for updates.
+ *
+ * Long-running applications can call pollForUpdates() instead of checking
+ * once. Checks are spread with jitter, back off after failures, and repeat
+ * manifest requests are conditional, so an unchanged manifest costs a 304.
  */
 
 #ifndef AUTO_UPDATER_H
 #define AUTO_UPDATER_H
 
+#include <algorithm>
+#include <cctype>
+#include <cstring>
 #include <iostream>
+#include <mutex>
 #include <string>
 #include <fstream>
+#include <set>
+#include <functional>
 #include <sstream>
 #include <stdexcept>
 #include <windows.h>
 #include <wininet.h>
 #include <shlobj.h>
 #include <process.h>
+#include <psapi.h>
 #include "json.hpp" // nlohmann::json library
+#include "Archive.h"
+#include "Blake3.h"
+#include "Bundle.h"
+#include "Canary.h"
+#include "Connection.h"
+#include "CostModel.h"
+#include "Download.h"
+#include "Durability.h"
+#include "Journal.h"
+#include "Maintenance.h"
+#include "Manifest.h"
+#include "MemoryProfile.h"
+#include "Patch.h"
+#include "Schedule.h"
+#include "Snapshot.h"
+#include "StatusBoard.h"
 
 #pragma comment(lib, "wininet.lib")
 #pragma comment(lib, "shell32.lib")
+#pragma comment(lib, "psapi.lib")
 
 namespace AutoUpdaterLib {
 
@@ -73,188 +112,1430 @@ private:
     std::string m_updateUrl;
     std::string m_currentVersion;
     std::string m_tempDirectory;
+    bool m_keepRollback = true;
+    UpdateManifest m_manifest;            // Last fetched manifest
+    bool m_haveManifest = false;
+    UpdateManifest m_installedManifest;   // Manifest of m_currentVersion, used by ensureAsset()
+    bool m_haveInstalledManifest = false;
+    ConditionalRequest m_conditional;     // Validators of m_manifest
+    std::set<std::string> m_ensuredAssets;
+    std::mutex m_assetMutex;
+    bool m_lastCheckFailed = false;
+    uint64_t m_retryAfterMs = 0;
+    ApplyPolicy m_applyPolicy;            // When a staged update may restart the application
+    WindowPolicy m_windows;               // When updates may download, use full bandwidth and restart
+    std::string m_pendingVersion;         // Update found outside the maintenance windows
+    bool m_deferredPending = false;       // Deferred files left for the download window
+    mutable std::mutex m_pendingMutex;
+    CanaryPolicy m_canary;                // Performance check of a new version after the restart
+    mutable std::mutex m_historyMutex;    // Serialises updates of the performance history
+    std::string m_readyVersion;           // Version that called markReady(), awaiting its steady-state sample
+    uint64_t m_readyTick = 0;
+    mutable StatusBoard m_statusBoard;    // Shared-memory view of m_status for other processes
+    mutable UpdateStatus m_status;
+    mutable std::mutex m_statusMutex;
+    Durability m_durability = Durability::FlushAtEnd; // How staged files reach stable storage
     
-    static constexpr const char* USER_AGENT = "AutoUpdater/2.0";
     static constexpr DWORD BUFFER_SIZE = 8192;
     static constexpr DWORD TIMEOUT_MS = 30000; // 30 seconds
+    static constexpr uint64_t SEGMENTED_DOWNLOAD_THRESHOLD = 4 * 1024 * 1024; // Smaller downloads use one request
+    static constexpr size_t ARCHIVE_MEMORY_BUDGET = 64 * 1024 * 1024; // Compressed bytes queued for workers
+    static constexpr DWORD POLL_SLICE_MS = 1000; // How often pollForUpdates() asks whether to keep running
+    static constexpr uint64_t STEADY_STATE_DELAY_MS = 5 * 60 * 1000; // Ready to steady-state memory sample
 
     /**
-     * @brief Downloads a file from the specified URL to local filesystem
+     * @brief Streams the body of a URL to a callback
      * @param url The URL to download from
-     * @param filepath The local path where the file should be saved
-     * @return true if download successful, false otherwise
+     * @param sink Receives each block of data; returning false aborts the download
+     * @param conditional Makes the request conditional and records the response, or nullptr
+     * @return true if the whole body was received and accepted, or the
+     *         conditional request was answered with 304 Not Modified
      */
-    bool downloadFile(const std::string& url, const std::string& filepath) const {
-        HINTERNET hInternet = InternetOpenA(
-            USER_AGENT, 
-            INTERNET_OPEN_TYPE_DIRECT, 
-            nullptr, 
-            nullptr, 
-            0
-        );
-        
-        if (!hInternet) {
-            logError("Failed to initialize internet connection");
-            return false;
-        }
-
-        HINTERNET hUrl = InternetOpenUrlA(
-            hInternet, 
-            url.c_str(), 
-            nullptr, 
-            0, 
-            INTERNET_FLAG_RELOAD | INTERNET_FLAG_NO_CACHE_WRITE, 
-            0
-        );
-        
+    bool downloadStream(const std::string& url, const std::function<bool(const char*, size_t)>& sink,
+                        ConditionalRequest* conditional = nullptr) const {
+        HINTERNET hUrl = InternetSession::instance().openUrl(url, conditional ? conditional->headers() : std::string());
         if (!hUrl) {
             logError("Failed to open URL: " + url);
-            InternetCloseHandle(hInternet);
             return false;
         }
 
-        std::ofstream file(filepath, std::ios::binary);
-        if (!file.is_open()) {
-            logError("Failed to create file: " + filepath);
+        DWORD status = 0;
+        DWORD length = sizeof(status);
+        HttpQueryInfoA(hUrl, HTTP_QUERY_STATUS_CODE | HTTP_QUERY_FLAG_NUMBER, &status, &length, nullptr);
+        if (conditional) {
+            conditional->received(status, queryHeader(hUrl, HTTP_QUERY_ETAG),
+                                  queryHeader(hUrl, HTTP_QUERY_LAST_MODIFIED), queryHeader(hUrl, HTTP_QUERY_RETRY_AFTER));
+            if (conditional->notModified()) {
+                InternetCloseHandle(hUrl);
+                return true;
+            }
+        }
+        if (status >= 400) {
+            logError("Server returned HTTP " + std::to_string(status) + " for " + url);
             InternetCloseHandle(hUrl);
-            InternetCloseHandle(hInternet);
             return false;
         }
 
         char buffer[BUFFER_SIZE];
         DWORD bytesRead = 0;
         bool success = true;
+        const uint64_t rateLimit = downloadRateLimit();
+        const uint64_t started = GetTickCount64();
+        uint64_t received = 0;
 
-        while (InternetReadFile(hUrl, buffer, sizeof(buffer), &bytesRead) && bytesRead > 0) {
-            file.write(buffer, bytesRead);
-            if (file.fail()) {
-                logError("Failed to write to file: " + filepath);
+        for (;;) {
+            if (!InternetReadFile(hUrl, buffer, sizeof(buffer), &bytesRead)) {
+                logError("Failed to read from URL: " + url);
+                success = false;
+                break;
+            }
+            if (bytesRead == 0) {
+                break;
+            }
+            if (!sink(buffer, bytesRead)) {
                 success = false;
                 break;
             }
+            addDownloadProgress(bytesRead);
+            if (rateLimit > 0) {
+                // Pace reads so the average rate stays at the limit
+                received += bytesRead;
+                const uint64_t due = received * 1000 / rateLimit;
+                const uint64_t elapsed = GetTickCount64() - started;
+                if (due > elapsed) {
+                    Sleep(static_cast<DWORD>(due - elapsed));
+                }
+            }
         }
 
-        file.close();
         InternetCloseHandle(hUrl);
-        InternetCloseHandle(hInternet);
         
         return success;
     }
 
     /**
-     * @brief Retrieves and parses JSON data from the update server
-     * @param jsonUrl The URL containing version information
-     * @return Parsed JSON object, or empty object if failed
+     * @brief Notes the version being left so runCanary() can compare against it after the restart
+     */
+    void recordCanaryPending(const std::string& newVersion) const {
+        if (!m_canary.measure || !m_keepRollback) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(m_historyMutex);
+        PerformanceHistory history(performanceHistoryPath());
+        history.setPending(m_currentVersion, newVersion);
+        if (!history.save()) {
+            logError("Failed to record the update for the performance canary");
+        }
+    }
+
+    bool steadyStateDue(uint64_t now) const {
+        std::lock_guard<std::mutex> lock(m_historyMutex);
+        return !m_readyVersion.empty() && now - m_readyTick >= STEADY_STATE_DELAY_MS;
+    }
+
+    std::string performanceHistoryPath() const {
+        return m_tempDirectory + "\\app_update_performance.dat";
+    }
+
+    std::string installedManifestPath() const {
+        return m_tempDirectory + "\\app_update_installed.bin";
+    }
+
+    /**
+     * @brief Records the manifest of a release that was just installed
+     *
+     * The installed release is later resolved against this copy, since the
+     * server lists only the latest release.
+     */
+    void recordInstalledManifest(const UpdateManifest& manifest) const {
+        std::ostringstream out;
+        manifest.toBinary(out);
+        const std::string data = out.str();
+        StagingFile file(Durability::Ordered);
+        if (!file.open(installedManifestPath()) || !file.write(data.data(), data.size()) || !file.commit()) {
+            logError("Failed to record the manifest of " + manifest.version);
+        }
+    }
+
+    /**
+     * @brief Records a manifest for the installed version if the install matches it
+     * @return true if it was recorded
+     *
+     * For installs the updater did not perform, e.g. a fresh install. A
+     * matching version string is not enough: every launch file except the
+     * executable, which reports the version, must match its size and
+     * digest. Deferred and lazy files may still be missing.
+     */
+    bool adoptInstalledManifest(const UpdateManifest& manifest) const {
+        if (m_currentVersion.empty() || manifest.version != m_currentVersion) {
+            return false;
+        }
+        const std::string currentExePath = getCurrentExecutablePath();
+        const std::string installDir = currentExePath.substr(0, currentExePath.find_last_of("\\/"));
+        const std::string exeName = RollbackSnapshot::normalise(extractFileName(currentExePath));
+        bool matches = true;
+        const bool listed = manifest.forEachFile([&](const FileEntry& file) {
+            const std::string relative = localRelativePath(file.path);
+            if ((file.flags & (FileEntry::FLAG_DEFERRED | FileEntry::FLAG_LAZY)) != 0 ||
+                (!relative.empty() && RollbackSnapshot::normalise(relative) == exeName)) {
+                return true;
+            }
+            matches = !relative.empty() && isInstalled(installDir + "\\" + relative, file, true);
+            return matches;
+        });
+        if (!listed || !matches) {
+            logInfo("Installed files do not match the manifest for " + manifest.version + "; it is not recorded");
+            return false;
+        }
+        recordInstalledManifest(manifest);
+        return true;
+    }
+
+    /**
+     * @brief Loads the manifest recorded for the installed version
+     * @param spoolName File in the temp directory that holds its file list
+     *                  in the bounded-memory build; one per long-lived copy
+     * @return false if none was recorded for m_currentVersion
+     */
+    bool loadInstalledManifest(UpdateManifest& manifest, const std::string& spoolName) const {
+        std::ifstream in(installedManifestPath(), std::ios::binary);
+        const std::string spoolPath = MemoryProfile::BOUNDED ? m_tempDirectory + "\\" + spoolName : std::string();
+        UpdateManifest recorded;
+        std::string error;
+        if (!in || !UpdateManifest::fromBinary(in, recorded, error, MemoryProfile::MANIFEST_BUDGET, spoolPath) ||
+            m_currentVersion.empty() || recorded.version != m_currentVersion) {
+            return false;
+        }
+        manifest = recorded;
+        return true;
+    }
+
+    /**
+     * @brief Gets the current local time for the maintenance windows
+     */
+    static std::tm localTime() {
+        SYSTEMTIME now;
+        GetLocalTime(&now);
+        std::tm local = std::tm();
+        local.tm_min = now.wMinute;
+        local.tm_hour = now.wHour;
+        local.tm_mday = now.wDay;
+        local.tm_mon = now.wMonth - 1;
+        local.tm_year = now.wYear - 1900;
+        local.tm_wday = now.wDayOfWeek;
+        return local;
+    }
+
+    /**
+     * @brief Gets the download rate allowed right now
+     * @return Bytes per second, or 0 inside the full-bandwidth window
+     */
+    uint64_t downloadRateLimit() const {
+        return m_windows.fullBandwidth.contains(localTime()) ? 0 : m_windows.throttledBytesPerSecond;
+    }
+
+    /**
+     * @brief Reads a response header
+     * @return Header value, or an empty string if it is absent
+     */
+    static std::string queryHeader(HINTERNET request, DWORD header) {
+        char value[256];
+        DWORD length = sizeof(value);
+        if (!HttpQueryInfoA(request, header, value, &length, nullptr)) {
+            return std::string();
+        }
+        return std::string(value, length);
+    }
+
+    /**
+     * @brief Downloads a file from the specified URL to local filesystem
+     * @param url The URL to download from
+     * @param filepath The local path where the file should be saved
+     * @return true if download successful, false otherwise
+     *
+     * The file is flushed as m_durability requires; a failed download is deleted.
+     */
+    bool downloadFile(const std::string& url, const std::string& filepath) const {
+        StagingFile file(m_durability);
+        if (!file.open(filepath)) {
+            logError("Failed to create file: " + filepath);
+            return false;
+        }
+
+        const bool success = downloadStream(url, [&](const char* data, size_t length) {
+            if (!file.write(data, length)) {
+                logError("Failed to write to file: " + filepath);
+                return false;
+            }
+            return true;
+        });
+
+        if (!success) {
+            file.abort();
+            return false;
+        }
+        if (!file.commit()) {
+            logError("Failed to flush file: " + filepath);
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Downloads an image or patch, resuming an earlier interrupted attempt
+     * @param artifact Artifact to download
+     * @param manifest Manifest whose chunk index may describe the artifact
+     * @param filepath Destination file
+     * @return true if the whole artifact is on disk
+     *
+     * Artifacts of known size above SEGMENTED_DOWNLOAD_THRESHOLD are fetched as
+     * parallel ranges with a checkpoint sidecar. When the manifest lists a
+     * file with the same digest, its chunks are used as verified segments.
+     * The bounded-memory build, and any download outside the full-bandwidth
+     * window, uses one request.
+     */
+    bool downloadArtifact(const UpdateArtifact& artifact, const UpdateManifest& manifest, const std::string& filepath) const {
+        if (!usesRanges(artifact)) {
+            return downloadFile(artifact.link, filepath);
+        }
+
+        const std::vector<SegmentedDownloader::Segment> segments = artifactSegments(artifact, manifest);
+        SegmentedDownloader downloader;
+        downloader.setDurability(m_durability);
+        downloader.setTuningFile(mirrorTuningPath());
+        downloader.setProgress([this](uint64_t bytes) { addDownloadProgress(bytes); });
+        if (downloader.download(artifact.link, filepath, segments, artifactIdentity(artifact))) {
+            logInfo("Ranged download finished with " + std::to_string(downloader.connections()) + " connection(s)");
+            if (downloader.resumedSegments() > 0) {
+                logInfo("Resumed download: " + std::to_string(downloader.resumedSegments()) + " of " +
+                        std::to_string(segments.size()) + " segment(s) were already complete");
+            }
+            return true;
+        }
+
+        if (downloader.rangeUnsupported()) {
+            logInfo("Server does not support ranged downloads; downloading in one piece");
+            DeleteFileA((RangedFile::writePath(filepath, m_durability) + ".ckpt").c_str());
+            return downloadFile(artifact.link, filepath);
+        }
+        logError(downloader.lastError());
+        return false;
+    }
+
+    /**
+     * @brief Checks whether downloadArtifact() fetches an artifact as parallel ranges
+     */
+    bool usesRanges(const UpdateArtifact& artifact) const {
+        return !MemoryProfile::BOUNDED && downloadRateLimit() == 0 && artifact.size != UpdateArtifact::UNKNOWN_SIZE &&
+               artifact.size >= SEGMENTED_DOWNLOAD_THRESHOLD;
+    }
+
+    /**
+     * @brief Splits an artifact into download segments
+     *
+     * When the manifest lists a file with the same digest, its chunks are
+     * used as verified segments; otherwise fixed-size segments.
+     */
+    static std::vector<SegmentedDownloader::Segment> artifactSegments(const UpdateArtifact& artifact, const UpdateManifest& manifest) {
+        std::vector<SegmentedDownloader::Segment> segments;
+        manifest.forEachFile([&](const FileEntry& file) {
+            if (!artifact.digest.empty() && file.digest == artifact.digest && file.size == artifact.size && !file.chunks.empty()) {
+                segments = SegmentedDownloader::chunkSegments(file.chunks);
+                return false;
+            }
+            return true;
+        });
+        if (segments.empty() || segments.back().offset + segments.back().size != artifact.size) {
+            segments = SegmentedDownloader::fixedSegments(artifact.size);
+        }
+        return segments;
+    }
+
+    static std::string artifactIdentity(const UpdateArtifact& artifact) {
+        return artifact.link + "\n" + std::to_string(artifact.size) + "\n" + artifact.digest;
+    }
+
+    /**
+     * @brief Gets the download path of an artifact
+     *
+     * The name derives from the artifact rather than its position in the
+     * route, so an interrupted download resumes even if the next check plans
+     * a different route through it.
+     */
+    std::string artifactPath(const UpdateArtifact& artifact) const {
+        Blake3 hasher;
+        const std::string identity = artifactIdentity(artifact);
+        hasher.update(identity.data(), identity.size());
+        return m_tempDirectory + "\\app_update_" + hasher.hexDigest().substr(0, 16) +
+               (artifact.kind == UpdateArtifact::Kind::Patch ? ".patch" : ".exe");
+    }
+
+    /**
+     * @brief Gets the download path of a release file staged by stageFiles()
+     *
+     * Like artifactPath(), the name derives from the file's link, size and
+     * digest, so partial downloads and their checkpoints survive a failed
+     * attempt and the next one resumes them.
+     */
+    std::string fileDownloadPath(const UpdateArtifact& artifact) const {
+        Blake3 hasher;
+        const std::string identity = artifactIdentity(artifact);
+        hasher.update(identity.data(), identity.size());
+        return m_tempDirectory + "\\app_file_" + hasher.hexDigest().substr(0, 16) + ".tmp";
+    }
+
+    std::string mirrorTuningPath() const {
+        return m_tempDirectory + "\\app_update_mirrors.dat";
+    }
+
+    /**
+     * @brief Builds the cost model for a manifest from learned mirror throughput and local state
+     * @param manifest Manifest whose artifacts are costed
+     *
+     * Reads only: the mirror tuning file, download checkpoints and the
+     * sizes of installed release files.
+     */
+    CostModel costModel(const UpdateManifest& manifest) const {
+        CostModel model;
+        const bool ranges = !MemoryProfile::BOUNDED && downloadRateLimit() == 0;
+        model.setSegmentThreshold(ranges ? static_cast<uint64_t>(SEGMENTED_DOWNLOAD_THRESHOLD) : UINT64_MAX);
+        model.setRateLimit(downloadRateLimit());
+
+        const MirrorTuning tuning(mirrorTuningPath());
+        for (const auto& artifact : manifest.artifacts) {
+            const std::string host = MirrorTuning::hostOf(artifact.link);
+            const uint64_t resumed = usesRanges(artifact)
+                ? SegmentedDownloader::resumableBytes(artifactPath(artifact), artifactSegments(artifact, manifest),
+                                                      artifactIdentity(artifact), m_durability)
+                : 0;
+            model.setSource(artifact.link, tuning.bytesPerSecond(host),
+                            tuning.connections(host, SegmentedDownloader::INITIAL_CONNECTIONS), resumed);
+        }
+
+        // Release files a package would replace; lazy files are only kept current once fetched
+        const std::string currentExePath = getCurrentExecutablePath();
+        const std::string installDir = currentExePath.substr(0, currentExePath.find_last_of("\\/"));
+        const std::string exeName = RollbackSnapshot::normalise(extractFileName(currentExePath));
+        uint64_t releaseBytes = 0;
+        size_t releaseFiles = 0;
+        manifest.forEachFile([&](const FileEntry& file) {
+            const std::string relative = localRelativePath(file.path);
+            if (relative.empty() || (file.flags & FileEntry::FLAG_LAZY) != 0 ||
+                RollbackSnapshot::normalise(relative) == exeName || isInstalled(installDir + "\\" + relative, file, false)) {
+                return true;
+            }
+            // One file without a size makes the total unknown, as a route step would
+            releaseBytes = file.size == UpdateArtifact::UNKNOWN_SIZE ? UpdateArtifact::UNKNOWN_SIZE
+                                                                     : UpdatePlanner::saturatingAdd(releaseBytes, file.size);
+            ++releaseFiles;
+            return true;
+        });
+        model.setReleaseFiles(releaseBytes, releaseFiles);
+        return model;
+    }
+
+    /**
+     * @brief Downloads a zip package and extracts it while it downloads
+     * @param artifact Full image whose package is "zip"
+     * @param stagingDir Directory that receives the extracted application
+     * @return true if the archive was extracted completely and matches its digest
+     *
+     * Deflated entries are decompressed on a worker pool in parallel with the
+     * download. Nothing outside the staging directory is touched, so a digest
+     * mismatch only costs the staging directory.
+     */
+    bool downloadArchive(const UpdateArtifact& artifact, const std::string& stagingDir) const {
+        std::string expected;
+        if (!artifact.digest.empty() && !parseDigest(artifact.digest, expected)) {
+            return false;
+        }
+
+        removeDirectoryTree(stagingDir);
+        if (!CreateDirectoryA(stagingDir.c_str(), nullptr)) {
+            logError("Failed to create staging directory: " + stagingDir);
+            return false;
+        }
+
+        WorkerPool pool(MemoryProfile::BOUNDED ? 1 : 0, ARCHIVE_MEMORY_BUDGET);
+        Blake3 hasher;
+        bool success = false;
+        {
+            ZipStreamExtractor extractor(stagingDir, pool);
+            success = downloadStream(artifact.link, [&](const char* data, size_t length) {
+                hasher.update(data, length);
+                return extractor.feed(reinterpret_cast<const uint8_t*>(data), length);
+            });
+            success = extractor.finish() && success;
+            if (!success && !extractor.lastError().empty()) {
+                logError("Archive extraction failed: " + extractor.lastError());
+            }
+        }
+
+        if (success && !expected.empty() && hasher.hexDigest() != expected) {
+            logError("Digest mismatch for " + artifact.link + " (expected " + expected + ", got " + hasher.hexDigest() + ")");
+            success = false;
+        }
+
+        if (!success) {
+            removeDirectoryTree(stagingDir);
+        }
+        return success;
+    }
+
+    /**
+     * @brief Deletes a directory and everything below it
+     * @param path Directory to remove; missing directories are ignored
+     */
+    void removeDirectoryTree(const std::string& path) const {
+        RollbackSnapshot::removeTree(path);
+    }
+
+    /**
+     * @brief Splits a manifest digest and checks its algorithm is supported
+     * @param digest Digest in "algorithm:hex" form, e.g. "blake3:af13..."
+     * @param expectedHex Receives the lowercase hex value
+     * @return true if the digest is well-formed and supported
+     */
+    bool parseDigest(const std::string& digest, std::string& expectedHex) const {
+        const size_t separator = digest.find(':');
+        if (separator == std::string::npos) {
+            logError("Malformed digest: " + digest);
+            return false;
+        }
+
+        std::string algorithm = digest.substr(0, separator);
+        expectedHex = digest.substr(separator + 1);
+        for (auto& c : algorithm) c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+        for (auto& c : expectedHex) c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+
+        if (algorithm != "blake3") {
+            logError("Unsupported digest algorithm: " + algorithm);
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Verifies a downloaded file against a manifest digest
+     * @param filepath The file to verify
+     * @param digest Expected digest in "algorithm:hex" form, e.g. "blake3:af13..."
+     * @return true if the file matches, false on mismatch or unsupported algorithm
+     */
+    bool verifyDigest(const std::string& filepath, const std::string& digest) const {
+        std::string expected;
+        if (!parseDigest(digest, expected)) {
+            return false;
+        }
+
+        const std::string actual = Blake3::hashFile(filepath);
+        if (actual.empty()) {
+            logError("Failed to read file for verification: " + filepath);
+            return false;
+        }
+        if (actual != expected) {
+            logError("Digest mismatch for " + filepath + " (expected " + expected + ", got " + actual + ")");
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Retrieves and parses the update manifest from the server
+     * @param manifestUrl The URL containing version information
+     * @param manifest Receives the parsed manifest
+     * @param conditional Validators of a manifest fetched earlier, or nullptr;
+     *                    when the server answers 304, manifest is left untouched
+     * @return true if a valid manifest was retrieved or the manifest is unchanged
+     *
+     * Accepts both the JSON manifest and its binary "AUMANIF1" form.
+     */
+    bool fetchManifest(const std::string& manifestUrl, UpdateManifest& manifest,
+                       ConditionalRequest* conditional = nullptr) const {
+        if (MemoryProfile::BOUNDED) {
+            return fetchManifestSpooled(manifestUrl, manifest, conditional);
+        }
+
+        std::string body;
+        if (!downloadStream(manifestUrl, [&body](const char* data, size_t size) {
+                body.append(data, size);
+                return true;
+            }, conditional)) {
+            return false;
+        }
+        if (conditional && conditional->notModified()) {
+            return true;
+        }
+
+        std::string parseError;
+        bool parsed = false;
+        try {
+            const bool isBinary = body.size() >= UpdateManifest::BINARY_MAGIC_SIZE &&
+                                  memcmp(body.data(), UpdateManifest::BINARY_MAGIC, UpdateManifest::BINARY_MAGIC_SIZE) == 0;
+            if (isBinary) {
+                std::istringstream stream(body);
+                parsed = UpdateManifest::fromBinary(stream, manifest, parseError);
+            } else {
+                parsed = UpdateManifest::fromJson(nlohmann::json::parse(body), manifest, parseError);
+            }
+        } catch (const std::exception& e) {
+            parseError = "JSON parsing error: " + std::string(e.what());
+        }
+
+        if (!parsed) {
+            logError(parseError.empty() ? "Invalid or missing version information from server" : parseError);
+            if (conditional) {
+                conditional->reset();
+            }
+        }
+        return parsed;
+    }
+
+    /**
+     * @brief fetchManifest() for the bounded-memory build
+     *
+     * The body is written to a temporary file and parsed from there as a
+     * stream within MemoryProfile::MANIFEST_BUDGET, so no copy of the
+     * document is held in memory. The file list is spooled to
+     * app_update_manifest_files.dat, which replaces the previous list only
+     * once the new document has parsed.
+     */
+    bool fetchManifestSpooled(const std::string& manifestUrl, UpdateManifest& manifest,
+                              ConditionalRequest* conditional) const {
+        const std::string spoolPath = m_tempDirectory + "\\app_update_manifest.tmp";
+        bool received = false;
+        {
+            std::ofstream spool(spoolPath, std::ios::binary | std::ios::trunc);
+            if (!spool.is_open()) {
+                logError("Failed to create file: " + spoolPath);
+                return false;
+            }
+            received = downloadStream(manifestUrl, [&spool](const char* data, size_t size) {
+                spool.write(data, static_cast<std::streamsize>(size));
+                return !spool.fail();
+            }, conditional);
+        }
+        if (!received || (conditional && conditional->notModified())) {
+            DeleteFileA(spoolPath.c_str());
+            return received;
+        }
+
+        const std::string filesPath = m_tempDirectory + "\\app_update_manifest_files.dat";
+        const std::string filesPartPath = filesPath + ".part";
+        std::string parseError;
+        bool parsed = false;
+        {
+            std::ifstream in(spoolPath, std::ios::binary);
+            char magic[UpdateManifest::BINARY_MAGIC_SIZE] = {};
+            in.read(magic, sizeof(magic));
+            const bool isBinary = in.gcount() == static_cast<std::streamsize>(sizeof(magic)) &&
+                                  memcmp(magic, UpdateManifest::BINARY_MAGIC, sizeof(magic)) == 0;
+            in.clear();
+            in.seekg(0);
+            parsed = isBinary ? UpdateManifest::fromBinary(in, manifest, parseError, MemoryProfile::MANIFEST_BUDGET, filesPartPath)
+                              : UpdateManifest::fromJsonStream(in, manifest, parseError, MemoryProfile::MANIFEST_BUDGET, filesPartPath);
+        }
+        DeleteFileA(spoolPath.c_str());
+        if (parsed && !MoveFileExA(filesPartPath.c_str(), filesPath.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+            parseError = "Failed to replace file: " + filesPath;
+            manifest = UpdateManifest();
+            parsed = false;
+        }
+        if (parsed) {
+            manifest.fileSpool = filesPath;
+        } else {
+            DeleteFileA(filesPartPath.c_str());
+        }
+
+        if (!parsed) {
+            logError(parseError);
+            if (conditional) {
+                conditional->reset();
+            }
+        }
+        return parsed;
+    }
+
+    /**
+     * @brief Downloads and applies the cheapest route to the manifest's version
+     * @param manifest Parsed update manifest
+     * @param imagePath Receives the path of the fully built new executable
+     * @param stagingDir Receives the extracted application directory when the
+     *                   route starts from a zip package, or stays empty
+     * @return true if the new executable was built and verified
+     */
+    bool applyRoute(const UpdateManifest& manifest, std::string& imagePath, std::string& stagingDir) const {
+        const UpdatePlan chosen = costModel(manifest).plan(manifest, m_currentVersion);
+        const std::vector<UpdateArtifact>& route = chosen.route;
+        if (route.empty()) {
+            logError("No update route from version " + m_currentVersion + " to " + manifest.version);
+            return false;
+        }
+
+        const uint64_t routeSize = UpdatePlanner::totalSize(route);
+        logInfo("Update route: " + std::string(UpdatePlan::strategyName(chosen.strategy)) + ", " +
+                std::to_string(route.size()) + " step(s), " +
+                (routeSize == UpdateArtifact::UNKNOWN_SIZE ? std::string("unknown size")
+                                                           : std::to_string(routeSize) + " bytes, about " +
+                                                             std::to_string((chosen.estimatedMs + 999) / 1000) + " s"));
+        publishStatus(UpdateState::Downloading, manifest.version, routeSize == UpdateArtifact::UNKNOWN_SIZE ? 0 : routeSize);
+
+        std::string basePath = getCurrentExecutablePath();
+        for (size_t i = 0; i < route.size(); ++i) {
+            const UpdateArtifact& step = route[i];
+            const bool isPatch = step.kind == UpdateArtifact::Kind::Patch;
+            const std::string stepPath = artifactPath(step);
+
+            if (!isPatch && step.package == "zip") {
+                logInfo("Downloading and extracting package " + step.toVersion);
+                stagingDir = m_tempDirectory + "\\app_update_staging";
+                if (!downloadArchive(step, stagingDir)) {
+                    stagingDir.clear();
+                    return false;
+                }
+                basePath = stagingDir + "\\" + extractFileName(getCurrentExecutablePath());
+                if (GetFileAttributesA(basePath.c_str()) == INVALID_FILE_ATTRIBUTES) {
+                    logError("Package does not contain " + extractFileName(basePath));
+                    removeDirectoryTree(stagingDir);
+                    stagingDir.clear();
+                    return false;
+                }
+                continue;
+            }
+
+            logInfo((isPatch ? "Downloading patch " + step.fromVersion + " -> " : std::string("Downloading full image ")) + step.toVersion);
+            if (!downloadArtifact(step, manifest, stepPath)) {
+                // Partial downloads are kept so the next attempt resumes them
+                discardIntermediate(basePath);
+                discardStaging(stagingDir);
+                return false;
+            }
+            if (!step.digest.empty() && !verifyDigest(stepPath, step.digest)) {
+                DeleteFileA(stepPath.c_str());
+                discardIntermediate(basePath);
+                discardStaging(stagingDir);
+                return false;
+            }
+
+            if (!isPatch) {
+                discardIntermediate(basePath);
+                basePath = stepPath;
+                continue;
+            }
+
+            const std::string patchedPath = m_tempDirectory + "\\app_update_" + std::to_string(i) + ".exe";
+            PatchApplier applier;
+            const bool patched = applier.apply(basePath, stepPath, patchedPath);
+            DeleteFileA(stepPath.c_str());
+            discardIntermediate(basePath);
+            if (!patched) {
+                logError("Failed to apply patch: " + applier.lastError());
+                DeleteFileA(patchedPath.c_str());
+                discardStaging(stagingDir);
+                return false;
+            }
+            basePath = patchedPath;
+        }
+
+        // A patch's digest covers the patch, so the patched result is checked separately.
+        // For packages the top-level digest covers the zip; the executable's own entry is used.
+        std::string targetDigest = manifest.digest;
+        if (!manifest.artifacts.front().package.empty()) {
+            targetDigest.clear();
+            const std::string exeFileName = extractFileName(getCurrentExecutablePath());
+            manifest.forEachFile([&](const FileEntry& file) {
+                if (file.path == exeFileName) {
+                    targetDigest = file.digest;
+                }
+                return true;
+            });
+        }
+        if (route.back().kind == UpdateArtifact::Kind::Patch && !targetDigest.empty()) {
+            logInfo("Verifying update integrity...");
+            if (!verifyDigest(basePath, targetDigest)) {
+                DeleteFileA(basePath.c_str());
+                discardStaging(stagingDir);
+                return false;
+            }
+        }
+
+        // Patches on top of a package rebuild its executable outside the staging directory
+        if (!stagingDir.empty()) {
+            const std::string stagedExe = stagingDir + "\\" + extractFileName(getCurrentExecutablePath());
+            if (basePath != stagedExe && !MoveFileExA(basePath.c_str(), stagedExe.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+                logError("Failed to stage patched executable: " + stagedExe);
+                DeleteFileA(basePath.c_str());
+                discardStaging(stagingDir);
+                return false;
+            }
+            basePath = stagedExe;
+        }
+
+        imagePath = basePath;
+        return true;
+    }
+
+    /**
+     * @brief Deletes an intermediate build produced while walking an update route
+     * @param path Intermediate file; the running executable is never deleted
+     */
+    void discardIntermediate(const std::string& path) const {
+        if (path.compare(0, m_tempDirectory.size(), m_tempDirectory) == 0) {
+            DeleteFileA(path.c_str());
+        }
+    }
+
+    /**
+     * @brief Removes a staging directory left by a failed route
+     * @param stagingDir Staging directory; cleared afterwards
+     */
+    void discardStaging(std::string& stagingDir) const {
+        if (!stagingDir.empty()) {
+            removeDirectoryTree(stagingDir);
+            stagingDir.clear();
+        }
+    }
+
+    /**
+     * @brief Snapshots the install directory so the update can be rolled back
+     * @param stagingDir Extracted package, or empty when only the executable changes
+     * @return true if the snapshot was taken or rollback is disabled
+     *
+     * Staged files identical to the installed ones are dropped from the
+     * staging directory first, so they are neither rewritten by the update
+     * nor copied into the snapshot.
+     */
+    bool prepareRollback(const std::string& stagingDir) const {
+        const std::string currentExePath = getCurrentExecutablePath();
+        const std::string installDir = currentExePath.substr(0, currentExePath.find_last_of("\\/"));
+
+        std::set<std::string> changedPaths;
+        if (stagingDir.empty()) {
+            changedPaths.insert(RollbackSnapshot::normalise(extractFileName(currentExePath)));
+        } else {
+            std::vector<std::string> staged;
+            if (!RollbackSnapshot::listFiles(stagingDir, staged)) {
+                logError("Failed to read staging directory: " + stagingDir);
+                return false;
+            }
+            for (const auto& file : staged) {
+                const std::string stagedPath = stagingDir + "\\" + file;
+                if (RollbackSnapshot::sameContents(stagedPath, installDir + "\\" + file)) {
+                    DeleteFileA(stagedPath.c_str());
+                } else {
+                    changedPaths.insert(RollbackSnapshot::normalise(file));
+                }
+            }
+        }
+
+        return snapshotInstall(installDir, changedPaths);
+    }
+
+    /**
+     * @brief Snapshots the files an update is about to change
+     * @param installDir Install directory
+     * @param changedPaths Normalised relative paths the update replaces
+     * @return true if the snapshot was taken or rollback is disabled
+     */
+    bool snapshotInstall(const std::string& installDir, const std::set<std::string>& changedPaths) const {
+        if (!m_keepRollback) {
+            RollbackSnapshot::prune(installDir, "");
+            return true;
+        }
+
+        RollbackSnapshot::prune(installDir, m_currentVersion);
+        RollbackSnapshot::Stats stats;
+        std::string error;
+        if (!RollbackSnapshot::create(installDir, RollbackSnapshot::path(installDir, m_currentVersion), changedPaths, stats, error)) {
+            logError("Failed to create rollback snapshot: " + error);
+            return false;
+        }
+
+        logInfo("Rollback snapshot of " + m_currentVersion + ": " + std::to_string(stats.linked) + " linked, " +
+                std::to_string(stats.cloned) + " cloned, " + std::to_string(stats.copied) + " copied (" +
+                std::to_string(stats.bytesCopied) + " bytes)");
+        return true;
+    }
+
+    /**
+     * @brief Maps a manifest path to a path below the install directory
+     * @param path '/'-separated path from the manifest
+     * @return '\\'-separated relative path, or empty if the path could escape the install
+     */
+    static std::string localRelativePath(const std::string& path) {
+        if (path.empty() || path[0] == '/' || path[0] == '\\' || path.find(':') != std::string::npos) {
+            return std::string();
+        }
+        std::string local;
+        size_t start = 0;
+        while (start <= path.size()) {
+            size_t end = path.find_first_of("/\\", start);
+            if (end == std::string::npos) end = path.size();
+            const std::string component = path.substr(start, end - start);
+            if (component == "..") {
+                return std::string();
+            }
+            if (!component.empty() && component != ".") {
+                local += (local.empty() ? "" : "\\") + component;
+            }
+            start = end + 1;
+        }
+        return local;
+    }
+
+    /**
+     * @brief Checks whether a release file is already installed
+     * @param installedPath Path of the installed copy
+     * @param file Manifest entry
+     * @param verifyContents true to hash files whose size matches; false trusts the size
+     */
+    bool isInstalled(const std::string& installedPath, const FileEntry& file, bool verifyContents) const {
+        WIN32_FILE_ATTRIBUTE_DATA data;
+        if (!GetFileAttributesExA(installedPath.c_str(), GetFileExInfoStandard, &data)) {
+            return false;
+        }
+        const uint64_t size = (static_cast<uint64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+        if (file.size != UpdateArtifact::UNKNOWN_SIZE && size != file.size) {
+            return false;
+        }
+        std::string expected;
+        if (!verifyContents || file.digest.empty() || !parseDigest(file.digest, expected)) {
+            return true;
+        }
+        return Blake3::hashFile(installedPath) == expected;
+    }
+
+    /**
+     * @brief Downloads the files of a multi-file release that differ from the install
+     * @param manifest Manifest with a Files list
+     * @param stagingDir Directory receiving the files under their relative paths
+     * @param deferred false for files needed to launch, true for deferred files
+     * @param verifyContents true to hash installed files whose size matches
+     * @param staged Receives the number of files downloaded
+     * @return true if every missing or changed file was downloaded and verified
+     *
+     * The executable is skipped because the update route builds it. Files
+     * are fetched smallest first so the most of them become available soonest.
+     * Each is downloaded to fileDownloadPath() and only moved into the
+     * staging directory once every file is verified, so a failed attempt
+     * keeps its partial downloads and a file completed earlier is reused.
+     * Only a file that fails verification is deleted.
+     */
+    bool stageFiles(const UpdateManifest& manifest, const std::string& stagingDir,
+                    bool deferred, bool verifyContents, size_t& staged) const {
+        const std::string currentExePath = getCurrentExecutablePath();
+        const std::string installDir = currentExePath.substr(0, currentExePath.find_last_of("\\/"));
+        const std::string exeName = RollbackSnapshot::normalise(extractFileName(currentExePath));
+
+        // Only the files to fetch are held in memory; the rest of the list may be spooled
+        std::vector<FileEntry> needed;
+        bool safe = true;
+        const bool listed = manifest.forEachFile([&](const FileEntry& file) {
+            const std::string relative = localRelativePath(file.path);
+            if (relative.empty()) {
+                logError("Unsafe path in manifest: " + file.path);
+                safe = false;
+                return false;
+            }
+            const std::string installedPath = installDir + "\\" + relative;
+            // Lazy files are only kept current once the application has fetched them
+            const bool lazy = (file.flags & FileEntry::FLAG_LAZY) != 0;
+            if ((lazy && (deferred || GetFileAttributesA(installedPath.c_str()) == INVALID_FILE_ATTRIBUTES)) ||
+                (!lazy && ((file.flags & FileEntry::FLAG_DEFERRED) != 0) != deferred) ||
+                RollbackSnapshot::normalise(relative) == exeName ||
+                isInstalled(installedPath, file, verifyContents)) {
+                return true;
+            }
+            needed.push_back(file);
+            return true;
+        });
+        if (!listed) {
+            logError("Failed to read the file list of " + manifest.version);
+            return false;
+        }
+        if (!safe) {
+            return false;
+        }
+        std::stable_sort(needed.begin(), needed.end(),
+                         [](const FileEntry& a, const FileEntry& b) { return a.size < b.size; });
+
+        std::vector<std::string> downloads;
+        for (const FileEntry& file : needed) {
+            UpdateArtifact artifact;
+            artifact.link = file.link;
+            artifact.size = file.size;
+            artifact.digest = file.digest;
+            const std::string download = fileDownloadPath(artifact);
+            downloads.push_back(download);
+
+            // A download finished by an earlier attempt has no checkpoint left and matches its digest
+            const std::string checkpoint = RangedFile::writePath(download, m_durability) + ".ckpt";
+            if (!file.digest.empty() && GetFileAttributesA(checkpoint.c_str()) == INVALID_FILE_ATTRIBUTES &&
+                isInstalled(download, file, true)) {
+                logInfo("Reusing the earlier download of " + file.path);
+                continue;
+            }
+
+            logInfo("Downloading " + file.path);
+            if (!downloadArtifact(artifact, manifest, download)) {
+                logError("Failed to download " + file.path);
+                return false;
+            }
+            if (!file.digest.empty() && !verifyDigest(download, file.digest)) {
+                DeleteFileA(download.c_str());
+                return false;
+            }
+        }
+
+        staged = 0;
+        for (size_t i = 0; i < needed.size(); ++i) {
+            const std::string target = stagingDir + "\\" + localRelativePath(needed[i].path);
+            if (!RollbackSnapshot::createParents(target) ||
+                !MoveFileExA(downloads[i].c_str(), target.c_str(), MOVEFILE_COPY_ALLOWED | MOVEFILE_REPLACE_EXISTING)) {
+                logError("Failed to stage " + needed[i].path);
+                return false;
+            }
+            ++staged;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Stages a multi-file release around the executable built by the update route
+     * @param manifest Manifest with a Files list
+     * @param imagePath New executable built by applyRoute(); moved into the staging directory
+     * @param stagingDir Staging directory to create
+     * @return true if the executable and every launch file are staged
+     *
+     * Deferred files are left for completeDeferredFiles() after the restart,
+     * so bulk assets do not delay the new version.
+     */
+    bool stageRelease(const UpdateManifest& manifest, const std::string& imagePath, const std::string& stagingDir) const {
+        removeDirectoryTree(stagingDir);
+        size_t staged = 0;
+        const std::string stagedExe = stagingDir + "\\" + extractFileName(getCurrentExecutablePath());
+        if (!CreateDirectoryA(stagingDir.c_str(), nullptr) ||
+            !MoveFileExA(imagePath.c_str(), stagedExe.c_str(), MOVEFILE_COPY_ALLOWED | MOVEFILE_REPLACE_EXISTING)) {
+            logError("Failed to create staging directory: " + stagingDir);
+            return false;
+        }
+        if (!stageFiles(manifest, stagingDir, false, true, staged)) {
+            removeDirectoryTree(stagingDir);
+            return false;
+        }
+        logInfo("Staged " + std::to_string(staged) + " changed file(s) needed to launch");
+        return true;
+    }
+
+    /**
+     * @brief Gets the full path of the currently running executable
+     * @return Current executable path
+     */
+    std::string getCurrentExecutablePath() const {
+        char path[MAX_PATH];
+        if (GetModuleFileNameA(nullptr, path, MAX_PATH) == 0) {
+            throw std::runtime_error("Failed to get current executable path");
+        }
+        return std::string(path);
+    }
+
+    /**
+     * @brief Installs staged files through the apply journal
+     * @param newExePath Path to the downloaded update file, or to the staging
+     *                   directory when isDirectory is set
+     * @param currentExePath Path to the current executable
+     * @param newVersion Version being installed, recorded in the journal
+     * @param isDirectory true to install every file below a staging directory
+     *
+     * Files are replaced by renames, which Windows permits for the running
+     * executable, so the install can happen while this process runs. A crash
+     * part-way through is finished or undone by recoverInterruptedUpdate()
+     * on the next start.
+     */
+    void installStaged(const std::string& newExePath, const std::string& currentExePath,
+                       const std::string& newVersion, bool isDirectory) const {
+        const std::string installDir = currentExePath.substr(0, currentExePath.find_last_of("\\/"));
+
+        std::vector<ApplyJournal::Replacement> replacements;
+        if (isDirectory) {
+            std::vector<std::string> staged;
+            if (!RollbackSnapshot::listFiles(newExePath, staged)) {
+                throw std::runtime_error("Failed to read staging directory: " + newExePath);
+            }
+            for (const auto& file : staged) {
+                replacements.push_back(ApplyJournal::Replacement{newExePath + "\\" + file, file});
+            }
+        } else {
+            replacements.push_back(ApplyJournal::Replacement{newExePath, extractFileName(currentExePath)});
+        }
+
+        ApplyJournal journal(installDir, m_durability);
+        const bool applied = journal.apply(replacements, m_currentVersion + " -> " + newVersion);
+        if (isDirectory) {
+            removeDirectoryTree(newExePath);
+        }
+        if (!applied) {
+            throw std::runtime_error(journal.lastError());
+        }
+    }
+
+    /**
+     * @brief Installs the update and restarts the application
+     * @param newExePath Path to the downloaded update file, or to the staging
+     *                   directory when isDirectory is set
+     * @param currentExePath Path to the current executable
+     * @param manifest Manifest of the version being installed; recorded once the install succeeds
+     * @param isDirectory true to install every file below a staging directory
+     */
+    void executeUpdate(const std::string& newExePath, const std::string& currentExePath,
+                       const UpdateManifest& manifest, bool isDirectory = false) const {
+        installStaged(newExePath, currentExePath, manifest.version, isDirectory);
+        recordInstalledManifest(manifest);
+        logInfo("Update installed successfully");
+        restartApplication(currentExePath);
+    }
+
+    /**
+     * @brief Exits and starts the executable again
+     * @param currentExePath Path to the current executable
+     *
+     * A small batch script restarts the application once this process has exited.
+     */
+    void restartApplication(const std::string& currentExePath) const {
+        const std::string batchPath = m_tempDirectory + "\\updater_script.bat";
+        std::ofstream batch(batchPath);
+        if (!batch.is_open()) {
+            throw std::runtime_error("Failed to create restart script");
+        }
+
+        // Restart once this process has exited
+        batch << "@echo off\n"
+              << "title Application Updater\n"
+              << "timeout /t 2 /nobreak >nul\n"
+              << "start \"\" \"" << currentExePath << "\"\n"
+              << "del \"%~f0\" >nul 2>&1\n";
+
+        batch.close();
+
+        ShellExecuteA(nullptr, "open", batchPath.c_str(), nullptr, nullptr, SW_HIDE);
+        ExitProcess(0);
+    }
+
+    /**
+     * @brief Extracts filename from full path
+     * @param fullPath Full file path
+     * @return Filename only
+     */
+    std::string extractFileName(const std::string& fullPath) const {
+        size_t pos = fullPath.find_last_of("\\/");
+        return (pos != std::string::npos) ? fullPath.substr(pos + 1) : fullPath;
+    }
+
+    /**
+     * @brief Compares two version strings
+     * @param current Current version
+     * @param remote Remote version
+     * @return true if remote version is newer
+     */
+    bool isNewerVersion(const std::string& current, const std::string& remote) const {
+        // Simple version comparison - can be enhanced for semantic versioning
+        return current != remote;
+    }
+
+    /**
+     * @brief Logs error messages to console
+     * @param message Error message to log
+     */
+    void logError(const std::string& message) const {
+        std::cerr << "[AutoUpdater Error] " << message << std::endl;
+    }
+
+    /**
+     * @brief Logs informational messages to console
+     * @param message Information message to log
+     */
+    void logInfo(const std::string& message) const {
+        std::cout << "[AutoUpdater] " << message << std::endl;
+    }
+
+    /**
+     * @brief Implements checkForUpdate() and the checks of pollForUpdates()
+     * @param currentVersion Current application version
+     * @param keepRunning While an update is held for low load, asked before
+     *                    each sample; returning false abandons the update. May be empty.
+     * @return true if update was found and applied, false otherwise
+     *
+     * Publishes each stage on the status board; a check that fails part-way
+     * is published as UpdateState::Failed.
+     */
+    bool checkAndApply(const std::string& currentVersion, const std::function<bool()>& keepRunning) {
+        m_currentVersion = currentVersion;
+        publishStatus(UpdateState::Checking, std::string());
+        const bool applied = runCheck(keepRunning);
+
+        if (m_statusBoard.isOpen()) {
+            std::lock_guard<std::mutex> lock(m_statusMutex);
+            const UpdateState state = m_status.state;
+            if (m_lastCheckFailed && (state == UpdateState::Checking || state == UpdateState::Downloading ||
+                                      state == UpdateState::Staged || state == UpdateState::Installing)) {
+                m_status.state = UpdateState::Failed;
+            }
+            m_status.lastCheckUnixMs = StatusBoard::unixTimeMs();
+            m_statusBoard.publish(m_status);
+        }
+        return applied;
+    }
+
+    /**
+     * @brief Checks once for an update of m_currentVersion and applies it; see checkAndApply()
      */
-    nlohmann::json fetchVersionInfo(const std::string& jsonUrl) const {
-        const std::string tempFile = m_tempDirectory + "\\version_info.json";
-        nlohmann::json result;
+    bool runCheck(const std::function<bool()>& keepRunning) {
+        m_lastCheckFailed = true;
+        m_retryAfterMs = 0;
+
+        if (!recoverInterruptedUpdate()) {
+            return false;
+        }
+
+        logInfo("Checking for updates...");
+        logInfo("Current version: " + m_currentVersion);
+
+        // Fetch version information from server; repeat checks are conditional
+        UpdateManifest manifest;
+        ConditionalRequest conditional;
+        if (!refreshManifest(manifest, conditional)) {
+            m_retryAfterMs = conditional.retryAfterMs();
+            return false;
+        }
+
+        logInfo(conditional.notModified() ? "Remote version: " + manifest.version + " (not modified)"
+                                          : "Remote version: " + manifest.version);
+
+        // Deferred files of the installed release are completed whether or not a newer release exists,
+        // but only inside the download window since they are the bulk of a release
+        UpdateManifest installed;
+        bool haveInstalled = loadInstalledManifest(installed, "app_update_installed_files.dat");
+        if (!haveInstalled && manifest.version == m_currentVersion && adoptInstalledManifest(manifest)) {
+            installed = manifest;
+            haveInstalled = true;
+        }
+        m_deferredPending = false;
+        if (haveInstalled && hasDeferredFiles(installed)) {
+            if (m_windows.download.contains(localTime())) {
+                completeDeferredFiles(installed);
+            } else {
+                logInfo("Deferred files of " + installed.version + " are pending: outside the download window (" +
+                        m_windows.download.expression() + ")");
+                m_deferredPending = true;
+            }
+        }
+
+        // Check if update is needed
+        if (!isNewerVersion(m_currentVersion, manifest.version)) {
+            logInfo("Application is up to date");
+            m_lastCheckFailed = false;
+            setPendingVersion(std::string());
+            publishStatus(UpdateState::UpToDate, std::string());
+            return false;
+        }
+
+        if (m_canary.measure && PerformanceHistory(performanceHistoryPath()).isRejected(manifest.version)) {
+            logInfo("Skipping version " + manifest.version + ": it was rolled back after a performance regression");
+            m_lastCheckFailed = false;
+            publishStatus(UpdateState::UpToDate, std::string());
+            return false;
+        }
+
+        // Outside the windows the update is only recorded; one-off checks cannot wait for a restart window
+        const std::tm now = localTime();
+        if (!m_windows.download.contains(now) || (!keepRunning && !m_windows.restart.contains(now))) {
+            const bool downloadClosed = !m_windows.download.contains(now);
+            logInfo("Update to " + manifest.version + " is pending: outside the " +
+                    (downloadClosed ? "download window (" + m_windows.download.expression()
+                                    : "restart window (" + m_windows.restart.expression()) + ")");
+            m_lastCheckFailed = false;
+            setPendingVersion(manifest.version);
+            publishStatus(UpdateState::Pending, manifest.version);
+            return false;
+        }
+
+        const std::string variant = manifest.selectVariant(CpuFeatures::host());
+        if (!variant.empty()) {
+            logInfo("Using the build for " + variant);
+        }
+
+        logInfo("Update available! Starting download...");
+
+        // Download update along the cheapest route of images and patches
+        std::string updateFilePath;
+        std::string stagingDir;
+        if (!applyRoute(manifest, updateFilePath, stagingDir)) {
+            logError("Failed to download update");
+            return false;
+        }
+
+        // Multi-file releases stage launch files now and deferred files after the restart
+        if (stagingDir.empty() && manifest.hasFiles()) {
+            stagingDir = m_tempDirectory + "\\app_update_staging";
+            if (!stageRelease(manifest, updateFilePath, stagingDir)) {
+                DeleteFileA(updateFilePath.c_str());
+                return false;
+            }
+        }
+
+        publishStatus(UpdateState::Staged, manifest.version);
+        if (!waitForApplyWindow(keepRunning)) {
+            logInfo("Stopped while holding the update; a later check downloads it again");
+            publishStatus(UpdateState::Idle, std::string());
+            if (stagingDir.empty()) {
+                DeleteFileA(updateFilePath.c_str());
+            } else {
+                removeDirectoryTree(stagingDir);
+            }
+            return false;
+        }
 
-        if (!downloadFile(jsonUrl, tempFile)) {
-            return result;
+        if (!prepareRollback(stagingDir)) {
+            if (stagingDir.empty()) {
+                DeleteFileA(updateFilePath.c_str());
+            } else {
+                removeDirectoryTree(stagingDir);
+            }
+            return false;
         }
 
+        logInfo("Download completed. Applying update...");
+        setPendingVersion(std::string());
+        recordCanaryPending(manifest.version);
+        publishStatus(UpdateState::Installing, manifest.version);
+
         try {
-            std::ifstream file(tempFile);
-            if (file.is_open()) {
-                file >> result;
-                file.close();
+            if (stagingDir.empty()) {
+                executeUpdate(updateFilePath, getCurrentExecutablePath(), manifest);
+            } else {
+                executeUpdate(stagingDir, getCurrentExecutablePath(), manifest, true);
             }
         } catch (const std::exception& e) {
-            logError("JSON parsing error: " + std::string(e.what()));
+            logError("Update execution failed: " + std::string(e.what()));
+            return false;
         }
 
-        // Cleanup temporary file
-        DeleteFileA(tempFile.c_str());
-        return result;
+        return true;
     }
 
     /**
-     * @brief Gets the full path of the currently running executable
-     * @return Current executable path
+     * @brief Fetches the manifest, conditionally once one is cached, and caches it
+     * @param manifest Receives the current manifest
+     * @param conditional Receives the validators and Retry-After of the response
+     * @return false if the manifest could not be fetched
      */
-    std::string getCurrentExecutablePath() const {
-        char path[MAX_PATH];
-        if (GetModuleFileNameA(nullptr, path, MAX_PATH) == 0) {
-            throw std::runtime_error("Failed to get current executable path");
+    bool refreshManifest(UpdateManifest& manifest, ConditionalRequest& conditional) {
+        {
+            std::lock_guard<std::mutex> lock(m_assetMutex);
+            if (m_haveManifest) {
+                conditional = m_conditional;
+            }
         }
-        return std::string(path);
-    }
-
-    /**
-     * @brief Creates and executes a batch file for seamless application update
-     * @param newExePath Path to the downloaded update file
-     * @param currentExePath Path to the current executable
-     */
-    void executeUpdate(const std::string& newExePath, const std::string& currentExePath) const {
-        const std::string batchPath = m_tempDirectory + "\\updater_script.bat";
-        
-        std::ofstream batch(batchPath);
-        if (!batch.is_open()) {
-            throw std::runtime_error("Failed to create update script");
+        if (!fetchManifest(m_updateUrl, manifest, &conditional)) {
+            return false;
         }
-
-        // Create sophisticated batch script
-        batch << "@echo off\n"
-              << "title Application Updater\n"
-              << "echo Applying update...\n"
-              << "timeout /t 3 /nobreak >nul\n"
-              << "taskkill /f /im \"" << extractFileName(currentExePath) << "\" >nul 2>&1\n"
-              << "timeout /t 1 /nobreak >nul\n"
-              << "copy /Y \"" << newExePath << "\" \"" << currentExePath << "\" >nul\n"
-              << "if errorlevel 1 (\n"
-              << "    echo Update failed!\n"
-              << "    pause\n"
-              << "    exit /b 1\n"
-              << ")\n"
-              << "echo Update completed successfully!\n"
-              << "start \"\" \"" << currentExePath << "\"\n"
-              << "timeout /t 2 /nobreak >nul\n"
-              << "del \"" << newExePath << "\" >nul 2>&1\n"
-              << "del \"%~f0\" >nul 2>&1\n";
-
-        batch.close();
-
-        // Execute update script
-        ShellExecuteA(nullptr, "open", batchPath.c_str(), nullptr, nullptr, SW_HIDE);
-        ExitProcess(0);
+        std::lock_guard<std::mutex> lock(m_assetMutex);
+        if (conditional.notModified()) {
+            manifest = m_manifest;
+        } else {
+            m_manifest = manifest;
+            m_haveManifest = true;
+        }
+        m_conditional = conditional;
+        return true;
     }
 
     /**
-     * @brief Extracts filename from full path
-     * @param fullPath Full file path
-     * @return Filename only
+     * @brief Holds a staged update until the restart window and the apply policy allow a restart
+     * @param keepRunning Asked before each sample; may be empty
+     * @return false if keepRunning asked to stop first
+     *
+     * The maximum deferral counts from staging, but the restart always
+     * happens inside the restart window.
      */
-    std::string extractFileName(const std::string& fullPath) const {
-        size_t pos = fullPath.find_last_of("\\/");
-        return (pos != std::string::npos) ? fullPath.substr(pos + 1) : fullPath;
+    bool waitForApplyWindow(const std::function<bool()>& keepRunning) const {
+        ApplyGate gate(m_applyPolicy, GetTickCount64());
+        bool announced = false;
+        bool heldForWindow = false;
+        for (;;) {
+            const bool windowOpen = m_windows.restart.contains(localTime());
+            if (windowOpen && gate.ready(GetTickCount64())) {
+                break;
+            }
+            if (!windowOpen && !heldForWindow) {
+                logInfo("Holding update until the restart window (" + m_windows.restart.expression() + ") opens");
+                heldForWindow = true;
+            } else if (windowOpen && !announced) {
+                logInfo("Holding update until load is at most " + std::to_string(m_applyPolicy.threshold) +
+                        " (currently " + std::to_string(gate.lastLoad()) + ")");
+                announced = true;
+            }
+            if (keepRunning && !keepRunning()) {
+                return false;
+            }
+            Sleep(windowOpen ? static_cast<DWORD>(std::max<uint64_t>(m_applyPolicy.sampleIntervalMs, 1)) : static_cast<DWORD>(POLL_SLICE_MS));
+        }
+        if (gate.expired()) {
+            logInfo("Update held for the maximum deferral; applying under load " + std::to_string(gate.lastLoad()));
+        } else if (heldForWindow && !announced) {
+            logInfo("Restart window opened; applying update");
+        } else if (announced) {
+            logInfo("Load dropped to " + std::to_string(gate.lastLoad()) + " after " +
+                    std::to_string(gate.heldMs(GetTickCount64()) / 1000) + " s; applying update");
+        }
+        return true;
     }
 
     /**
-     * @brief Compares two version strings
-     * @param current Current version
-     * @param remote Remote version
-     * @return true if remote version is newer
+     * @brief Records the update held back by the maintenance windows, or clears it
      */
-    bool isNewerVersion(const std::string& current, const std::string& remote) const {
-        // Simple version comparison - can be enhanced for semantic versioning
-        return current != remote;
+    void setPendingVersion(const std::string& version) {
+        std::lock_guard<std::mutex> lock(m_pendingMutex);
+        m_pendingVersion = version;
     }
 
     /**
-     * @brief Logs error messages to console
-     * @param message Error message to log
+     * @brief Publishes a new stage of the update cycle on the status board
+     * @param state New state
+     * @param targetVersion Version being checked, downloaded or staged; empty for none
+     * @param totalBytes Size of the download that starts, 0 if unknown or none
      */
-    void logError(const std::string& message) const {
-        std::cerr << "[AutoUpdater Error] " << message << std::endl;
+    void publishStatus(UpdateState state, const std::string& targetVersion, uint64_t totalBytes = 0) const {
+        if (!m_statusBoard.isOpen()) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(m_statusMutex);
+        m_status.state = state;
+        m_status.currentVersion = m_currentVersion;
+        m_status.targetVersion = targetVersion;
+        m_status.downloadedBytes = 0;
+        m_status.totalBytes = totalBytes;
+        m_statusBoard.publish(m_status);
     }
 
     /**
-     * @brief Logs informational messages to console
-     * @param message Information message to log
+     * @brief Adds received bytes to the published download progress
+     *
+     * Only counts while the state is Downloading, so manifest and asset
+     * fetches do not move the progress of an update.
      */
-    void logInfo(const std::string& message) const {
-        std::cout << "[AutoUpdater] " << message << std::endl;
+    void addDownloadProgress(uint64_t bytes) const {
+        if (!m_statusBoard.isOpen()) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(m_statusMutex);
+        if (m_status.state != UpdateState::Downloading) {
+            return;
+        }
+        m_status.downloadedBytes += bytes;
+        if (m_status.totalBytes != 0 && m_status.downloadedBytes > m_status.totalBytes) {
+            m_status.totalBytes = m_status.downloadedBytes; // Retries and release files beyond the route
+        }
+        m_statusBoard.publish(m_status);
     }
 
 public:
@@ -275,64 +1556,620 @@ public:
         }
     }
 
+    /**
+     * @brief Starts connecting to the update server in the background
+     *
+     * Call as early as possible during start-up; DNS resolution and the
+     * TCP/TLS handshake then overlap with the application's own
+     * initialisation, and the next checkForUpdate() finds a warm connection.
+     */
+    void prepare() const {
+        InternetSession::instance().prepare(m_updateUrl);
+    }
+
     /**
      * @brief Checks for available updates and applies them if found
      * @param currentVersion Current application version
      * @return true if update was found and applied, false otherwise
+     *
+     * With an ApplyPolicy set, a verified update is held until the
+     * application's load allows a restart; see setApplyPolicy().
      */
     bool checkForUpdate(const std::string& currentVersion) {
+        return checkAndApply(currentVersion, std::function<bool()>());
+    }
+
+    /**
+     * @brief Plans the update without downloading or installing anything
+     * @param currentVersion Current application version
+     * @param result Receives the strategy, route, expected bytes and estimated
+     *             time; Strategy::None if no newer version is published
+     * @return false if the manifest could not be fetched
+     *
+     * Uses the same cost model as checkForUpdate(): download sizes, the
+     * throughput learned from earlier downloads per mirror, checkpoints of
+     * interrupted downloads and the release files already installed. Only
+     * the manifest is fetched; maintenance windows are not consulted.
+     */
+    bool plan(const std::string& currentVersion, UpdatePlan& result) {
+        UpdateManifest manifest;
+        ConditionalRequest conditional;
+        if (!refreshManifest(manifest, conditional)) {
+            return false;
+        }
+        manifest.selectVariant(CpuFeatures::host());
+        if (!isNewerVersion(currentVersion, manifest.version)) {
+            result = UpdatePlan();
+            result.targetVersion = manifest.version;
+            return true;
+        }
+        result = costModel(manifest).plan(manifest, currentVersion);
+        return true;
+    }
+
+    /**
+     * @brief Installs a release from an offline bundle and restarts into it
+     * @param bundlePath Bundle written by `Publisher --bundle`
+     * @param currentVersion Current application version
+     * @return false if the bundle is damaged, not newer or could not be
+     *         installed; on success the application restarts
+     *
+     * The bundle is mapped and every payload verified on all cores before
+     * anything changes. Changed files are then written from the mapping
+     * straight into the apply journal, with a rollback snapshot taken
+     * first as for online updates. Every file in the bundle is installed,
+     * including deferred and lazy ones. When the manifest lists variants,
+     * the executable is the bundled build selectVariant() picks for this
+     * CPU. Maintenance windows and the apply policy do not apply:
+     * installing a bundle is an explicit request.
+     */
+    bool applyBundle(const std::string& bundlePath, const std::string& currentVersion) {
         m_currentVersion = currentVersion;
+        if (!recoverInterruptedUpdate()) {
+            return false;
+        }
 
-        logInfo("Checking for updates...");
-        logInfo("Current version: " + m_currentVersion);
+        UpdateBundle bundle;
+        std::string error;
+        const std::string filesPath = MemoryProfile::BOUNDED ? m_tempDirectory + "\\app_bundle_manifest_files.dat" : std::string();
+        if (!bundle.open(bundlePath, error, filesPath) || !bundle.verify(0, error)) {
+            logError(error);
+            return false;
+        }
+        UpdateManifest manifest = bundle.manifest();
+        logInfo("Bundle version: " + manifest.version);
+        if (!isNewerVersion(m_currentVersion, manifest.version)) {
+            logInfo("Application is up to date");
+            return false;
+        }
 
-        // Fetch version information from server
-        nlohmann::json versionInfo = fetchVersionInfo(m_updateUrl);
-        if (versionInfo.empty() || !versionInfo.contains("AppVersion") || !versionInfo.contains("UpdateLink")) {
-            logError("Invalid or missing version information from server");
+        // The executable comes from the variant build for this CPU when one is bundled
+        const UpdateBundle::Entry* variantEntry = nullptr;
+        const std::string variant = manifest.selectVariant(CpuFeatures::host());
+        if (!variant.empty()) {
+            variantEntry = bundle.findContent(manifest.digest);
+            if (!variantEntry) {
+                logError("Bundle does not carry the build for " + variant);
+                return false;
+            }
+            logInfo("Using the build for " + variant);
+        }
+
+        const std::string currentExePath = getCurrentExecutablePath();
+        const std::string installDir = currentExePath.substr(0, currentExePath.find_last_of("\\/"));
+        const std::string exeName = RollbackSnapshot::normalise(extractFileName(currentExePath));
+        std::vector<ApplyJournal::Replacement> replacements;
+        std::set<std::string> changedPaths;
+        bool complete = true;
+        const bool readAll = manifest.forEachFile([&](const FileEntry& listed) {
+            const std::string relative = localRelativePath(listed.path);
+            FileEntry file = listed;
+            const UpdateBundle::Entry* entry = bundle.find(file.path);
+            if (variantEntry && !relative.empty() && RollbackSnapshot::normalise(relative) == exeName) {
+                entry = variantEntry;
+                file.size = variantEntry->size;
+                file.digest = variantEntry->digest;
+            }
+            if (relative.empty() || !entry || entry->digest != file.digest) {
+                logError("Bundle does not carry " + file.path);
+                complete = false;
+                return false;
+            }
+            if (isInstalled(installDir + "\\" + relative, file, true)) {
+                return true;
+            }
+            ApplyJournal::Replacement replacement;
+            replacement.target = relative;
+            replacement.write = [&bundle, entry](const std::string& staged) { return bundle.extract(*entry, staged); };
+            replacements.push_back(replacement);
+            changedPaths.insert(RollbackSnapshot::normalise(relative));
+            return true;
+        });
+        if (!readAll) {
+            logError("Failed to read the file list of " + manifest.version);
+            return false;
+        }
+        if (!complete) {
+            return false;
+        }
+        if (replacements.empty()) {
+            logInfo("Every file of " + manifest.version + " is already installed");
+            return false;
+        }
+        if (!snapshotInstall(installDir, changedPaths)) {
             return false;
         }
 
-        std::string remoteVersion;
-        std::string updateLink;
+        logInfo("Installing " + std::to_string(replacements.size()) + " file(s) from the bundle...");
+        setPendingVersion(std::string());
+        recordCanaryPending(manifest.version);
+        publishStatus(UpdateState::Installing, manifest.version);
 
+        ApplyJournal journal(installDir, m_durability);
+        if (!journal.apply(replacements, m_currentVersion + " -> " + manifest.version)) {
+            logError("Bundle install failed: " + journal.lastError());
+            publishStatus(UpdateState::Failed, manifest.version);
+            return false;
+        }
+        recordInstalledManifest(manifest);
+        bundle.close();
+        logInfo("Update installed successfully");
         try {
-            remoteVersion = versionInfo["AppVersion"].get<std::string>();
-            updateLink = versionInfo["UpdateLink"].get<std::string>();
+            restartApplication(currentExePath);
         } catch (const std::exception& e) {
-            logError("Failed to parse version information: " + std::string(e.what()));
+            logError("Update execution failed: " + std::string(e.what()));
             return false;
         }
+        return true;
+    }
 
-        logInfo("Remote version: " + remoteVersion);
+    /**
+     * @brief Checks for updates periodically until one is applied or polling stops
+     * @param currentVersion Current application version
+     * @param policy Interval, jitter and backoff of the checks
+     * @param keepRunning Asked about once a second; return false to stop polling
+     * @return true if an update was applied and the application is restarting
+     *
+     * Blocks the calling thread, so run it on a background thread. A failed
+     * check, including a failed download, is retried with exponential
+     * backoff and never sooner than the server's Retry-After. An update,
+     * or deferred files, left pending by the download window are checked
+     * again as soon as the window opens.
+     */
+    bool pollForUpdates(const std::string& currentVersion, const CheckPolicy& policy,
+                        const std::function<bool()>& keepRunning) {
+        CheckSchedule schedule(policy, GetTickCount64() ^ (static_cast<uint64_t>(GetCurrentProcessId()) << 32));
+        uint64_t next = schedule.start(GetTickCount64());
+        bool downloadWindowOpen = true;
+        while (keepRunning()) {
+            const uint64_t now = GetTickCount64();
+            if (steadyStateDue(now)) {
+                recordSteadyState();
+            }
+            const bool windowOpen = m_windows.download.contains(localTime());
+            const bool windowOpened = windowOpen && !downloadWindowOpen && (!pendingUpdate().empty() || m_deferredPending);
+            downloadWindowOpen = windowOpen;
+            if (now < next && !windowOpened) {
+                Sleep(static_cast<DWORD>(std::min<uint64_t>(next - now, static_cast<uint64_t>(POLL_SLICE_MS))));
+                continue;
+            }
+            if (checkAndApply(currentVersion, keepRunning)) {
+                return true;
+            }
+            next = m_lastCheckFailed ? schedule.failed(GetTickCount64(), m_retryAfterMs)
+                                     : schedule.succeeded(GetTickCount64());
+        }
+        return false;
+    }
 
-        // Check if update is needed
-        if (!isNewerVersion(m_currentVersion, remoteVersion)) {
-            logInfo("Application is up to date");
+    /**
+     * @brief Checks whether a manifest lists deferred files, which are not lazy
+     */
+    static bool hasDeferredFiles(const UpdateManifest& manifest) {
+        bool anyDeferred = false;
+        manifest.forEachFile([&anyDeferred](const FileEntry& file) {
+            anyDeferred = (file.flags & (FileEntry::FLAG_DEFERRED | FileEntry::FLAG_LAZY)) == FileEntry::FLAG_DEFERRED;
+            return !anyDeferred;
+        });
+        return anyDeferred;
+    }
+
+    /**
+     * @brief Fetches deferred files of the installed release that are missing
+     * @param manifest Manifest of the installed version
+     * @return true if no deferred file is missing any more
+     *
+     * Every check inside the download window runs it with the manifest
+     * recorded when the running version was installed, so deferred files
+     * still arrive when a newer release is already published. Installed
+     * files are only compared by size, which keeps the check cheap on
+     * every start.
+     */
+    bool completeDeferredFiles(const UpdateManifest& manifest) const {
+        if (!hasDeferredFiles(manifest)) {
+            return true;
+        }
+
+        const std::string stagingDir = m_tempDirectory + "\\app_update_deferred";
+        removeDirectoryTree(stagingDir);
+        size_t staged = 0;
+        if (!CreateDirectoryA(stagingDir.c_str(), nullptr) || !stageFiles(manifest, stagingDir, true, false, staged)) {
+            removeDirectoryTree(stagingDir);
             return false;
         }
+        if (staged == 0) {
+            removeDirectoryTree(stagingDir);
+            return true;
+        }
 
-        logInfo("Update available! Starting download...");
+        try {
+            installStaged(stagingDir, getCurrentExecutablePath(), manifest.version, true);
+        } catch (const std::exception& e) {
+            logError("Failed to install deferred files: " + std::string(e.what()));
+            return false;
+        }
+        logInfo("Installed " + std::to_string(staged) + " deferred file(s)");
+        return true;
+    }
 
-        // Download update
-        const std::string updateFilePath = m_tempDirectory + "\\app_update.exe";
-        if (!downloadFile(updateLink, updateFilePath)) {
-            logError("Failed to download update");
+    /**
+     * @brief Makes sure an on-demand asset of the installed release is present
+     * @param path Asset path as listed in the manifest, e.g. "assets/intro.mp4"
+     * @return true if the asset is installed
+     *
+     * Files published with `"Priority": "lazy"` are not downloaded by updates.
+     * The first call for such a file fetches it, verifies its digest and
+     * installs it through the apply journal; later calls return immediately.
+     * The asset is resolved against the manifest recorded when the running
+     * version was installed, so it stays available after the server moves
+     * on to a newer release. Without a recorded manifest, e.g. on a fresh
+     * install, the server's manifest is used if it still describes the
+     * running version and the installed files match it, and is recorded.
+     * Calls are serialised.
+     */
+    bool ensureAsset(const std::string& path) {
+        std::lock_guard<std::mutex> lock(m_assetMutex);
+        const std::string relative = localRelativePath(path);
+        const std::string key = RollbackSnapshot::normalise(relative);
+        if (relative.empty()) {
+            logError("Unsafe asset path: " + path);
             return false;
         }
+        if (m_ensuredAssets.count(key)) {
+            return true;
+        }
 
-        logInfo("Download completed. Applying update...");
+        const bool cached = m_haveInstalledManifest && m_installedManifest.version == m_currentVersion;
+        if (!cached && !loadInstalledManifest(m_installedManifest, "app_asset_manifest_files.dat")) {
+            if (!m_haveManifest) {
+                if (!fetchManifest(m_updateUrl, m_manifest, &m_conditional)) {
+                    return false;
+                }
+                m_haveManifest = true;
+            }
+            if (!m_currentVersion.empty() && m_manifest.version != m_currentVersion) {
+                logError("Assets of version " + m_currentVersion + " are not in the manifest for " + m_manifest.version +
+                         ", and no manifest was recorded when it was installed");
+                return false;
+            }
+            // Reloaded from the record so its file list does not share m_manifest's spool
+            if (m_currentVersion.empty()) {
+                m_installedManifest = m_manifest;
+            } else if (!adoptInstalledManifest(m_manifest) ||
+                       !loadInstalledManifest(m_installedManifest, "app_asset_manifest_files.dat")) {
+                logError("Assets of version " + m_currentVersion + " cannot be resolved: the installed files do not "
+                         "match its manifest, and none was recorded when it was installed");
+                return false;
+            }
+        }
+        m_haveInstalledManifest = true;
 
-        try {
-            executeUpdate(updateFilePath, getCurrentExecutablePath());
-        } catch (const std::exception& e) {
-            logError("Update execution failed: " + std::string(e.what()));
+        FileEntry asset;
+        bool found = false;
+        m_installedManifest.forEachFile([&](const FileEntry& file) {
+            if (RollbackSnapshot::normalise(localRelativePath(file.path)) == key) {
+                asset = file;
+                found = true;
+            }
+            return true;
+        });
+        const FileEntry* entry = found ? &asset : nullptr;
+        if (!entry) {
+            logError("Unknown asset: " + path);
+            return false;
+        }
+
+        const std::string currentExePath = getCurrentExecutablePath();
+        const std::string installDir = currentExePath.substr(0, currentExePath.find_last_of("\\/"));
+        if (!isInstalled(installDir + "\\" + relative, *entry, false)) {
+            // Named after the path so an interrupted fetch resumes next time
+            const std::string temp = m_tempDirectory + "\\app_asset_" +
+                                     Blake3::hashBuffer(key.data(), key.size()).substr(0, 16) + ".tmp";
+            UpdateArtifact artifact;
+            artifact.link = entry->link;
+            artifact.size = entry->size;
+            artifact.digest = entry->digest;
+
+            logInfo("Fetching asset " + entry->path);
+            if (!downloadArtifact(artifact, m_installedManifest, temp)) {
+                logError("Failed to download asset: " + entry->path);
+                return false;
+            }
+            if (!entry->digest.empty() && !verifyDigest(temp, entry->digest)) {
+                DeleteFileA(temp.c_str());
+                return false;
+            }
+
+            ApplyJournal journal(installDir, m_durability);
+            if (!journal.apply(std::vector<ApplyJournal::Replacement>{ApplyJournal::Replacement{temp, relative}},
+                               "asset " + entry->path)) {
+                logError("Failed to install asset: " + journal.lastError());
+                DeleteFileA(temp.c_str());
+                return false;
+            }
+        }
+
+        m_ensuredAssets.insert(key);
+        return true;
+    }
+
+    /**
+     * @brief Finishes or undoes an update interrupted by a crash or power loss
+     * @return true if the install is consistent
+     */
+    bool recoverInterruptedUpdate() const {
+        const std::string currentExePath = getCurrentExecutablePath();
+        ApplyJournal journal(currentExePath.substr(0, currentExePath.find_last_of("\\/")));
+        if (!journal.needsRecovery()) {
+            return true;
+        }
+
+        logInfo("Recovering interrupted update...");
+        if (!journal.recover()) {
+            logError("Recovery failed: " + journal.lastError());
+            return false;
+        }
+        logInfo("Recovery completed");
+        return true;
+    }
+
+    /**
+     * @brief Restores the install directory from the snapshot taken before an update
+     * @param version Version to go back to, i.e. the version that was replaced
+     * @return true if the files were restored; restart the application to run them
+     */
+    bool rollback(const std::string& version) const {
+        const std::string currentExePath = getCurrentExecutablePath();
+        const std::string installDir = currentExePath.substr(0, currentExePath.find_last_of("\\/"));
+
+        logInfo("Rolling back to version " + version + "...");
+        std::string error;
+        if (!RollbackSnapshot::restore(RollbackSnapshot::path(installDir, version), installDir, error)) {
+            logError("Rollback failed: " + error);
             return false;
         }
+        logInfo("Rollback completed");
+        return true;
+    }
+
+    /**
+     * @brief Measures this version's performance and rolls back a regressed update
+     * @param currentVersion Current application version
+     * @return false if the version regressed; the previous version is then
+     *         restored and the application restarts into it
+     *
+     * Call once the application is warmed up, in every version. Each call
+     * records the measurement for currentVersion. The first call after an
+     * update also compares it with the value recorded for the version that
+     * was replaced. If the new version is slower than the policy's tolerance
+     * allows, the install is rolled back from the snapshot, the version is
+     * never installed again, and the reason is kept for
+     * lastCanaryReport(). Does nothing without a CanaryPolicy.
+     */
+    bool runCanary(const std::string& currentVersion) const {
+        if (!m_canary.measure) {
+            return true;
+        }
+        const double measured = PerformanceHistory::measure(m_canary);
+        std::lock_guard<std::mutex> lock(m_historyMutex);
+        PerformanceHistory history(performanceHistoryPath());
+        const std::string previous = history.pendingFrom(currentVersion);
+        double baseline = 0;
+        if (!previous.empty() && history.value(previous, baseline)) {
+            std::string reason;
+            if (PerformanceHistory::regressed(baseline, measured, m_canary, reason)) {
+                const std::string report = "Version " + currentVersion + " regressed against " + previous + ": " + reason;
+                logError(report);
+                history.reject(currentVersion, report);
+                history.clearPending();
+                history.save();
+                if (!rollback(previous)) {
+                    return false;
+                }
+                restartApplication(getCurrentExecutablePath());
+                return false;
+            }
+            logInfo("Performance canary passed: " + reason);
+        }
+        history.setValue(currentVersion, measured);
+        history.clearPending();
+        if (!history.save()) {
+            logError("Failed to save performance history: " + performanceHistoryPath());
+        }
+        return true;
+    }
+
+    /**
+     * @brief Describes the last regression that caused an automatic rollback
+     * @return Report, or an empty string if no version has been rolled back
+     */
+    std::string lastCanaryReport() const {
+        std::lock_guard<std::mutex> lock(m_historyMutex);
+        return PerformanceHistory(performanceHistoryPath()).lastReport();
+    }
+
+    /**
+     * @brief Records that this run finished starting up
+     * @param currentVersion Current application version
+     *
+     * Call once, when the application is ready for work. The time since the
+     * process was created is added to the version's start-up mean. Five
+     * minutes later pollForUpdates() samples the working set as the
+     * version's steady-state memory; applications that do not poll can call
+     * recordSteadyState() themselves.
+     */
+    void markReady(const std::string& currentVersion) {
+        FILETIME created, exited, kernel, user, now;
+        if (!GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user)) {
+            logError("Failed to read the process start time");
+            return;
+        }
+        GetSystemTimeAsFileTime(&now);
+        const uint64_t start = (static_cast<uint64_t>(created.dwHighDateTime) << 32) | created.dwLowDateTime;
+        const uint64_t end = (static_cast<uint64_t>(now.dwHighDateTime) << 32) | now.dwLowDateTime;
+        const double milliseconds = end > start ? static_cast<double>(end - start) / 10000 : 0; // FILETIME counts 100 ns
+
+        std::lock_guard<std::mutex> lock(m_historyMutex);
+        PerformanceHistory history(performanceHistoryPath());
+        history.recordStartup(currentVersion, milliseconds);
+        if (!history.save()) {
+            logError("Failed to save performance history: " + performanceHistoryPath());
+        }
+        m_readyVersion = currentVersion;
+        m_readyTick = GetTickCount64();
+    }
+
+    /**
+     * @brief Records the current working set as the steady-state memory of the version
+     *
+     * Does nothing before markReady() or once the sample of this run was taken.
+     */
+    void recordSteadyState() {
+        PROCESS_MEMORY_COUNTERS counters = {};
+        counters.cb = sizeof(counters);
+        if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(m_historyMutex);
+        if (m_readyVersion.empty()) {
+            return;
+        }
+        PerformanceHistory history(performanceHistoryPath());
+        history.recordResident(m_readyVersion, counters.WorkingSetSize);
+        if (!history.save()) {
+            logError("Failed to save performance history: " + performanceHistoryPath());
+        }
+        m_readyVersion.clear();
+    }
+
+    /**
+     * @brief Renders start-up time, memory and canary results per version
+     * @return Prometheus text exposition format, ready to serve on a metrics endpoint
+     */
+    std::string metricsText() const {
+        std::lock_guard<std::mutex> lock(m_historyMutex);
+        return PerformanceHistory(performanceHistoryPath()).metricsText();
+    }
+
+    /**
+     * @brief Sets the performance check run by runCanary()
+     * @param policy Measurement, direction and tolerance
+     *
+     * Requires rollback snapshots (see setRollbackEnabled()).
+     */
+    void setCanaryPolicy(const CanaryPolicy& policy) {
+        m_canary = policy;
+    }
 
+    /**
+     * @brief Publishes the update status for other local processes
+     * @param name Board name; readers open it with StatusBoard::open(name)
+     * @param currentVersion Current application version, published until the first check
+     * @return false if the shared-memory segment could not be created
+     *
+     * Call once before checking for updates. Other processes of the same
+     * session, such as a tray icon or a second instance, then read the
+     * state, target version, download progress and time of the last check
+     * without contacting the server; see StatusBoard.h.
+     */
+    bool enableStatusBoard(const std::string& name, const std::string& currentVersion) {
+        if (!m_statusBoard.create(name)) {
+            logError("Failed to create the update status board: " + name);
+            return false;
+        }
+        m_currentVersion = currentVersion;
+        publishStatus(UpdateState::Idle, std::string());
         return true;
     }
 
+    /**
+     * @brief Sets how far staged files are flushed to stable storage
+     * @param durability Durability::FlushAtEnd (the default) flushes each
+     *                   downloaded file once, and every staged file before the
+     *                   install journal renames it. Durability::Ordered also
+     *                   downloads to "<file>.part" and renames it into place, so
+     *                   a crash never leaves a torn file under the final name.
+     *                   Durability::None leaves write-back to the operating
+     *                   system; a power loss during an install can then
+     *                   leave a damaged executable.
+     *
+     * Ranged downloads honour the same level: their checkpoint batches flush
+     * the file first unless the level is None, and Ordered assembles them in
+     * "<file>.part". See Durability.h and Download.h.
+     */
+    void setDurability(Durability durability) {
+        m_durability = durability;
+    }
+
+    /**
+     * @brief Enables or disables rollback snapshots before updates
+     * @param enabled false to skip snapshots and remove existing ones
+     */
+    void setRollbackEnabled(bool enabled) {
+        m_keepRollback = enabled;
+    }
+
+    /**
+     * @brief Makes updates wait for low application load before restarting
+     * @param policy Load callback, threshold and maximum deferral
+     *
+     * After an update is downloaded and verified, the load callback is
+     * sampled every sampleIntervalMs. The application restarts once the load
+     * has stayed at or below the threshold for quietMs, or once the update
+     * has been held for maxDeferralMs. The wait blocks the checking thread,
+     * so combine it with pollForUpdates() on a background thread. The
+     * callback runs on that thread and must be thread-safe.
+     */
+    void setApplyPolicy(const ApplyPolicy& policy) {
+        m_applyPolicy = policy;
+    }
+
+    /**
+     * @brief Restricts downloads and restarts to maintenance windows
+     * @param windows Download, full-bandwidth and restart windows; see Maintenance.h
+     *
+     * A check outside the download window only records the update as
+     * pending (see pendingUpdate()). Outside the full-bandwidth window,
+     * downloads use one connection throttled to throttledBytesPerSecond; the
+     * rate is chosen when each download starts. A staged update restarts
+     * the application only inside the restart window. checkForUpdate()
+     * cannot wait for that window, so outside it the update is recorded as
+     * pending without being downloaded; pollForUpdates() downloads it and
+     * holds it until the window opens.
+     */
+    void setMaintenanceWindows(const WindowPolicy& windows) {
+        m_windows = windows;
+    }
+
+    /**
+     * @brief Gets the version of an update held back by the maintenance windows
+     * @return Pending version, or an empty string if none is waiting
+     */
+    std::string pendingUpdate() const {
+        std::lock_guard<std::mutex> lock(m_pendingMutex);
+        return m_pendingVersion;
+    }
+
     /**
      * @brief Sets a custom temporary directory for update operations
      * @param tempDir Custom temporary directory path
@@ -383,6 +2220,23 @@ inline bool checkForUpdates(const std::string& version, const std::string& confi
     }
 }
 
+/**
+ * @brief Starts connecting to the update server ahead of checkForUpdates()
+ * @param configUrl Optional custom config URL (uses default if empty)
+ *
+ * @example
+ * ```cpp
+ * int main() {
+ *     prepareUpdates();          // Returns immediately
+ *     loadSettings();            // Overlaps with DNS and the TLS handshake
+ *     checkForUpdates("1.0.0");  // Reuses the warm connection
+ * }
+ * ```
+ */
+inline void prepareUpdates(const std::string& configUrl = "") {
+    AutoUpdaterLib::InternetSession::instance().prepare(configUrl.empty() ? AUTO_UPDATER_CONFIG_URL : configUrl);
+}
+
 // Legacy compatibility function
 inline bool Updated(const std::string& version) {
     return checkForUpdates(version);
@@ -0,0 +1,102 @@
+/**
+ * @file Varint.h
+ * @brief LEB128 variable-length integer helpers shared by the binary formats
+ *
+ * @author myexistences
+ * @copyright Copyright (c) 2025 myexistences. All rights reserved.
+ * @license MIT License
+ */
+
+#ifndef AUTO_UPDATER_VARINT_H
+#define AUTO_UPDATER_VARINT_H
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+
+namespace AutoUpdaterLib {
+
+/**
+ * @class Varint
+ * @brief Reads and writes unsigned LEB128 and zigzag-encoded signed varints
+ */
+class Varint {
+public:
+    /**
+     * @brief Writes an unsigned LEB128 varint
+     */
+    static void write(std::ostream& out, uint64_t value) {
+        while (value >= 0x80) {
+            out.put(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        out.put(static_cast<char>(value));
+    }
+
+    /**
+     * @brief Writes a zigzag-encoded signed varint
+     */
+    static void writeSigned(std::ostream& out, int64_t value) {
+        write(out, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+    }
+
+    /**
+     * @brief Writes a length-prefixed string
+     */
+    static void writeString(std::ostream& out, const std::string& value) {
+        write(out, value.size());
+        out.write(value.data(), static_cast<std::streamsize>(value.size()));
+    }
+
+    /**
+     * @brief Reads an unsigned LEB128 varint
+     * @param in Stream positioned at the varint
+     * @param value Receives the decoded value
+     * @return true on success, false on truncated or oversized input
+     */
+    static bool read(std::istream& in, uint64_t& value) {
+        value = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7) {
+            const int c = in.get();
+            if (c == std::char_traits<char>::eof()) {
+                return false;
+            }
+            value |= static_cast<uint64_t>(c & 0x7F) << shift;
+            if ((c & 0x80) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Reads a zigzag-encoded signed varint
+     */
+    static bool readSigned(std::istream& in, int64_t& value) {
+        uint64_t raw = 0;
+        if (!read(in, raw)) {
+            return false;
+        }
+        value = static_cast<int64_t>(raw >> 1) ^ -static_cast<int64_t>(raw & 1);
+        return true;
+    }
+
+    /**
+     * @brief Reads a length-prefixed string
+     * @param maxLength Largest length accepted, guarding against corrupt input
+     */
+    static bool readString(std::istream& in, std::string& value, uint64_t maxLength = 1 << 20) {
+        uint64_t length = 0;
+        if (!read(in, length) || length > maxLength) {
+            return false;
+        }
+        value.resize(static_cast<size_t>(length));
+        in.read(&value[0], static_cast<std::streamsize>(length));
+        return static_cast<uint64_t>(in.gcount()) == length;
+    }
+};
+
+} // namespace AutoUpdaterLib
+
+#endif // AUTO_UPDATER_VARINT_H
@@ -0,0 +1,339 @@
+/**
+ * @file VersionIndex.h
+ * @brief Compact index of installed component versions for catalog diffs
+ *
+ * @author myexistences
+ * @copyright Copyright (c) 2025 myexistences. All rights reserved.
+ * @license MIT License
+ *
+ * @description
+ * A daemon that keeps many applications up to date compares its installed
+ * versions against every fresh catalog it downloads. VersionIndex keeps
+ * that comparison cheap:
+ *
+ * - component names and pre-release tags are interned once into a single
+ *   string pool and referenced by offset;
+ * - versions are parsed once into fixed-size keys stored in a flat array
+ *   parallel to the names;
+ * - entries are kept sorted by name, so a lookup is a binary search and a
+ *   full diff of two indexes is one linear merge with no allocation beyond
+ *   the result.
+ *
+ * @catalog_format
+ * ```json
+ * { "Components": { "editor": "2.4.1", "renderer": "1.9.0-rc.2" } }
+ * ```
+ *
+ * @version_ordering
+ * A version is up to four dot-separated numbers, optionally prefixed with
+ * 'v' ("v1.2", "1.2.0.15"). Missing numbers count as zero. A suffix
+ * starting with '-' marks a pre-release, which sorts before the release
+ * with the same numbers; pre-release tags are compared as plain strings.
+ * Build metadata after '+' is ignored.
+ */
+
+#ifndef AUTO_UPDATER_VERSION_INDEX_H
+#define AUTO_UPDATER_VERSION_INDEX_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+#include "json.hpp" // nlohmann::json library
+
+namespace AutoUpdaterLib {
+
+/**
+ * @class VersionIndex
+ * @brief Sorted, interned name-to-version table
+ */
+class VersionIndex {
+public:
+    static constexpr size_t MAX_PARTS = 4;
+
+    /**
+     * @struct Change
+     * @brief One difference found by diff(); indexes refer to either side
+     */
+    struct Change {
+        enum class Kind { Added, Upgraded, Downgraded, Removed };
+
+        Kind kind;
+        uint32_t installed;   ///< Entry in the installed index; unused for Added
+        uint32_t available;   ///< Entry in the catalog index; unused for Removed
+    };
+
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    /**
+     * @brief Builds an index from name/version pairs
+     * @param entries Components in any order; for duplicate names the last one wins
+     */
+    void assign(const std::vector<std::pair<std::string, std::string>>& entries) {
+        clear();
+        std::vector<uint32_t> order(entries.size());
+        for (uint32_t i = 0; i < order.size(); ++i) {
+            order[i] = i;
+        }
+        std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return entries[a].first < entries[b].first;
+        });
+
+        m_names.reserve(entries.size());
+        m_keys.reserve(entries.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            const auto& entry = entries[order[i]];
+            if (i + 1 < order.size() && entries[order[i + 1]].first == entry.first) {
+                continue; // A later duplicate replaces this one
+            }
+            m_names.push_back(intern(entry.first));
+            m_keys.push_back(parse(entry.second));
+        }
+    }
+
+    /**
+     * @brief Builds an index from a catalog document
+     * @param json Catalog with a "Components" object mapping names to versions
+     * @param index Receives the index
+     * @param error Receives a description when parsing fails
+     * @return true if the catalog was well-formed
+     */
+    static bool fromJson(const nlohmann::json& json, VersionIndex& index, std::string& error) {
+        if (!json.is_object() || !json.contains("Components") || !json["Components"].is_object()) {
+            error = "Catalog has no Components object";
+            return false;
+        }
+        std::vector<std::pair<std::string, std::string>> entries;
+        entries.reserve(json["Components"].size());
+        try {
+            for (auto it = json["Components"].begin(); it != json["Components"].end(); ++it) {
+                entries.emplace_back(it.key(), it.value().get<std::string>());
+            }
+        } catch (const std::exception& e) {
+            error = std::string("Invalid catalog: ") + e.what();
+            return false;
+        }
+        index.assign(entries);
+        return true;
+    }
+
+    /**
+     * @brief Sets the version of one component, adding it if needed
+     *
+     * Keeps the index sorted; intended for recording single installs.
+     */
+    void set(const std::string& name, const std::string& version) {
+        const uint32_t position = lowerBound(name.data(), name.size());
+        if (position < m_names.size() && equals(m_names[position], name.data(), name.size())) {
+            m_keys[position] = parse(version);
+            return;
+        }
+        m_names.insert(m_names.begin() + position, intern(name));
+        m_keys.insert(m_keys.begin() + position, parse(version));
+    }
+
+    /**
+     * @brief Finds a component by name
+     * @return Entry index, or NONE if the component is not listed
+     */
+    uint32_t find(const std::string& name) const {
+        const uint32_t position = lowerBound(name.data(), name.size());
+        return position < m_names.size() && equals(m_names[position], name.data(), name.size()) ? position : static_cast<uint32_t>(NONE);
+    }
+
+    /**
+     * @brief Compares this index, taken as installed, with a catalog
+     * @param catalog Latest available versions
+     * @param changes Receives every component whose version differs, in name order
+     *
+     * Components only in the catalog are Added and components only in this
+     * index are Removed. Linear in the size of both indexes.
+     */
+    void diff(const VersionIndex& catalog, std::vector<Change>& changes) const {
+        changes.clear();
+        uint32_t i = 0;
+        uint32_t j = 0;
+        const uint32_t installedCount = static_cast<uint32_t>(m_names.size());
+        const uint32_t availableCount = static_cast<uint32_t>(catalog.m_names.size());
+        while (i < installedCount || j < availableCount) {
+            int order;
+            if (i == installedCount) {
+                order = 1;
+            } else if (j == availableCount) {
+                order = -1;
+            } else {
+                order = compareText(m_pool, m_names[i], catalog.m_pool, catalog.m_names[j]);
+            }
+
+            if (order < 0) {
+                changes.push_back(Change{Change::Kind::Removed, i++, NONE});
+            } else if (order > 0) {
+                changes.push_back(Change{Change::Kind::Added, NONE, j++});
+            } else {
+                const int version = compare(m_keys[i], m_pool, catalog.m_keys[j], catalog.m_pool);
+                if (version != 0) {
+                    changes.push_back(Change{version < 0 ? Change::Kind::Upgraded : Change::Kind::Downgraded, i, j});
+                }
+                ++i;
+                ++j;
+            }
+        }
+    }
+
+    /**
+     * @brief Compares two version strings using the index's ordering
+     * @return Negative, zero or positive as a is older than, equal to or newer than b
+     */
+    static int compareVersions(const std::string& a, const std::string& b) {
+        VersionIndex scratch;
+        const Key left = scratch.parse(a);
+        const Key right = scratch.parse(b);
+        return compare(left, scratch.m_pool, right, scratch.m_pool);
+    }
+
+    size_t size() const { return m_names.size(); }
+
+    std::string name(uint32_t entry) const { return text(m_names[entry]); }
+
+    /**
+     * @brief Formats an entry's version in canonical form, e.g. "1.2.0.0-rc.1"
+     */
+    std::string version(uint32_t entry) const {
+        const Key& key = m_keys[entry];
+        std::string result;
+        for (size_t i = 0; i < MAX_PARTS; ++i) {
+            if (i > 0) {
+                result += '.';
+            }
+            result += std::to_string(part(key, i));
+        }
+        if (key.tag.length > 0) {
+            result += '-' + text(key.tag);
+        }
+        return result;
+    }
+
+    void clear() {
+        m_pool.clear();
+        m_names.clear();
+        m_keys.clear();
+    }
+
+private:
+    /**
+     * @struct Text
+     * @brief Slice of the string pool
+     */
+    struct Text {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    /**
+     * @struct Key
+     * @brief Pre-parsed version; numbers packed two per word so most compares are two integer compares
+     */
+    struct Key {
+        uint64_t high;   ///< parts[0] << 32 | parts[1]
+        uint64_t low;    ///< parts[2] << 32 | parts[3]
+        Text tag;        ///< Pre-release tag; empty for a release
+    };
+
+    std::string m_pool;            // Interned names and tags, back to back
+    std::vector<Text> m_names;     // Sorted by name
+    std::vector<Key> m_keys;       // Parallel to m_names
+
+    Text intern(const std::string& value) {
+        Text result{static_cast<uint32_t>(m_pool.size()), static_cast<uint32_t>(value.size())};
+        m_pool += value;
+        return result;
+    }
+
+    std::string text(const Text& slice) const {
+        return m_pool.substr(slice.offset, slice.length);
+    }
+
+    static uint32_t part(const Key& key, size_t i) {
+        const uint64_t word = i < 2 ? key.high : key.low;
+        return static_cast<uint32_t>(i % 2 == 0 ? word >> 32 : word);
+    }
+
+    Key parse(const std::string& version) {
+        uint32_t parts[MAX_PARTS] = {0, 0, 0, 0};
+        size_t position = !version.empty() && (version[0] == 'v' || version[0] == 'V') ? 1 : 0;
+        for (size_t i = 0; i < static_cast<size_t>(MAX_PARTS) && position < version.size(); ++i) {
+            uint64_t value = 0;
+            while (position < version.size() && version[position] >= '0' && version[position] <= '9') {
+                value = std::min<uint64_t>(value * 10 + static_cast<uint64_t>(version[position] - '0'), UINT32_MAX);
+                ++position;
+            }
+            parts[i] = static_cast<uint32_t>(value);
+            if (position >= version.size() || version[position] != '.') {
+                break;
+            }
+            ++position;
+        }
+
+        Key key;
+        key.high = (static_cast<uint64_t>(parts[0]) << 32) | parts[1];
+        key.low = (static_cast<uint64_t>(parts[2]) << 32) | parts[3];
+        key.tag = Text{0, 0};
+        if (position < version.size() && version[position] == '-') {
+            const size_t end = version.find('+', position);
+            key.tag = intern(version.substr(position + 1, end == std::string::npos ? std::string::npos : end - position - 1));
+        }
+        return key;
+    }
+
+    static int compareText(const std::string& leftPool, const Text& left, const std::string& rightPool, const Text& right) {
+        const int order = std::memcmp(leftPool.data() + left.offset, rightPool.data() + right.offset,
+                                      std::min(left.length, right.length));
+        if (order != 0) {
+            return order;
+        }
+        return left.length < right.length ? -1 : (left.length > right.length ? 1 : 0);
+    }
+
+    static int compare(const Key& left, const std::string& leftPool, const Key& right, const std::string& rightPool) {
+        if (left.high != right.high) {
+            return left.high < right.high ? -1 : 1;
+        }
+        if (left.low != right.low) {
+            return left.low < right.low ? -1 : 1;
+        }
+        if (left.tag.length == 0 || right.tag.length == 0) {
+            // A release sorts after any pre-release of the same numbers
+            return left.tag.length == right.tag.length ? 0 : (left.tag.length == 0 ? 1 : -1);
+        }
+        return compareText(leftPool, left.tag, rightPool, right.tag);
+    }
+
+    bool equals(const Text& slice, const char* value, size_t length) const {
+        return slice.length == length && std::memcmp(m_pool.data() + slice.offset, value, length) == 0;
+    }
+
+    uint32_t lowerBound(const char* value, size_t length) const {
+        uint32_t low = 0;
+        uint32_t high = static_cast<uint32_t>(m_names.size());
+        while (low < high) {
+            const uint32_t middle = low + (high - low) / 2;
+            const Text& slice = m_names[middle];
+            int order = std::memcmp(m_pool.data() + slice.offset, value, std::min<size_t>(slice.length, length));
+            if (order == 0) {
+                order = slice.length < length ? -1 : (slice.length > length ? 1 : 0);
+            }
+            if (order < 0) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        return low;
+    }
+};
+
+} // namespace AutoUpdaterLib
+
+#endif // AUTO_UPDATER_VERSION_INDEX_H
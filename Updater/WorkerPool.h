@@ -0,0 +1,145 @@
+/**
+ * @file WorkerPool.h
+ * @brief Fixed-size thread pool for background updater work
+ *
+ * @author myexistences
+ * @copyright Copyright (c) 2025 myexistences. All rights reserved.
+ * @license MIT License
+ */
+
+#ifndef AUTO_UPDATER_WORKER_POOL_H
+#define AUTO_UPDATER_WORKER_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace AutoUpdaterLib {
+
+/**
+ * @class WorkerPool
+ * @brief Runs queued jobs on a fixed set of threads
+ *
+ * Each job declares a weight (typically the bytes it holds in memory).
+ * submit() blocks while the queued weight exceeds the pool's budget, which
+ * gives a fast producer, such as a download, back-pressure instead of
+ * letting buffered work grow without bound.
+ */
+class WorkerPool {
+private:
+    struct Job {
+        std::function<void()> run;
+        size_t weight;
+    };
+
+    std::vector<std::thread> m_threads;
+    std::deque<Job> m_queue;
+    std::mutex m_mutex;
+    std::condition_variable m_workAvailable;
+    std::condition_variable m_stateChanged;
+    size_t m_pendingWeight = 0;
+    size_t m_weightBudget;
+    size_t m_active = 0;
+    bool m_stopping = false;
+
+    void workerLoop() {
+        for (;;) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_workAvailable.wait(lock, [this] { return m_stopping || !m_queue.empty(); });
+                if (m_queue.empty()) {
+                    return;
+                }
+                job = std::move(m_queue.front());
+                m_queue.pop_front();
+                ++m_active;
+            }
+
+            job.run();
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                --m_active;
+                m_pendingWeight -= job.weight;
+            }
+            m_stateChanged.notify_all();
+        }
+    }
+
+public:
+    /**
+     * @brief Starts the worker threads
+     * @param threads Number of threads, or 0 to use every hardware thread
+     * @param weightBudget Queued-plus-running weight above which submit() blocks
+     */
+    explicit WorkerPool(unsigned threads = 0, size_t weightBudget = static_cast<size_t>(-1))
+        : m_weightBudget(weightBudget) {
+        if (threads == 0) {
+            threads = std::thread::hardware_concurrency();
+        }
+        if (threads == 0) {
+            threads = 1;
+        }
+        for (unsigned i = 0; i < threads; ++i) {
+            m_threads.emplace_back(&WorkerPool::workerLoop, this);
+        }
+    }
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_workAvailable.notify_all();
+        for (auto& thread : m_threads) {
+            thread.join();
+        }
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    /**
+     * @brief Queues a job, waiting for budget if the pool is saturated
+     * @param job Work to run on a pool thread
+     * @param weight Budget units the job holds until it finishes
+     *
+     * A job heavier than the whole budget is still accepted once the pool
+     * is otherwise idle, so oversized jobs cannot deadlock the producer.
+     */
+    void submit(std::function<void()> job, size_t weight = 0) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_stateChanged.wait(lock, [this, weight] {
+                return m_pendingWeight == 0 || m_pendingWeight + weight <= m_weightBudget;
+            });
+            m_pendingWeight += weight;
+            m_queue.push_back(Job{std::move(job), weight});
+        }
+        m_workAvailable.notify_one();
+    }
+
+    /**
+     * @brief Blocks until every submitted job has finished
+     */
+    void wait() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_stateChanged.wait(lock, [this] { return m_queue.empty() && m_active == 0; });
+    }
+
+    /**
+     * @brief Number of worker threads
+     */
+    size_t size() const {
+        return m_threads.size();
+    }
+};
+
+} // namespace AutoUpdaterLib
+
+#endif // AUTO_UPDATER_WORKER_POOL_H